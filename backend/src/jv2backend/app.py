@@ -13,6 +13,9 @@ import jv2backend.routes.server
 import jv2backend.main.library
 import jv2backend.main.generator
 import jv2backend.main.userCache
+import jv2backend.main.nexusIndex
+import jv2backend.main.detectorHealth
+import jv2backend.main.searcher
 import jv2backend.classes.collection
 import xml.etree.ElementTree as ElementTree
 import argparse
@@ -32,21 +35,24 @@ def create_app(activate_cache: bool = True) -> Flask:
     journal_generator = jv2backend.main.generator.JournalGenerator()
     journal_library = jv2backend.main.library.JournalLibrary({})
     journal_acquirer = jv2backend.classes.collection.JournalAcquirer()
+    detector_health_scanner = jv2backend.main.detectorHealth.DetectorHealthScanner()
+    journal_searcher = jv2backend.main.searcher.JournalSearcher()
 
     # Register Flask routes
     jv2backend.routes.server.add_routes(app, journal_generator)
-    jv2backend.routes.journal.add_routes(app, journal_library)
+    jv2backend.routes.journal.add_routes(app, journal_library, journal_searcher)
     jv2backend.routes.acquisition.add_routes(app, journal_acquirer, journal_library)
     jv2backend.routes.generate.add_routes(app, journal_generator, journal_library)
-    jv2backend.routes.nexus.add_routes(app, journal_library)
+    jv2backend.routes.nexus.add_routes(app, journal_library, detector_health_scanner)
 
     # Register XML namespaces
     ElementTree.register_namespace( '', "http://definition.nexusformat.org/schema/3.0")
     ElementTree.register_namespace('xsi', "http://www.w3.org/2001/XMLSchema-instance")
 
-    # Initialise and activate the user data cache
+    # Initialise and activate the user data cache and NeXus metadata index
     if activate_cache:
         jv2backend.main.userCache.initialise()
+        jv2backend.main.nexusIndex.initialise()
 
     return app
 
@@ -6,15 +6,17 @@ import typing
 import datetime
 from io import BytesIO
 from jv2backend.utils import url_join, lm_to_datetime
-import jv2backend.main.selector
 from jv2backend.classes.journal import Journal, SourceType
+from jv2backend.classes.runRangeIndex import RunRangeIndex
+from jv2backend.classes.searchIndex import SearchIndex
+import jv2backend.main.selector
 import jv2backend.main.userCache
 import xml.etree.ElementTree as ElementTree
 import logging
 import json
 import requests
-import functools
 import lxml.etree as etree
+from contextlib import contextmanager
 from threading import Thread, Event, Lock
 
 
@@ -25,6 +27,9 @@ _ACQUISITION_THREAD_COMPLETE_MUTEX = Lock()
 _ACQUISITION_THREAD_NUM_COMPLETED_MUTEX = Lock()
 _ACQUISITION_THREAD_LAST_FILENAME_MUTEX = Lock()
 
+# Data name under which the run range index of a collection is cached
+RUN_RANGE_INDEX_NAME = "runRangeIndex"
+
 
 class JournalCollection:
     """Defines a collection of journal files relating to a specific instrument,
@@ -45,11 +50,29 @@ class JournalCollection:
         self._run_data_url = run_data_url
         self._last_modified = last_modified
         self._journals = [] if journals is None else journals
+        self._journals_by_filename: typing.Dict[str, Journal] = {}
+        # Journals containing each data filename (without path), for those
+        # journals whose run data have been loaded
+        self._data_file_journals: typing.Dict[str, Journal] = {}
+        # Search index over the runs of all loaded journals
+        self._search_index = SearchIndex()
+        # Journals may be loaded (and so indexed) by several threads at once
+        self._index_lock = Lock()
+        # Number of batches of journal loads in progress, during which the
+        # run range index is only stored once all have finished
+        self._index_batches = 0
+        self._run_ranges_changed = False
+
+        self._expect_cached_data([self._index_filename] + [journal.filename for journal in self._journals])
+
+        # Index of the run number ranges in each journal, retained between
+        # sessions so that runs can be located without loading journals
+        self._run_ranges = self._load_run_ranges()
+        for journal in self._journals:
+            self._watch_journal(journal)
 
     def __getitem__(self, filename: str):
-        return next(
-            (j for j in self._journals if j.filename == filename),
-            None)
+        return self._journals_by_filename.get(filename)
 
     def __contains__(self, key):
         j = self.__getitem__(key)
@@ -84,7 +107,9 @@ class JournalCollection:
             {} if run_data is None else run_data
         )
 
+        self._expect_cached_data([journal_filename])
         self._journals.append(journal)
+        self._watch_journal(journal)
         return journal
 
     @property
@@ -98,8 +123,15 @@ class JournalCollection:
 
     # ---------------- Data Handling
 
+    def _expect_cached_data(self, data_names: typing.List[str]) -> None:
+        """Declare data which the user cache may hold for the collection, so
+        that any stored by earlier versions of the cache can be found"""
+        if self._library_key is not None:
+            jv2backend.main.userCache.expect_data(self._library_key, [name for name in data_names if name])
+
     def _update_journals(self, data: {}):
         """Update journal information from supplied dict"""
+        self._expect_cached_data([j["filename"] for j in data if j["filename"] not in self])
         for j in data:
             logging.debug(f"Processing index entry {j['filename']}...")
 
@@ -109,14 +141,16 @@ class JournalCollection:
                 continue
 
             # Create a new journal entry
-            self._journals.append(Journal(
+            journal = Journal(
                 j["display_name"],
                 self._source_type,
                 self._library_key,
                 self._index_root_url,
                 j["filename"],
                 j["data_directory"]
-            ))
+            )
+            self._journals.append(journal)
+            self._watch_journal(journal)
 
     def is_up_to_date(self) -> bool:
         """Get the modification time of the index from its root source and
@@ -324,16 +358,9 @@ class JournalCollection:
         if self._source_type is not SourceType.Network:
             return 0
 
-        # Network type so check the cache for each
-        return functools.reduce(
-            lambda x, y:
-            x + (1 if not jv2backend.main.userCache.has_data(
-                    self._library_key,
-                    y.filename
-                    )
-                 else 0),
-            self._journals, 0
-        )
+        # Network type so check the cache manifest for each
+        return jv2backend.main.userCache.count_missing(self._library_key,
+                                                       (jf.filename for jf in self._journals))
 
     # ---------------- File Location
 
@@ -360,61 +387,54 @@ class JournalCollection:
         """Find the journal in the collection that contains the specified run
         number.
 
+        The run range index is consulted first, so journals are only loaded
+        if the run is not in a journal whose ranges are already known.
         :param run_number: Run number to locate
         :return: Journal containing the run number, or None if not found
         """
-        # For network sources we can (most likely) assume that the journals
-        # are organised chronologically with sequential run numbers. However,
-        # for generated journals there is no such guarantee. However, in the
-        # latter case load times a very quick since we have all information in
-        # the user cache, so just try to load everything.
+        filename = self._run_ranges.find(run_number)
+        if filename is not None:
+            journal = self[filename]
+            if journal is not None:
+                return journal
+
+        # For generated journals there is no guarantee of any ordering, so
+        # load (and so index) every journal we don't yet know about before
+        # consulting the index again
         if self._source_type is not SourceType.Network:
-            for jf in self._journals:
-                jf.get_run_data()
-                if run_number in jf:
-                    return jf
-            return None
+            with self.batched_index_writes():
+                for jf in self._journals:
+                    if jf.filename not in self._run_ranges:
+                        jf.get_run_data()
+            return self._indexed_journal_for_run(run_number)
 
-        # Try a quick scan over loaded journals which have run number info
-        journal = next(
-            (jf for jf in self._journals if run_number in jf),
-            None)
-        if journal is not None:
-            return journal
-
-        # Not in an existing loaded journal, so determine list index limits
-        # for where the requested run is
-        left = 0
-        last_index = len(self._journals) - 1
-        right = last_index
-
-        while left != right:
-            # Get our best limits
-            for n in range(0, last_index + 1):
-                # Leftmost limit
-                if self._journals[n].has_run_data():
-                    logging.debug(f"Journal at {n} has runs from {self._journals[n].get_first_run_number()} to {self._journals[n].get_last_run_number()}")
-                    if self._journals[n].get_first_run_number() <= run_number:
-                        left = n
-
-                # Rightmost limit (working backwards)
-                if self._journals[-(n+1)].has_run_data():
-                    logging.debug(f"and journal at {last_index-n} has runs from {self._journals[-(n+1)].get_first_run_number()} to {self._journals[-(n+1)].get_last_run_number()}")
-                    if self._journals[-(n+1)].get_last_run_number() >= run_number:
-                        right = last_index-n
-
-            # Journal located?
-            if left == right:
-                return self._journals[left]
-
-            # Edge cases - if left == right == 0 then the run number requested
-            # is before the earliest journal available. Similarly, if both
-            # equal the last journal index, it is after our most recent data
-            if (left == right == 0) or (left == right == last_index):
-                return None
+        # For network sources we can (most likely) assume that the journals
+        # are organised chronologically with sequential run numbers, so bisect
+        # the list, loading only those journals whose ranges are not known
+        with self.batched_index_writes():
+            left = 0
+            right = len(self._journals) - 1
+            while left <= right:
+                # Find the first journal containing any runs from the centre of
+                # the current limits
+                centre = left + (right - left) // 2
+                probe = centre
+                bounds = self._journal_run_bounds(probe)
+                while bounds is None and probe < right:
+                    probe += 1
+                    bounds = self._journal_run_bounds(probe)
+
+                # If there are none the run can only be in the left half
+                if bounds is None:
+                    right = centre - 1
+                elif run_number < bounds[0]:
+                    right = centre - 1
+                elif run_number > bounds[1]:
+                    left = probe + 1
+                else:
+                    return self._indexed_journal_for_run(run_number)
 
-            # Retrieve run data for the journal at the centre of the specified range
-            self._journals[left + int((right-left)/2)].get_run_data()
+        return None
 
     def locate_data_file(self, run_number: int) -> str:
         """Return the full path to the data (NeXuS) file for the specified
@@ -430,16 +450,11 @@ class JournalCollection:
         logging.debug(f"Run number {run_number} exists in journal "
                       f"{jf.filename}")
 
-        # Get the data for the specified run number
-        data = jf.get_run(run_number)
+        # The journal may have been located from the index alone
+        if not jf.is_loaded():
+            jf.get_run_data()
 
-        # The journal entry may contain the full data_directory and filename
-        # information if we generated it. Otherwise we have to assume the
-        # stored 'data_directory' and use the 'name' attribute.
-        if "data_directory" in data and "filename" in data:
-            return url_join(data["data_directory"], data["filename"])
-        else:
-            return url_join(jf.data_directory, data["name"] + ".nxs")
+        return jf.get_data_file(run_number)
 
     def locate_data_files(
             self, run_numbers: typing.List[int]
@@ -462,64 +477,191 @@ class JournalCollection:
         and return the Journal it exists in along with the run data, or a pair
         of None for not found.
         """
-        for jf in self._journals:
-            jf.get_run_data()
-            data = jf.get_run_for_file(filename)
-            if data is not None:
-                return jf, data
+        # Only journals which have never been loaded can contain files we
+        # don't already know about, so load them only if the file is not
+        # already indexed
+        jf = self._data_file_journals.get(filename)
+        if jf is None:
+            with self.batched_index_writes():
+                for jf in self._journals:
+                    if not jf.is_loaded():
+                        jf.get_run_data()
+            jf = self._data_file_journals.get(filename)
 
-        return None, None
+        data = None if jf is None else jf.get_run_for_file(filename)
+        if data is None:
+            return None, None
+
+        return jf, data
 
     # ---------------- Search
 
+    @staticmethod
+    def parse_search_terms(search_terms: {}) -> ({}, bool):
+        """Return the search terms without the case-sensitive flag, and the
+        value of the flag"""
+        search_terms = dict(search_terms)
+        case_sensitive = search_terms.pop("caseSensitive", "false") == "true"
+        return search_terms, case_sensitive
+
+    def check_search_terms(self, search_terms: {}) -> None:
+        """
+        Check that the search terms are valid, without loading or searching
+        any journals.
+
+        :param search_terms: Dict of search field/values
+        :raises: ValueError or RuntimeError if any of the terms is invalid
+        """
+        self._search_index.plan(search_terms, [])
+
     def search(self, search_terms: {}) -> {}:
         """
         Search across all journals in the collection, selecting those which
-        match _all_ of the specified search_terms. The search terms are
-        applied sequentially in the order they appear in the dict.
+        match _all_ of the specified search_terms.
 
         :param search_terms: Dict of search field/values
         :return: A dict of runs matching the search query.
         """
-        results = {}
+        search_terms, case_sensitive = self.parse_search_terms(search_terms)
+        results = self.search_journals(self._journals, search_terms, case_sensitive)
+        logging.debug(f"Search for {search_terms} matched {len(results)} runs.")
+        return results
 
-        # See if we have a case-sensitive flag
-        case_sensitive = ("caseSensitive" in search_terms and
-                          search_terms["caseSensitive"] == "true")
-        if "caseSensitive" in search_terms:
-            del search_terms["caseSensitive"]
+    def search_journals(self, journals: typing.List[Journal], search_terms: {},
+                        case_sensitive: bool) -> {}:
+        """
+        Search the specified journals, selecting runs which match _all_ of
+        the search_terms (see search_journals_in_chunks()).
 
-        for jf in self._journals:
-            logging.debug(f"Journal {jf.filename} .....")
-            jf.get_run_data()
-            if not jf.has_run_data:
-                continue
-            matches = None
-            # Cycle over search terms
-            # If the current 'matches' is None then search the whole run data
-            # If it is not, then search it instead (chaining searches)
-            # If it is ever a size of zero we have excluded all runs
-            logging.debug("Starting loop over search terms...")
-            for field in search_terms:
-                logging.debug(f"... search '{field}' for '{search_terms[field]}'.")
-                matches = jv2backend.main.selector.select(jf.run_data if matches is None
-                                          else matches,
-                                          field,
-                                          search_terms[field],
-                                          case_sensitive)
-                logging.debug(f"...after checking '{field}' there are "
-                              f"{len(matches)} matches...")
-                if len(matches) == 0:
-                    break
+        :param journals: Journals to search
+        :param search_terms: Dict of search field/values
+        :param case_sensitive: Whether text comparisons are case sensitive
+        :return: A dict of runs matching the search query.
+        """
+        return {run_number: data
+                for chunk in self.search_journals_in_chunks(journals, search_terms, case_sensitive)
+                for run_number, data in chunk.items()}
 
-            if matches is None:
-                logging.debug(f"Journal {jf.filename} matched zero runs.")
-                continue
+    def search_journals_in_chunks(self, journals: typing.List[Journal], search_terms: {},
+                                  case_sensitive: bool) -> typing.Iterator[typing.Dict[int, typing.Dict]]:
+        """
+        Search the specified journals, selecting runs which match _all_ of
+        the search_terms. Journals not yet loaded are loaded first (unless
+        the run range index shows they cannot contain the requested run
+        numbers), and the collection's search index then answers the query
+        a chunk of matches at a time.
 
-            logging.debug(f"Journal {jf.filename} matched {len(matches)} runs.")
-            results.update(matches)
+        :param journals: Journals to search
+        :param search_terms: Dict of search field/values
+        :param case_sensitive: Whether text comparisons are case sensitive
+        :return: An iterator over dicts of runs matching the search query.
+        """
+        # Journals are added to the search index as their run data are loaded
+        run_bounds = (jv2backend.main.selector.integer_bounds(search_terms["run_number"])
+                      if "run_number" in search_terms else (None, None))
+        with self.batched_index_writes():
+            for jf in journals:
+                if jf.is_loaded():
+                    continue
+                if not self._may_contain_runs(jf, run_bounds):
+                    logging.debug(f"Journal {jf.filename} cannot contain runs {search_terms['run_number']}.")
+                    continue
+                logging.debug(f"Loading journal {jf.filename} for search...")
+                jf.get_run_data()
 
-        return results
+        return self._search_index.search_chunks(search_terms, case_sensitive,
+                                                None if journals is self._journals else
+                                                [jf.filename for jf in journals])
+
+    # ---------------- Run Range Index
+
+    def _load_run_ranges(self) -> RunRangeIndex:
+        """Return the run range index for the collection from the user
+        cache, or a new one if there is none"""
+        if self._library_key is None or not jv2backend.main.userCache.has_data(
+                self._library_key, RUN_RANGE_INDEX_NAME):
+            return RunRangeIndex()
+
+        data, _ = jv2backend.main.userCache.get_data(self._library_key, RUN_RANGE_INDEX_NAME)
+        try:
+            return RunRangeIndex.from_json(data)
+        except (ValueError, TypeError) as exc:
+            logging.warning(f"Discarding invalid run range index for "
+                            f"{self._library_key}: {str(exc)}")
+            return RunRangeIndex()
+
+    def _watch_journal(self, journal: Journal) -> None:
+        """Index the journal by filename, and keep the run range and data
+        file indices up to date with it"""
+        self._journals_by_filename[journal.filename] = journal
+        journal.set_run_ranges_listener(self._index_journal)
+        if journal.run_number_ranges:
+            self._index_journal(journal)
+
+    @contextmanager
+    def batched_index_writes(self) -> typing.Iterator[None]:
+        """Defer storing the run range index in the user cache until the
+        journals loaded within the context (by any thread) are all indexed"""
+        with self._index_lock:
+            self._index_batches += 1
+        try:
+            yield
+        finally:
+            with self._index_lock:
+                self._index_batches -= 1
+                if self._index_batches == 0 and self._run_ranges_changed:
+                    self._store_run_ranges()
+
+    def _index_journal(self, journal: Journal) -> None:
+        """Record the data files, runs and run ranges of the journal,
+        storing the run range index in the user cache if it has changed
+        and no batch of loads is in progress"""
+        with self._index_lock:
+            for filename in journal.data_filenames:
+                self._data_file_journals[filename] = journal
+            self._search_index.update(journal.filename, journal.run_data, journal.columns)
+
+            if self._run_ranges.update(journal.filename,
+                                       [(r.first, r.last) for r in journal.run_number_ranges]):
+                self._run_ranges_changed = True
+                if self._index_batches == 0:
+                    self._store_run_ranges()
+
+    def _store_run_ranges(self) -> None:
+        """Store the run range index in the user cache. Must be called with
+        the index lock held."""
+        jv2backend.main.userCache.put_data(self._library_key, RUN_RANGE_INDEX_NAME,
+                                           self._run_ranges.to_json())
+        self._run_ranges_changed = False
+
+    def _may_contain_runs(self, journal: Journal,
+                          run_bounds: typing.Optional[typing.Tuple[typing.Optional[int], typing.Optional[int]]]) -> bool:
+        """Return whether the journal may contain runs within the inclusive
+        (first, last) bounds (None if the range is invalid), according to
+        the run range index"""
+        if run_bounds is None:
+            return False
+        if journal.filename not in self._run_ranges:
+            return True
+        bounds = self._run_ranges.bounds(journal.filename)
+        first, last = run_bounds
+        return bounds is not None and (first is None or bounds[1] >= first) and (last is None or bounds[0] <= last)
+
+    def _indexed_journal_for_run(self, run_number: int) -> typing.Optional[Journal]:
+        """Return the journal which the run range index records as containing
+        the run number, or None if there is none"""
+        filename = self._run_ranges.find(run_number)
+        return None if filename is None else self[filename]
+
+    def _journal_run_bounds(self, index: int) -> typing.Optional[typing.Tuple[int, int]]:
+        """Return the first and last run numbers in the journal at the list
+        index, loading it only if its ranges are not already known"""
+        journal = self._journals[index]
+        if journal.filename not in self._run_ranges:
+            journal.get_run_data()
+            if journal.filename not in self._run_ranges:
+                return None
+        return self._run_ranges.bounds(journal.filename)
 
     # ---------------- Conversion
 
@@ -547,31 +689,33 @@ class AcquisitionThread(Thread):
 
         error = None
 
-        for j in self._collection.journals:
-            if _STOP_ACQUISITION_EVENT.is_set():
-                break
-
-            with _ACQUISITION_THREAD_NUM_COMPLETED_MUTEX:
-                self._num_completed = self._num_completed + 1
+        # Store the run range index once, when all journals are loaded
+        with self._collection.batched_index_writes():
+            for j in self._collection.journals:
+                if _STOP_ACQUISITION_EVENT.is_set():
+                    break
 
-            if j.has_run_data():
-                logging.debug(f"Skipping {j.filename} as data are present...")
-                continue
+                with _ACQUISITION_THREAD_NUM_COMPLETED_MUTEX:
+                    self._num_completed = self._num_completed + 1
 
-            logging.debug(f"Acquiring run data for {j.filename}...")
-            with _ACQUISITION_THREAD_LAST_FILENAME_MUTEX:
-                self._last_filename = j.filename
+                if j.is_loaded():
+                    logging.debug(f"Skipping {j.filename} as data are present...")
+                    continue
 
-            with _ACQUISITION_THREAD_JOURNAL_MUTEX:
-                try:
-                    j.get_run_data()
-                except (requests.HTTPError, requests.ConnectionError,
-                        FileNotFoundError) as exc:
-                    error = str(exc)
-                    break
-                except etree.XMLSyntaxError as exc:
-                    error = str(exc)
-                    break
+                logging.debug(f"Acquiring run data for {j.filename}...")
+                with _ACQUISITION_THREAD_LAST_FILENAME_MUTEX:
+                    self._last_filename = j.filename
+
+                with _ACQUISITION_THREAD_JOURNAL_MUTEX:
+                    try:
+                        j.get_run_data()
+                    except (requests.HTTPError, requests.ConnectionError,
+                            FileNotFoundError) as exc:
+                        error = str(exc)
+                        break
+                    except etree.XMLSyntaxError as exc:
+                        error = str(exc)
+                        break
 
         with _ACQUISITION_THREAD_COMPLETE_MUTEX:
             self._complete = True
@@ -26,7 +26,7 @@ class IntegerRange:
             else:
                 return cls(istart, iend)
         else:
-            return cls(int(text.strip(), int(text.strip())))
+            return cls(int(text.strip()), int(text.strip()))
 
     @property
     def first(self) -> int:
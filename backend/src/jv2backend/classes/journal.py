@@ -8,6 +8,7 @@ from typing import Optional
 from io import BytesIO
 from jv2backend.utils import url_join, lm_to_datetime
 from jv2backend.classes.integerRange import IntegerRange
+from jv2backend.classes.runColumns import RunColumns
 import jv2backend.main.userCache
 import xml.etree.ElementTree as ElementTree
 from enum import Enum
@@ -42,9 +43,15 @@ class Journal:
         self._data_directory = data_directory
         self._last_modified = last_modified
         self._run_number_ranges: typing.List[IntegerRange] = []
+        self._runs_by_data_file: typing.Dict[str, int] = {}
+        self._columns = RunColumns(None)
+        self._run_ranges_listener: typing.Optional[typing.Callable[[Journal], None]] = None
 
-        # Set the run data (also intialises ranges)
-        self._run_data = run_data
+        # Set the run data (also intialises ranges). Journals created without
+        # any runs are taken to be awaiting their run data
+        self._run_data = None
+        self.run_data = run_data
+        self._loaded = self.has_run_data()
 
     # ---------------- Basic Journal Information
 
@@ -198,16 +205,67 @@ class Journal:
         if self._run_data is None:
             return
 
-        for run_number in self._run_data:
-            rnr = next((r for r in self._run_number_ranges
-                        if r.extend(run_number)), None)
-            if not rnr:
+        # Sweep over the sorted run numbers, so that the highest run number
+        # appears in the last range
+        for run_number in sorted(self._run_data):
+            if not self._run_number_ranges or not self._run_number_ranges[-1].extend(run_number):
                 self._run_number_ranges.append(
                     IntegerRange(first=run_number, last=run_number)
                 )
 
-        # Sort the ranges so that the highest run number appears in the last one
-        self._run_number_ranges.sort(key=lambda r: r.last)
+    def __create_data_file_index(self):
+        """Create the map of data filenames to run numbers from the current
+        data"""
+        self._runs_by_data_file = {}
+
+        # If the run data is None we are done
+        if self._run_data is None:
+            return
+
+        for run_number, data in self._run_data.items():
+            filename = self.__data_filename(data)
+            if filename is not None:
+                self._runs_by_data_file[filename] = run_number
+
+    def __run_data_changed(self):
+        """Update derived information after the run data have been set"""
+        self._loaded = self._run_data is not None
+        self.__create_run_ranges()
+        self.__create_data_file_index()
+        self._columns = RunColumns(self._run_data)
+
+        if self._run_ranges_listener is not None:
+            self._run_ranges_listener(self)
+
+    @staticmethod
+    def __data_filename(data: typing.Dict) -> Optional[str]:
+        """Return the data filename (without path) for the run data, or None
+        if it cannot be determined"""
+        # The journal entry may contain the full data_directory and filename
+        # information if we generated it. Otherwise we have to assume the
+        # stored 'data_directory' and use the 'name' attribute.
+        if "data_directory" in data and "filename" in data:
+            return data["filename"]
+        elif "name" in data:
+            return data["name"] + ".nxs"
+
+        return None
+
+    def set_run_ranges_listener(self, listener: typing.Optional[typing.Callable[[Journal], None]]):
+        """Set a function to be called whenever the run ranges of the journal
+        change (i.e. when its run data are set)"""
+        self._run_ranges_listener = listener
+
+    @property
+    def run_number_ranges(self) -> typing.List[IntegerRange]:
+        """Return the contiguous ranges of run numbers in the journal"""
+        return self._run_number_ranges
+
+    @property
+    def columns(self) -> RunColumns:
+        """Return the pre-parsed run number and start time columns of the
+        run data"""
+        return self._columns
 
     def set_run_data_from_element_tree(self, treeRoot: ElementTree.Element):
         """Create run data from the supplied ElementTree data.
@@ -224,7 +282,7 @@ class Journal:
                                         else prefix + "NXentry"):
                 self.__make_run_data_entry(run, prefix)
 
-        self.__create_run_ranges()
+        self.__run_data_changed()
 
     def __contains__(self, run_number: int) -> bool:
         """Return whether the run_number exists in the journal file"""
@@ -236,6 +294,11 @@ class Journal:
         """Return whether any run data are defined"""
         return self._run_data is not None and len(self._run_data) > 0
 
+    def is_loaded(self) -> bool:
+        """Return whether the run data have been loaded, even if there are
+        no runs in the journal"""
+        return self._loaded
+
     @property
     def run_data(self):
         """Return the entire run data for the journal"""
@@ -245,7 +308,7 @@ class Journal:
     def run_data(self, run_data: {}):
         """Set run data from the supplied dictionary."""
         self._run_data = run_data
-        self.__create_run_ranges()
+        self.__run_data_changed()
 
     def get_run_count(self) -> int:
         """Return the number of runs listed within this Journal"""
@@ -279,22 +342,40 @@ class Journal:
     def get_run_for_file(self, filename: str) -> typing.Dict:
         """Return the data for the specified filename if we have it.
 
-        :param run_number: Run number of interest
+        :param filename: Data filename (without path) of interest
         :return: A Dict describing the run, or None if not found
         """
-        for run_number in self._run_data:
-            data = self._run_data[run_number]
-            # The journal entry may contain the full data_directory and filename
-            # information if we generated it. Otherwise we have to assume the
-            # stored 'data_directory' and use the 'name' attribute.
-            if "data_directory" in data and "filename" in data:
-                if data["filename"] == filename:
-                    return data
-            else:
-                if (data["name"] + ".nxs") == filename:
-                    return data
+        run_number = self._runs_by_data_file.get(filename)
+        return None if run_number is None else self.get_run(run_number)
 
-        return None
+    @property
+    def data_filenames(self) -> typing.Iterable[str]:
+        """Return the data filenames (without paths) of all runs in the
+        journal"""
+        return self._runs_by_data_file.keys()
+
+    def get_data_file(self, run_number: int) -> Optional[str]:
+        """Return the full path to the data (NeXuS) file for the specified
+        run number, or None if the run is not in the journal
+        """
+        data = self.get_run(run_number)
+        if data is None:
+            return None
+
+        # The journal entry may contain the full data_directory and filename
+        # information if we generated it. Otherwise we have to assume the
+        # stored 'data_directory' and use the 'name' attribute.
+        if "data_directory" in data and "filename" in data:
+            return url_join(data["data_directory"], data["filename"])
+        else:
+            return url_join(self.data_directory, data["name"] + ".nxs")
+
+    def get_data_files(self) -> typing.Dict[int, str]:
+        """Return a dict of run number/paths to NeXuS data files for all
+        runs in the journal
+        """
+        return {run_number: self.get_data_file(run_number)
+                for run_number in self._run_data}
 
     def get_run_data_after(self, run_number: int) -> {}:
         """Return data for all run numbers after the supplied run number
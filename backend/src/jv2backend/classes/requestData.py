@@ -25,6 +25,7 @@ class RequestData:
                  require_data_directory=False,
                  require_run_numbers=False,
                  require_parameters=None,
+                 optional_parameters=None,
                  require_value_map=False) -> None:
         """Store recognised items in the POST data. We can make various
          stipulations on the contents:
@@ -36,6 +37,8 @@ class RequestData:
            require_run_numbers: Whether one or more run numbers are expected
             require_parameters: Comma-separated list of additional parameters
                                 to expect as part of the request
+           optional_parameters: Comma-separated list of additional parameters
+                                to store if they are part of the request
              require_value_map: Whether a map of key=value is expected
         """
         self._source_id: str = None
@@ -96,6 +99,13 @@ class RequestData:
                 raise InvalidRequest(f"Additional parameter '{p}' "
                                      f"required but was not provided.")
 
+        # Were any optional parameters given?
+        params = ([] if optional_parameters is None
+                  else optional_parameters.split(","))
+        for p in params:
+            if p in requestData:
+                self._parameters[p] = requestData[p]
+
         # Was a value map provided / required?
         if "valueMap" in requestData:
             self._value_map = requestData["valueMap"]
@@ -158,6 +168,10 @@ class RequestData:
 
         raise RuntimeError(f"The parameter '{name}' is not in the request data.")
 
+    def has_parameter(self, name: str) -> bool:
+        """Return whether the additional named parameter was given"""
+        return name in self._parameters
+
     @property
     def value_map(self) -> {}:
         """Return the value map (if given)"""
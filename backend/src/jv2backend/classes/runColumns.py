@@ -0,0 +1,93 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+import datetime
+import typing
+
+import numpy as np
+
+import jv2backend.main.selector
+
+# Epoch used for start time columns
+_EPOCH = datetime.datetime(1970, 1, 1)
+
+
+def epoch_seconds(time: datetime.datetime) -> float:
+    """Return the (naive) datetime as seconds since the epoch"""
+    return (time - _EPOCH).total_seconds()
+
+
+def _parse_start_times(start_times: typing.List[typing.Optional[str]]) -> np.ndarray:
+    """Return the start times as seconds since the epoch, with NaN for any
+    missing or invalid"""
+    try:
+        times = np.array(["NaT" if time is None else time for time in start_times], dtype="datetime64[s]")
+        seconds = times.astype(np.int64).astype(np.float64)
+        seconds[np.isnat(times)] = np.nan
+        return seconds
+    except ValueError:
+        pass
+
+    # At least one time is not in ISO format, so parse them individually
+    seconds = np.full(len(start_times), np.nan)
+    for index, time in enumerate(start_times):
+        try:
+            seconds[index] = epoch_seconds(datetime.datetime.strptime(
+                time, jv2backend.main.selector.UNIX_DT_FORMAT_STR))
+        except (TypeError, ValueError):
+            continue
+    return seconds
+
+
+class RunColumns:
+    """Pre-parsed run number and start time columns for a set of run data,
+    so that range queries need not convert the field of every run.
+
+    Both columns are held sorted, and queried by binary search.
+    """
+
+    def __init__(self, run_data: typing.Optional[typing.Dict[int, typing.Dict]]):
+        run_data = {} if run_data is None else run_data
+        self.run_numbers = np.array(sorted(run_data), dtype=np.int64)
+
+        start_times = _parse_start_times([run_data[run_number].get("start_time")
+                                          for run_number in self.run_numbers.tolist()])
+        valid = ~np.isnan(start_times)
+        order = np.argsort(start_times[valid], kind="stable")
+        self.start_times = start_times[valid][order]
+        self.start_time_runs = self.run_numbers[valid][order]
+
+    def __len__(self) -> int:
+        """Return the number of runs in the columns"""
+        return len(self.run_numbers)
+
+    def run_bounds(self) -> typing.Optional[typing.Tuple[int, int]]:
+        """Return the first and last run numbers, or None if there are no
+        runs"""
+        if len(self.run_numbers) == 0:
+            return None
+        return int(self.run_numbers[0]), int(self.run_numbers[-1])
+
+    def start_time_bounds(self) -> typing.Optional[typing.Tuple[float, float]]:
+        """Return the earliest and latest start times (in seconds since the
+        epoch), or None if there are none"""
+        if len(self.start_times) == 0:
+            return None
+        return float(self.start_times[0]), float(self.start_times[-1])
+
+    def runs_in_number_range(self, first: typing.Optional[int], last: typing.Optional[int]) -> np.ndarray:
+        """Return the run numbers within the inclusive range, either end of
+        which may be open (None)"""
+        start = 0 if first is None else np.searchsorted(self.run_numbers, first, side="left")
+        end = len(self.run_numbers) if last is None else np.searchsorted(self.run_numbers, last, side="right")
+        return self.run_numbers[start:end]
+
+    def runs_in_time_range(self, start: typing.Optional[datetime.datetime], end: typing.Optional[datetime.datetime],
+                           inclusive: bool) -> np.ndarray:
+        """Return the run numbers whose start times lie within the range,
+        either end of which may be open (None)"""
+        first = 0 if start is None else np.searchsorted(self.start_times, epoch_seconds(start),
+                                                        side="left" if inclusive else "right")
+        last = len(self.start_times) if end is None else np.searchsorted(self.start_times, epoch_seconds(end),
+                                                                         side="right" if inclusive else "left")
+        return self.start_time_runs[first:last]
@@ -0,0 +1,138 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+from __future__ import annotations
+from bisect import bisect_left, bisect_right, insort
+import json
+from threading import Lock
+import typing
+
+
+class RunRangeIndex:
+    """Interval index mapping contiguous run number ranges to the journals
+    containing them.
+
+    Ranges are held sorted by their first run number so that the journal
+    containing any run can be found by bisection. Ranges from different
+    journals may overlap or nest, so a max tree over the last run numbers of
+    the sorted ranges is also kept, from which the latest-starting range
+    still reaching the run is found in O(log n). The tree is rebuilt only
+    when next searched after the ranges change, so that loading many
+    journals at once costs just an insertion each. Journals whose run data
+    have been seen but which contain no runs are recorded with no ranges, so
+    that they need not be loaded again to discover this.
+    """
+
+    def __init__(self):
+        self._lock = Lock()
+        self._journal_ranges: typing.Dict[str, typing.List[typing.Tuple[int, int]]] = {}
+        self._firsts: typing.List[int] = []
+        self._ranges: typing.List[typing.Tuple[int, int, str]] = []
+        # Max tree over the last run numbers of _ranges, with the leaves
+        # from index _leaves onwards, or None if it must be rebuilt
+        self._max_lasts: typing.Optional[typing.List[int]] = None
+        self._leaves = 0
+
+    def __contains__(self, filename: str) -> bool:
+        """Return whether the ranges of the named journal are known"""
+        with self._lock:
+            return filename in self._journal_ranges
+
+    def __len__(self) -> int:
+        """Return the number of journals in the index"""
+        with self._lock:
+            return len(self._journal_ranges)
+
+    def update(self, filename: str,
+               ranges: typing.Iterable[typing.Tuple[int, int]]) -> bool:
+        """Set the run number ranges contained in the named journal
+
+        :param filename: Filename of the journal
+        :param ranges: Inclusive (first, last) run number ranges
+        :return: Whether the index changed
+        """
+        ranges = sorted((int(first), int(last)) for first, last in ranges)
+        with self._lock:
+            previous = self._journal_ranges.get(filename)
+            if previous == ranges:
+                return False
+            for first, last in previous or []:
+                del self._ranges[bisect_left(self._ranges, (first, last, filename))]
+            for first, last in ranges:
+                insort(self._ranges, (first, last, filename))
+            self._journal_ranges[filename] = ranges
+            self._firsts = [first for first, _, _ in self._ranges]
+            self._max_lasts = None
+            return True
+
+    def find(self, run_number: int) -> typing.Optional[str]:
+        """Return the filename of the journal containing the run number, or
+        None if it is not in any indexed range
+        """
+        with self._lock:
+            if self._max_lasts is None:
+                self._build_max_lasts()
+            index = self._last_reaching(bisect_right(self._firsts, run_number) - 1, run_number)
+            return None if index is None else self._ranges[index][2]
+
+    def bounds(self, filename: str) -> typing.Optional[typing.Tuple[int, int]]:
+        """Return the first and last run numbers in the named journal, or
+        None if it is not indexed or contains no runs
+        """
+        with self._lock:
+            ranges = self._journal_ranges.get(filename)
+            if not ranges:
+                return None
+            return ranges[0][0], max(last for _, last in ranges)
+
+    def to_json(self) -> str:
+        """Return the index as JSON"""
+        with self._lock:
+            return json.dumps(self._journal_ranges)
+
+    @classmethod
+    def from_json(cls, data: typing.Union[str, bytes]) -> RunRangeIndex:
+        """Create an index from JSON previously returned by to_json()"""
+        index = cls()
+        for filename, ranges in json.loads(data).items():
+            index._journal_ranges[filename] = [(int(first), int(last)) for first, last in ranges]
+        index._ranges = sorted(
+            (first, last, filename)
+            for filename, ranges in index._journal_ranges.items()
+            for first, last in ranges
+        )
+        index._firsts = [first for first, _, _ in index._ranges]
+        return index
+
+    def _build_max_lasts(self) -> None:
+        """Recreate the max tree over the last run numbers of the ranges"""
+        self._leaves = 1
+        while self._leaves < len(self._ranges):
+            self._leaves *= 2
+        tree = [-1] * (2 * self._leaves)
+        tree[self._leaves:self._leaves + len(self._ranges)] = [last for _, last, _ in self._ranges]
+        for node in range(self._leaves - 1, 0, -1):
+            tree[node] = max(tree[2 * node], tree[2 * node + 1])
+        self._max_lasts = tree
+
+    def _last_reaching(self, index: int, run_number: int) -> typing.Optional[int]:
+        """Return the largest index of a range, no greater than that given,
+        whose last run number is at least run_number, or None if there is
+        none"""
+        if index < 0:
+            return None
+
+        # Climb from the leaf until a subtree to the left of the path can
+        # reach the run, then descend into its rightmost such leaf
+        tree = self._max_lasts
+        node = self._leaves + index
+        if tree[node] >= run_number:
+            return index
+        while node > 1:
+            if node % 2 == 1 and tree[node - 1] >= run_number:
+                node -= 1
+                while node < self._leaves:
+                    node = 2 * node + 1 if tree[2 * node + 1] >= run_number else 2 * node
+                return node - self._leaves
+            node //= 2
+        return None
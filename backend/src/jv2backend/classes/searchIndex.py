@@ -0,0 +1,503 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+import collections
+import heapq
+import logging
+import re
+from threading import Lock
+import typing
+
+import numpy as np
+
+from jv2backend.classes.runColumns import RunColumns, epoch_seconds
+import jv2backend.main.selector
+
+# Fields whose words are held in inverted indices
+TEXT_FIELDS = ("title", "user_name")
+
+# Fields whose complete (lower case) values are indexed for exact matching
+VALUE_FIELDS = ("experiment_identifier",)
+
+# Fields whose trigrams are indexed for similarity matching
+SIMILAR_FIELDS = ("title",)
+
+_TOKEN_REGEX = re.compile(r"\w+")
+
+# Methods by which a search term may be answered
+VALUES = "values"    # Exact value index
+COLUMNS = "columns"  # Binary search of the run number / start time columns
+TOKENS = "tokens"    # Word index, giving candidates to be checked
+TRIGRAMS = "trigrams"  # Trigram index, giving matches ranked by similarity
+SCAN = "scan"        # Checking every candidate with the selector
+
+# Relative cost of each method
+_METHOD_COST = {VALUES: 0, COLUMNS: 0, TOKENS: 1, TRIGRAMS: 1, SCAN: 2}
+
+# Number of matching runs checked and returned together by search_chunks()
+MATCH_CHUNK_SIZE = 1024
+
+
+def tokenise(text: str) -> typing.Set[str]:
+    """Return the distinct lower case words in the text"""
+    return set(_TOKEN_REGEX.findall(text.lower()))
+
+
+def _sort_key(field: str, descending: bool) -> typing.Callable[[typing.Dict], typing.Tuple]:
+    """Return a key ordering run data by the field, with runs lacking a
+    (valid) value placed last whichever the direction"""
+    missing = 0 if descending else 1
+
+    def key(data: typing.Dict) -> typing.Tuple:
+        if field not in data:
+            return missing, 0
+        if field == "run_number":
+            try:
+                return 1 - missing, int(data[field])
+            except ValueError:
+                return missing, 0
+        return 1 - missing, data[field].lower()
+
+    return key
+
+
+class _Retained:
+    """A run held by TopRuns, ordered so that the run to be dropped first
+    (the last in sort order, or the later found of equal runs) is least"""
+
+    __slots__ = ("key", "index", "data", "descending")
+
+    def __init__(self, key: typing.Any, index: int, data: typing.Dict, descending: bool):
+        self.key = key
+        self.index = index
+        self.data = data
+        self.descending = descending
+
+    def __lt__(self, other: "_Retained") -> bool:
+        if self.key != other.key:
+            return self.key < other.key if self.descending else self.key > other.key
+        return self.index > other.index
+
+
+class TopRuns:
+    """The leading runs, in sort order, out of any number offered.
+
+    At most `capacity` runs are retained, in a heap bounded to that size
+    whose root is the next run to be dropped, and the remainder are only
+    counted, so the complete set of runs offered is never held. Runs
+    without a key are kept in the order offered.
+    """
+
+    def __init__(self, capacity: typing.Optional[int] = None,
+                 key: typing.Optional[typing.Callable[[typing.Dict], typing.Any]] = None,
+                 descending: bool = False):
+        """
+        :param capacity: Maximum number of runs to retain, or None for all
+        :param key: Function returning the value on which to order a run,
+                    or None to keep the order in which runs are offered
+        :param descending: Whether runs with the largest keys lead
+        """
+        self._capacity = capacity
+        self._key = key
+        self._descending = descending
+        self._heap: typing.List[_Retained] = []
+        self._runs: typing.List[typing.Dict] = []
+        self._ordered = True
+        self._total = 0
+
+    @classmethod
+    def sorted_by(cls, sort_by: typing.Optional[str], capacity: typing.Optional[int] = None) -> "TopRuns":
+        """Return an instance ordering runs by a field
+
+        :param sort_by: Field to sort on, prefixed with '-' for descending
+                        order (e.g. '-start_time' for the most recent first),
+                        or None to keep the order of the runs
+        :param capacity: Maximum number of runs to retain, or None for all
+        """
+        if not sort_by:
+            return cls(capacity)
+        descending = sort_by.startswith("-")
+        return cls(capacity, _sort_key(sort_by.lstrip("-"), descending), descending)
+
+    @property
+    def total(self) -> int:
+        """Return the number of runs offered"""
+        return self._total
+
+    @property
+    def retained(self) -> int:
+        """Return the number of runs retained"""
+        return len(self._runs) if self._key is None else len(self._heap)
+
+    def add(self, runs: typing.Iterable[typing.Dict]) -> None:
+        """Offer further runs, retaining those which now lead"""
+        for data in runs:
+            self._total += 1
+            if self._key is None:
+                if self._capacity is None or len(self._runs) < self._capacity:
+                    self._runs.append(data)
+                continue
+
+            entry = _Retained(self._key(data), self._total, data, self._descending)
+            if self._capacity is None or len(self._heap) < self._capacity:
+                heapq.heappush(self._heap, entry)
+            elif self._capacity > 0 and self._heap[0] < entry:
+                heapq.heapreplace(self._heap, entry)
+            else:
+                continue
+            self._ordered = False
+
+    def runs(self, first: int = 0, limit: typing.Optional[int] = None) -> typing.List[typing.Dict]:
+        """Return a page of the retained runs in order
+
+        :param first: Index of the first run to return
+        :param limit: Maximum number of runs to return, or None for all
+        """
+        if not self._ordered:
+            self._runs = [entry.data for entry in sorted(self._heap, reverse=True)]
+            self._ordered = True
+        return self._runs[first:None if limit is None else first + limit]
+
+
+def _overlaps(bounds: typing.Optional[typing.Tuple[float, float]],
+              first: typing.Optional[float], last: typing.Optional[float]) -> bool:
+    """Return whether the (min, max) bounds overlap the range, either end of
+    which may be open (None)"""
+    if bounds is None:
+        return False
+    return (first is None or bounds[1] >= first) and (last is None or bounds[0] <= last)
+
+
+class SearchStep(typing.NamedTuple):
+    """A single search term, and how it is to be answered"""
+    field: str
+    value: str
+    method: str
+    # Estimated number of matching runs, if known
+    estimate: typing.Optional[int] = None
+    # Parsed range of COLUMNS terms (or None if the range is invalid)
+    bounds: typing.Optional[typing.Tuple] = None
+
+    def __str__(self):
+        estimate = "" if self.estimate is None else f", ~{self.estimate} runs"
+        return f"{self.field}='{self.value}' ({self.method}{estimate})"
+
+
+class SearchPlan(typing.NamedTuple):
+    """Ordered search steps, and the journals which may contain matches"""
+    steps: typing.List[SearchStep]
+    journals: typing.List[str]
+
+
+class SearchIndex:
+    """Collection-level index of run data, answering searches without
+    scanning every run.
+
+    Words in text fields are held in inverted indices, so a "contains"
+    search only has to examine the (much smaller) vocabulary and the runs
+    whose words match. Similarity searches count the shared trigrams of
+    each distinct (lower case) title from a trigram index, and are ranked
+    most similar first. Run number and start time ranges are found by binary
+    search of the pre-parsed columns of each journal. Candidate sets from
+    each search term are intersected, and the remaining candidates checked
+    against the terms with the selector to give exactly the same results as
+    a full scan.
+
+    Each search is first planned: journals whose run number or start time
+    bounds fall outside the requested ranges are excluded, and terms are
+    ordered cheapest and most selective first using the sizes of the posting
+    lists and ranges.
+
+    Runs are added and replaced a journal at a time as journals are loaded.
+    """
+
+    def __init__(self):
+        self._lock = Lock()
+        self._runs: typing.Dict[int, typing.Dict] = {}
+        self._run_journals: typing.Dict[int, str] = {}
+        self._journal_runs: typing.Dict[str, typing.List[int]] = {}
+        self._tokens: typing.Dict[str, typing.Dict[str, typing.Set[int]]] = {field: {} for field in TEXT_FIELDS}
+        self._values: typing.Dict[str, typing.Dict[str, typing.Set[int]]] = {field: {} for field in VALUE_FIELDS}
+        # Runs with each distinct (lower case) text, the number of trigrams in
+        # each text, and the texts containing each trigram
+        self._texts: typing.Dict[str, typing.Dict[str, typing.Set[int]]] = {field: {} for field in SIMILAR_FIELDS}
+        self._trigram_counts: typing.Dict[str, typing.Dict[str, int]] = {field: {} for field in SIMILAR_FIELDS}
+        self._trigrams: typing.Dict[str, typing.Dict[str, typing.Set[str]]] = {field: {} for field in SIMILAR_FIELDS}
+        self._columns: typing.Dict[str, RunColumns] = {}
+
+    def __len__(self) -> int:
+        """Return the number of runs in the index"""
+        with self._lock:
+            return len(self._runs)
+
+    # ---------------- Maintenance
+
+    def update(self, filename: str, run_data: typing.Optional[typing.Dict[int, typing.Dict]],
+               columns: typing.Optional[RunColumns] = None) -> None:
+        """Set the runs contained in the named journal, replacing any
+        previously indexed for it
+
+        :param filename: Filename of the journal
+        :param run_data: Dict of run numbers and run data
+        :param columns: Pre-parsed columns of the run data, if available
+        """
+        with self._lock:
+            self._remove_journal(filename)
+            if not run_data:
+                return
+
+            self._journal_runs[filename] = list(run_data.keys())
+            self._columns[filename] = RunColumns(run_data) if columns is None else columns
+            for run_number, data in run_data.items():
+                if run_number in self._runs:
+                    self._remove_run(run_number)
+                self._runs[run_number] = data
+                self._run_journals[run_number] = filename
+                for field, index in self._tokens.items():
+                    if field in data:
+                        for token in tokenise(data[field]):
+                            index.setdefault(token, set()).add(run_number)
+                for field, index in self._values.items():
+                    if field in data:
+                        index.setdefault(data[field].lower(), set()).add(run_number)
+                for field, index in self._texts.items():
+                    if field in data:
+                        text = data[field].lower()
+                        if text not in index:
+                            index[text] = set()
+                            text_trigrams = jv2backend.main.selector.trigrams(text)
+                            self._trigram_counts[field][text] = len(text_trigrams)
+                            for trigram in text_trigrams:
+                                self._trigrams[field].setdefault(trigram, set()).add(text)
+                        index[text].add(run_number)
+
+    def _remove_journal(self, filename: str) -> None:
+        """Remove the runs of the named journal"""
+        self._columns.pop(filename, None)
+        for run_number in self._journal_runs.pop(filename, []):
+            if self._run_journals.get(run_number) == filename:
+                self._remove_run(run_number)
+
+    def _remove_run(self, run_number: int) -> None:
+        """Remove a single run from all indices"""
+        data = self._runs.pop(run_number)
+        self._run_journals.pop(run_number, None)
+        for field, index in self._tokens.items():
+            if field in data:
+                for token in tokenise(data[field]):
+                    self._discard(index, token, run_number)
+        for field, index in self._values.items():
+            if field in data:
+                self._discard(index, data[field].lower(), run_number)
+        for field, index in self._texts.items():
+            if field in data:
+                text = data[field].lower()
+                self._discard(index, text, run_number)
+                if text not in index:
+                    del self._trigram_counts[field][text]
+                    for trigram in jv2backend.main.selector.trigrams(text):
+                        self._discard(self._trigrams[field], trigram, text)
+
+    @staticmethod
+    def _discard(index: typing.Dict[str, typing.Set], key: str, item: typing.Union[int, str]) -> None:
+        """Remove the item (run number or text) from the posting list for the
+        key"""
+        postings = index.get(key)
+        if postings is None:
+            return
+        postings.discard(item)
+        if not postings:
+            del index[key]
+
+    # ---------------- Search
+
+    def plan(self, search_terms: typing.Dict[str, str],
+             journals: typing.Optional[typing.List[str]] = None) -> SearchPlan:
+        """Return the plan by which the search terms would be answered"""
+        with self._lock:
+            return self._plan(search_terms, journals)
+
+    def _plan(self, search_terms: typing.Dict[str, str], journals: typing.Optional[typing.List[str]]) -> SearchPlan:
+        """Decide how each search term is to be answered and in which
+        order, and which of the journals (or all if None) may contain matches
+        given the bounds of their run numbers and start times"""
+        steps = []
+        journals = list(self._columns) if journals is None else [
+            filename for filename in journals if filename in self._columns]
+        for field, value in search_terms.items():
+            if field in VALUE_FIELDS:
+                steps.append(SearchStep(field, value, VALUES, len(self._values[field].get(value.lower(), ()))))
+            elif field == "run_number":
+                bounds = jv2backend.main.selector.integer_bounds(value)
+                journals = [filename for filename in journals if bounds is not None and
+                            _overlaps(self._columns[filename].run_bounds(), bounds[0], bounds[1])]
+                steps.append(SearchStep(field, value, COLUMNS, bounds=bounds))
+            elif field == "start_time":
+                bounds = jv2backend.main.selector.datetime_bounds(value)
+                journals = [filename for filename in journals if bounds is not None and
+                            _overlaps(self._columns[filename].start_time_bounds(),
+                                      None if bounds[0] is None else epoch_seconds(bounds[0]),
+                                      None if bounds[1] is None else epoch_seconds(bounds[1]))]
+                steps.append(SearchStep(field, value, COLUMNS, bounds=bounds))
+            elif (field.endswith(jv2backend.main.selector.SIMILAR_SUFFIX) and
+                  field[:-len(jv2backend.main.selector.SIMILAR_SUFFIX)] in SIMILAR_FIELDS):
+                steps.append(SearchStep(field, value, TRIGRAMS))
+            elif field in TEXT_FIELDS and tokenise(value):
+                steps.append(SearchStep(field, value, TOKENS))
+            else:
+                steps.append(SearchStep(field, value, SCAN))
+
+        # Estimate the number of runs in each range over the remaining journals
+        steps = [step._replace(estimate=sum(len(self._find_in_columns(step, self._columns[filename]))
+                                            for filename in journals))
+                 if step.method == COLUMNS else step for step in steps]
+
+        # Cheapest methods first, and the most selective terms first within each
+        steps.sort(key=lambda step: (_METHOD_COST[step.method],
+                                     len(self._runs) if step.estimate is None else step.estimate))
+
+        return SearchPlan(steps, journals)
+
+    def search(self, search_terms: typing.Dict[str, str], case_sensitive: bool = False,
+               journals: typing.Optional[typing.List[str]] = None) -> typing.Dict[int, typing.Dict]:
+        """Return the runs matching all of the search terms, in run number
+        order or, if searching for similar text, most similar first
+
+        :param search_terms: Dict of search field/values
+        :param case_sensitive: Whether text comparisons are case sensitive
+        :param journals: Filenames of the journals to search, or None for all
+        :return: A dict of matching run numbers and run data
+        """
+        return {run_number: data for chunk in self.search_chunks(search_terms, case_sensitive, journals)
+                for run_number, data in chunk.items()}
+
+    def search_chunks(
+        self, search_terms: typing.Dict[str, str], case_sensitive: bool = False,
+        journals: typing.Optional[typing.List[str]] = None
+    ) -> typing.Iterator[typing.Dict[int, typing.Dict]]:
+        """Return an iterator over the runs matching all of the search terms,
+        in the order given by search(), a chunk at a time. Only the matching
+        run numbers are found at once, so the data of the matching runs need
+        never all be gathered together.
+
+        :param search_terms: Dict of search field/values
+        :param case_sensitive: Whether text comparisons are case sensitive
+        :param journals: Filenames of the journals to search, or None for all
+        :return: An iterator over dicts of matching run numbers and run data
+        :raises: ValueError or RuntimeError if any of the terms is invalid
+        """
+        with self._lock:
+            plan = self._plan(search_terms, journals)
+            logging.debug(f"Search plan over {len(plan.journals)} of "
+                          f"{len(self._columns) if journals is None else len(journals)} journals: "
+                          f"{' -> '.join(str(step) for step in plan.steps)}")
+            if not plan.journals:
+                return iter(())
+
+            # Intersect the candidates from each term the indices can answer,
+            # deferring those which must be checked against the run data
+            matches: typing.Optional[typing.Set[int]] = None if journals is None else {
+                run_number for filename in plan.journals for run_number in self._journal_runs[filename]
+                if self._run_journals.get(run_number) == filename}
+            checks = []
+            similarity: typing.Optional[typing.Dict[int, float]] = None
+            for step in plan.steps:
+                if matches is not None and not matches:
+                    return iter(())
+
+                # Checking a few candidates directly is cheaper than searching a large vocabulary
+                if step.method == SCAN or (step.method == TOKENS and matches is not None and
+                                           len(matches) < len(self._tokens[step.field])):
+                    checks.append(step)
+                    continue
+
+                if step.method == TRIGRAMS:
+                    similarity = self._similar_runs(step.field[:-len(jv2backend.main.selector.SIMILAR_SUFFIX)],
+                                                    step.value)
+                    candidates = set(similarity)
+                else:
+                    candidates = self._step_candidates(step, plan.journals)
+                matches = candidates if matches is None else matches & candidates
+
+                # Text candidates are only a superset of the matches
+                if step.method == TOKENS or (step.method == VALUES and case_sensitive):
+                    checks.append(step)
+
+            order = sorted(self._runs if matches is None else matches)
+            if similarity is not None:
+                order.sort(key=lambda run_number: -similarity[run_number])
+
+        return self._checked_chunks(order, checks, case_sensitive)
+
+    def _checked_chunks(self, order: typing.List[int], checks: typing.List[SearchStep],
+                        case_sensitive: bool) -> typing.Iterator[typing.Dict[int, typing.Dict]]:
+        """Yield the data of the runs in order, a chunk at a time, keeping
+        those which pass the checks"""
+        for start in range(0, len(order), MATCH_CHUNK_SIZE):
+            with self._lock:
+                results = {run_number: self._runs[run_number] for run_number in order[start:start + MATCH_CHUNK_SIZE]
+                           if run_number in self._runs}
+            for step in checks:
+                if not results:
+                    break
+                results = jv2backend.main.selector.select(results, step.field, step.value, case_sensitive)
+            if results:
+                yield results
+
+    def _step_candidates(self, step: SearchStep, journals: typing.List[str]) -> typing.Set[int]:
+        """Return the set of runs which may match the term, from the indices"""
+        if step.method == VALUES:
+            return set(self._values[step.field].get(step.value.lower(), ()))
+        if step.method == TOKENS:
+            return self._text_candidates(step.field, step.value)
+
+        # Find runs in the columns of the journals, ignoring any (duplicate)
+        # run numbers held by another journal
+        candidates = set()
+        for filename in journals:
+            candidates.update(run_number for run_number in self._find_in_columns(step, self._columns[filename]).tolist()
+                              if self._run_journals.get(run_number) == filename)
+        return candidates
+
+    @staticmethod
+    def _find_in_columns(step: SearchStep, columns: RunColumns) -> np.ndarray:
+        """Return the runs in the columns which lie within the range of the
+        term"""
+        if step.bounds is None:
+            return columns.run_numbers[:0]
+        if step.field == "run_number":
+            return columns.runs_in_number_range(*step.bounds)
+        return columns.runs_in_time_range(*step.bounds)
+
+    def _similar_runs(self, field: str, value: str) -> typing.Dict[int, float]:
+        """Return the runs whose field is similar to the value, along with
+        their similarity (see selector.similarity), by counting the trigrams
+        of the value shared by each distinct text"""
+        search_trigrams = jv2backend.main.selector.trigrams(value)
+        index = self._trigrams[field]
+        shared = collections.Counter()
+        for trigram in search_trigrams:
+            shared.update(index.get(trigram, ()))
+
+        result = {}
+        counts = self._trigram_counts[field]
+        for text, count in shared.items():
+            score = 2 * count / (len(search_trigrams) + counts[text])
+            if score >= jv2backend.main.selector.SIMILARITY_THRESHOLD:
+                result.update((run_number, score) for run_number in self._texts[field][text])
+        return result
+
+    def _text_candidates(self, field: str, value: str) -> typing.Set[int]:
+        """Return the runs whose field contains every word in the value as
+        part of one of its own words"""
+        index = self._tokens[field]
+        result = set()
+        for n, query_token in enumerate(sorted(tokenise(value), key=len, reverse=True)):
+            postings = set()
+            for token, runs in index.items():
+                if query_token in token:
+                    postings.update(runs)
+            result = postings if n == 0 else result & postings
+            if not result:
+                break
+        return result
@@ -0,0 +1,118 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+"""Background determination of detector health over a whole journal.
+
+The non-zero spectrum ratio, total counts and counts per µAh of every run
+in a journal are determined on a background thread and recorded in the
+NeXus metadata index, so that subsequent scans of the same journal only
+need to read files which are new or have changed.
+"""
+import logging
+from threading import Thread, Event, Lock
+from typing import Any, Dict, List, Optional
+
+import jv2backend.main.nexusIndex
+
+
+class DetectorHealthThread(Thread):
+    """Thread determining detector health for a set of data files in turn"""
+
+    def __init__(self, key: str, data_files: Dict[int, Optional[str]]):
+        Thread.__init__(self, daemon=True)
+        self.key = key
+        self._data_files = data_files
+        self._stop_event = Event()
+        self._lock = Lock()
+        self._results: List[Dict[str, Any]] = []
+        self._complete = False
+
+    def run(self):
+        for run_number, data_file in self._data_files.items():
+            if self._stop_event.is_set():
+                break
+
+            result: Dict[str, Any] = {"runNumber": run_number}
+            if data_file is None:
+                result["error"] = f"Unable to find data file for run {run_number}"
+            else:
+                try:
+                    result.update(
+                        jv2backend.main.nexusIndex.lookup(data_file, "detectorHealth")
+                    )
+                except (OSError, KeyError, ValueError, IndexError) as exc:
+                    logging.debug(f"Failed to determine detector health for "
+                                  f"{data_file}: {str(exc)}")
+                    result["error"] = str(exc)
+
+            with self._lock:
+                self._results.append(result)
+
+        with self._lock:
+            self._complete = True
+
+    def stop(self) -> None:
+        """Request that the thread stops after the current file"""
+        self._stop_event.set()
+
+    def get_update(self, first: int = 0) -> Dict[str, Any]:
+        """Return progress and any results from the specified index onwards
+
+        :param first: Index of the first result to return
+        """
+        with self._lock:
+            return {
+                "numRuns": len(self._data_files),
+                "numCompleted": len(self._results),
+                "complete": self._complete,
+                "first": first,
+                "results": self._results[first:]
+            }
+
+
+class DetectorHealthScanner:
+    """Runs a single detector health scan at a time"""
+
+    def __init__(self) -> None:
+        self._lock = Lock()
+        self._thread: Optional[DetectorHealthThread] = None
+
+    def start(self, key: str, data_files: Dict[int, Optional[str]]) -> Dict[str, Any]:
+        """Start a scan of the supplied data files, stopping any other scan
+
+        A scan with the same key which is still running is left to continue.
+        :param key: Unique identifier for the scan (e.g. the journal)
+        :param data_files: Dict of run numbers and data file paths
+        :return: The initial progress of the scan
+        """
+        with self._lock:
+            if self._thread is not None and self._thread.key == key and self._thread.is_alive():
+                return self._thread.get_update()
+
+            if self._thread is not None:
+                self._thread.stop()
+            self._thread = DetectorHealthThread(key, data_files)
+            self._thread.start()
+            logging.debug(f"Started detector health scan for {key} "
+                          f"({len(data_files)} runs)...")
+            return self._thread.get_update()
+
+    def get_update(self, key: str, first: int = 0) -> Optional[Dict[str, Any]]:
+        """Return progress and results of the scan with the specified key
+
+        :param key: Unique identifier for the scan
+        :param first: Index of the first result to return
+        :return: The progress of the scan, or None if it is not the current one
+        """
+        with self._lock:
+            thread = self._thread
+        if thread is None or thread.key != key:
+            return None
+        return thread.get_update(first)
+
+    def stop(self) -> None:
+        """Stop any scan currently in progress"""
+        with self._lock:
+            if self._thread is not None:
+                self._thread.stop()
+            self._thread = None
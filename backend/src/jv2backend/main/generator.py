@@ -13,6 +13,7 @@ import re
 from jv2backend.utils import url_join
 from jv2backend.classes.collection import JournalCollection
 import jv2backend.main.userCache
+import jv2backend.main.nexusIndex
 from threading import Thread, Event, Lock
 
 
@@ -105,7 +106,7 @@ class GeneratorThread(Thread):
         :param filename: NeXuS filename
         :return: A dict of all run attributes
         """
-        nxs = h5py.File(url_join(data_directory, filename))
+        filepath = url_join(data_directory, filename)
 
         # Basic data
         data = {
@@ -113,17 +114,25 @@ class GeneratorThread(Thread):
             "filename": filename
         }
 
-        # String attributes
-        for stringValue in self._nxs_strings:
-            if stringValue in nxs:
-                value = nxs[stringValue][0]
-                data[self._nxs_strings[stringValue]] = value.decode('utf-8')
-
-        # Numerical attributes
-        for numValue in self._nxs_numericals:
-            if numValue in nxs:
-                value = nxs[numValue][0]
-                data[self._nxs_numericals[numValue]] = str(value)
+        with h5py.File(filepath) as nxs:
+            # String attributes
+            for stringValue in self._nxs_strings:
+                if stringValue in nxs:
+                    value = nxs[stringValue][0]
+                    data[self._nxs_strings[stringValue]] = value.decode('utf-8')
+
+            # Numerical attributes
+            for numValue in self._nxs_numericals:
+                if numValue in nxs:
+                    value = nxs[numValue][0]
+                    data[self._nxs_numericals[numValue]] = str(value)
+
+        # Record the file's metadata while we're here, so that later requests
+        # need not touch it
+        try:
+            jv2backend.main.nexusIndex.populate(filepath)
+        except (OSError, KeyError, IndexError) as exc:
+            logging.debug(f"Failed to index metadata for {filepath}: {str(exc)}")
 
         return data
 
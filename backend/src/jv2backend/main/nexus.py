@@ -2,13 +2,25 @@
 # Copyright (c) 2024 Team JournalViewer and contributors
 
 """A collection of function to return data for a NeXus file"""
+from collections import OrderedDict
+from concurrent.futures import ThreadPoolExecutor
+from contextlib import contextmanager
+from dataclasses import dataclass
+from functools import lru_cache
+import logging
+import math
+import os
 from pathlib import Path, PurePath
 import re
-from typing import Any, MutableSequence, Sequence, Tuple
+import threading
+from typing import Any, Callable, Dict, Iterator, List, MutableSequence, Optional, Sequence, Tuple, Union
 
 import h5py as h5
 import numpy as np
 
+from jv2backend.classes.integerRange import IntegerRange
+from jv2backend.utils import encode_float64_array
+
 
 class NXStrings:
     """Define known strings for NeXus files"""
@@ -25,18 +37,423 @@ class NXStrings:
     Data = "data"
     Counts = "counts"
     ToF = "time_of_flight"
+    ProtonCharge = "proton_charge"
 
 
 # Match a monitor group name
 _MonitorRE = re.compile(f"^{NXStrings.MonitorPrefix}\\d+$")
 
+# Number of bins along each side of a detector map tile
+DETECTOR_MAP_TILE_SIZE = 256
+
+# Number of spectra to read at once when summing detector spectra
+_SPECTRUM_BLOCK_SIZE = 256
+
+
+class NexusFileCache:
+    """Bounded, thread-safe LRU cache of open read-only HDF5 files.
+
+    Files are keyed by path and reopened if their modification time or
+    size changes. A file evicted (or found to be stale) while in use by
+    another thread is only closed once that thread has finished with it.
+
+    Files are opened in SWMR read mode so that runs still being written
+    (by a writer in SWMR mode) can be read. A live cache keeps such files
+    open while they grow, and callers must refresh() datasets before
+    reading them to see newly appended data.
+    """
+
+    # Raw data chunk cache settings applied to each dataset. Files are
+    # read-only, so fully-read chunks are evicted first (w0 = 1.0)
+    CHUNK_CACHE_BYTES = 32 * 1024 * 1024
+    CHUNK_CACHE_SLOTS = 10007
+    CHUNK_CACHE_W0 = 1.0
+
+    class _Entry:
+        def __init__(self, h5file: h5.File, stat: os.stat_result):
+            self.h5file = h5file
+            self.mtime_ns = stat.st_mtime_ns
+            self.size = stat.st_size
+            self.inode = stat.st_ino
+            self.users = 0
+            self.retired = False
+
+        def matches(self, stat: os.stat_result, live: bool) -> bool:
+            if live:
+                return self.inode == stat.st_ino and self.size <= stat.st_size
+            return self.mtime_ns == stat.st_mtime_ns and self.size == stat.st_size
+
+    def __init__(self, max_size: int = 16, live: bool = False):
+        """
+        :param max_size: Maximum number of files to keep open
+        :param live: Whether to keep files open as they are appended to,
+                     rather than reopening them whenever they change
+        """
+        self._max_size = max_size
+        self._live = live
+        self._entries: "OrderedDict[str, NexusFileCache._Entry]" = OrderedDict()
+        self._lock = threading.Lock()
+
+    def __len__(self) -> int:
+        return len(self._entries)
+
+    @contextmanager
+    def open(self, filepath: Path) -> Iterator[h5.File]:
+        """Yield an open, read-only handle to the file at the given path
+
+        :raises: IOError if the file cannot be accessed
+        """
+        key = os.fspath(filepath)
+        stat = os.stat(key)
+        with self._lock:
+            entry = self._acquire(key, stat)
+
+        if entry is None:
+            # Open the file outside the lock so that other files can be
+            # opened (and cached files used) meanwhile
+            h5file = h5.File(key, "r", swmr=True,
+                             rdcc_nbytes=self.CHUNK_CACHE_BYTES,
+                             rdcc_nslots=self.CHUNK_CACHE_SLOTS,
+                             rdcc_w0=self.CHUNK_CACHE_W0)
+            with self._lock:
+                # Another thread may have opened the same file meanwhile
+                entry = self._acquire(key, stat)
+                if entry is None:
+                    entry = NexusFileCache._Entry(h5file, stat)
+                    entry.users += 1
+                    self._entries[key] = entry
+                    h5file = None
+
+                # Drop least-recently used files beyond our limit
+                while len(self._entries) > self._max_size:
+                    _, oldest = self._entries.popitem(last=False)
+                    self._retire(oldest)
+            if h5file is not None:
+                h5file.close()
+
+        try:
+            yield entry.h5file
+        finally:
+            with self._lock:
+                entry.users -= 1
+                if entry.retired and entry.users == 0:
+                    entry.h5file.close()
+
+    def _acquire(self, key: str, stat: os.stat_result) -> Optional["NexusFileCache._Entry"]:
+        """Return the cached entry for the file, marked as in use, or None if
+        there is none matching its current status. Must be called with the
+        lock held."""
+        entry = self._entries.get(key)
+        if entry is None:
+            return None
+        if not entry.matches(stat, self._live):
+            self._retire(self._entries.pop(key))
+            return None
+        self._entries.move_to_end(key)
+        entry.users += 1
+        return entry
+
+    def clear(self) -> None:
+        """Close (or retire, if in use) all cached files"""
+        with self._lock:
+            while self._entries:
+                _, entry = self._entries.popitem()
+                self._retire(entry)
+
+    @staticmethod
+    def _retire(entry: "NexusFileCache._Entry") -> None:
+        """Close the entry's file, or mark it to be closed once unused"""
+        entry.retired = True
+        if entry.users == 0:
+            entry.h5file.close()
+
+
+# Open file handles shared by all NeXus helpers
+FILE_CACHE = NexusFileCache()
+
+# Handles to runs being monitored while they are written, kept open between
+# polls so that only newly appended data need be read
+LIVE_FILE_CACHE = NexusFileCache(max_size=4, live=True)
+
+# Worker threads used to check for several data files at once. h5py
+# serialises library calls, so files are read one at a time, but locating
+# them (slow on network shares) can overlap
+MAX_STAT_WORKERS = 16
+_STAT_POOL = ThreadPoolExecutor(max_workers=MAX_STAT_WORKERS, thread_name_prefix="nexus-stat")
+
+
+@dataclass
+class RunResult:
+    """Result of reading from a single run's data file"""
+
+    # Value returned by the read, if successful
+    value: Any = None
+    # Description of the error encountered, if unsuccessful
+    error: Optional[str] = None
+
+
+def read_runs(
+    read: Callable[[str], Any], data_files: Dict[int, Optional[str]]
+) -> Dict[int, RunResult]:
+    """Apply a read function to the data file of each run
+
+    The data files are first checked for concurrently, and those found are
+    then read in turn. A failure for any one run is captured in its result
+    rather than aborting the others.
+    :param read: Function taking a file path and returning the data
+    :param data_files: Mapping of run number to file path (or None if the
+                       file could not be located)
+    :return: Mapping of run number to result, in the order of data_files
+    """
+    def stat_error(filepath: str) -> Optional[str]:
+        try:
+            os.stat(filepath)
+        except OSError as exc:
+            logging.debug(f"Failed to find {filepath}: {exc}")
+            return str(exc)
+        return None
+
+    def guarded_read(filepath: str) -> RunResult:
+        try:
+            return RunResult(value=read(filepath))
+        except (OSError, KeyError, ValueError, IndexError) as exc:
+            logging.debug(f"Failed to read {filepath}: {exc}")
+            return RunResult(error=str(exc))
+
+    located = {run: filepath for run, filepath in data_files.items() if filepath is not None}
+    stat_errors = dict(zip(located, _STAT_POOL.map(stat_error, located.values())))
+
+    results = {}
+    for run in data_files:
+        if run not in located:
+            results[run] = RunResult(error=f"Unable to find data file for run {run}")
+        elif stat_errors[run] is not None:
+            results[run] = RunResult(error=stat_errors[run])
+        else:
+            results[run] = guarded_read(located[run])
+    return results
+
+
+@dataclass
+class Spectrum:
+    """Counts in each time-of-flight bin of a single (or summed) spectrum"""
+
+    # Time-of-flight bin edges
+    edges: np.ndarray
+    # Counts in each bin
+    counts: np.ndarray
+
+    def points(self) -> Sequence[Tuple[float, float]]:
+        """Return a list of (tof,signal) pairs where tof is the bin centre"""
+        centres = 0.5 * (self.edges[1:] + self.edges[:-1])
+        return list(zip(centres.tolist(), self.counts.tolist()))
+
+
+def encode_spectra(spectra: Dict[int, Optional[Spectrum]],
+                   divisors: Optional[Dict[int, Dict[str, Any]]] = None) -> Dict[str, Any]:
+    """Encode spectra for transfer, sending each distinct set of bin edges
+    only once
+
+    Bin edges and counts are encoded as by encode_float64_array. Each entry
+    in the returned "spectra" gives the run number, the index of its bin
+    edges in "axes", and its counts. Runs without a spectrum are given only
+    their run number. Any divisors for a run (see Normalisation.divisors)
+    are given in its "divisors", arrays being encoded like the counts.
+    :param spectra: Mapping of run number to spectrum (or None)
+    :param divisors: Optional mapping of run number to normalisation divisors
+    :return: Dict containing the "axes" and "spectra" lists
+    """
+    axes = []
+    axis_indices = {}
+    encoded = []
+    for run, spectrum in spectra.items():
+        if spectrum is None:
+            encoded.append({"runNumber": run})
+            continue
+
+        edges = np.ascontiguousarray(spectrum.edges, dtype="<f8")
+        key = edges.tobytes()
+        if key not in axis_indices:
+            axis_indices[key] = len(axes)
+            axes.append(encode_float64_array(edges))
+        encoded.append({
+            "runNumber": run,
+            "axis": axis_indices[key],
+            "counts": encode_float64_array(spectrum.counts)
+        })
+        if divisors is not None and run in divisors:
+            encoded[-1]["divisors"] = {
+                name: encode_float64_array(value) if isinstance(value, np.ndarray) else value
+                for name, value in divisors[run].items()
+            }
+
+    return {"axes": axes, "spectra": encoded}
+
+
+@dataclass(frozen=True)
+class Rebinning:
+    """Optional time-of-flight window and rebinning applied to a spectrum"""
+
+    # Number of bins to rebin to, or None to keep the original bins
+    bin_count: Optional[int] = None
+    # Whether new bins should be logarithmically (rather than linearly) spaced
+    logarithmic: bool = False
+    # Time-of-flight window, or None to use the full range
+    tof_min: Optional[float] = None
+    tof_max: Optional[float] = None
+
+    def apply(self, edges: np.ndarray,
+              counts: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+        """Apply the window and rebinning to the supplied spectrum
+
+        If no bin count is given the original bins overlapping the window
+        are returned unchanged. Otherwise, counts are redistributed into
+        the new bins on the assumption that they are spread evenly across
+        each original bin.
+        :param edges: Time-of-flight bin edges
+        :param counts: Counts in each bin
+        :return: Tuple of the new (edges, counts)
+        :raises: ValueError if the window or bin count is invalid
+        """
+        edges = np.asarray(edges, dtype="float64")
+        counts = np.asarray(counts, dtype="float64")
+        tof_min = edges[0] if self.tof_min is None else max(self.tof_min, edges[0])
+        tof_max = edges[-1] if self.tof_max is None else min(self.tof_max, edges[-1])
+        if tof_max <= tof_min:
+            raise ValueError(f"The time-of-flight window {tof_min} to {tof_max} "
+                             f"contains no data.")
+
+        if self.bin_count is None:
+            first = max(int(np.searchsorted(edges, tof_min, side="right")) - 1, 0)
+            last = min(int(np.searchsorted(edges, tof_max, side="left")), len(counts))
+            return edges[first:last + 1], counts[first:last]
+
+        if self.bin_count < 1:
+            raise ValueError(f"Can't rebin to {self.bin_count} bins.")
+        if self.logarithmic:
+            if tof_min <= 0.0:
+                positive = edges[edges > 0.0]
+                if len(positive) == 0 or positive[0] >= tof_max:
+                    raise ValueError("Logarithmic binning requires a positive "
+                                     "time-of-flight window.")
+                tof_min = positive[0]
+            new_edges = np.geomspace(tof_min, tof_max, self.bin_count + 1)
+        else:
+            new_edges = np.linspace(tof_min, tof_max, self.bin_count + 1)
+
+        return new_edges, redistribute(edges, counts, new_edges)
+
+
+def redistribute(edges: np.ndarray, counts: np.ndarray, new_edges: np.ndarray) -> np.ndarray:
+    """Redistribute counts into new bins, on the assumption that they are
+    spread evenly across each original bin
+
+    :param edges: Original time-of-flight bin edges
+    :param counts: Counts in each original bin
+    :param new_edges: New time-of-flight bin edges
+    :return: Counts in each new bin (zero outside of the original bins)
+    """
+    cumulative = np.concatenate(([0.0], np.cumsum(counts)))
+    return np.diff(np.interp(new_edges, edges, cumulative))
+
+
+@dataclass(frozen=True)
+class Normalisation:
+    """Normalisation applied to spectra, as divisors combined in one pass"""
+
+    # Whether to divide by the proton charge of the run (µAh)
+    per_proton_charge: bool = False
+    # Whether to divide by the width of each bin (µs)
+    per_microsecond: bool = False
+    # Monitor of the same run to divide by, if any
+    monitor: Optional[int] = None
+
+    def apply(self, filepath: Path, spectrum: Spectrum,
+              rebinning: Optional[Rebinning] = None,
+              reference: Optional[Spectrum] = None) -> Spectrum:
+        """Return the normalised spectrum
+
+        Monitor and reference spectra are redistributed onto the bins of the
+        spectrum being normalised. Bins whose combined divisor is zero (from
+        a zero bin width, monitor or reference count) keep their raw counts,
+        as they did when spectra were normalised by the frontend.
+        :param filepath: Path to the NeXus file the spectrum came from
+        :param spectrum: Spectrum to normalise
+        :param rebinning: Window / rebinning applied to the spectrum, also
+                          applied to the monitor
+        :param reference: Optional spectrum (e.g. from another run) to divide by
+        :return: The normalised spectrum
+        :raises: ValueError if normalising per proton charge and the run has
+                 none recorded
+        """
+        divisors = self.divisors(filepath, spectrum, rebinning, reference)
+        divisor = np.diff(spectrum.edges) if self.per_microsecond else np.ones_like(spectrum.counts)
+        charge = divisors.pop("protonCharge", None)
+        if charge is not None:
+            if charge <= 0.0:
+                raise ValueError(f"No proton charge is recorded in {Path(filepath).name}")
+            divisor = divisor * charge
+        for other in divisors.values():
+            divisor = divisor * other
+
+        counts = np.divide(spectrum.counts, divisor, out=spectrum.counts.copy(), where=divisor != 0.0)
+        return Spectrum(spectrum.edges, counts)
+
+    def divisors(self, filepath: Path, spectrum: Spectrum,
+                 rebinning: Optional[Rebinning] = None,
+                 reference: Optional[Spectrum] = None) -> Dict[str, Any]:
+        """Return the divisors of the normalisation for the spectrum, other
+        than the bin widths (which follow from its edges), so that they can
+        be combined elsewhere
+
+        :param filepath: Path to the NeXus file the spectrum came from
+        :param spectrum: Spectrum to be normalised
+        :param rebinning: Window / rebinning applied to the spectrum, also
+                          applied to the monitor
+        :param reference: Optional spectrum (e.g. from another run) to divide by
+        :return: Dict of any of "protonCharge" (µAh, zero if not recorded),
+                 "monitor" and "reference" (counts redistributed onto the bins
+                 of the spectrum)
+        """
+        divisors: Dict[str, Any] = {}
+        if self.per_proton_charge:
+            divisors["protonCharge"] = get_proton_charge(filepath)
+        others = {
+            "monitor": cached_spectrum(filepath, "monitor", self.monitor, rebinning)
+            if self.monitor is not None else None,
+            "reference": reference
+        }
+        for name, other in others.items():
+            if other is None:
+                continue
+            if np.array_equal(other.edges, spectrum.edges):
+                divisors[name] = other.counts
+            else:
+                divisors[name] = redistribute(other.edges, other.counts, spectrum.edges)
+        return divisors
+
+
+def spectrum_indices_from_string(text: str) -> Sequence[int]:
+    """Return the sorted, unique spectrum indices described by the text,
+    which is a comma-separated list of indices and ranges (e.g. "1-8,12")
+
+    :raises: ValueError if the text cannot be parsed
+    """
+    indices = set()
+    for item in filter(None, (bit.strip() for bit in text.split(","))):
+        irange = IntegerRange.from_string(item)
+        indices.update(range(irange.first, irange.last + 1))
+    if not indices:
+        raise ValueError(f"No spectra are specified by '{text}'.")
+    return sorted(indices)
+
 
 def logpaths_from_path(filepath: Path) -> Sequence[Sequence[str]]:
     """Return a list of paths to log data within the file at the given path
 
     See logpaths_from_file for full description
     """
-    with h5.File(filepath) as h5file:
+    with FILE_CACHE.open(filepath) as h5file:
         return logpaths_from_file(h5file)
 
 
@@ -81,12 +498,15 @@ def logdata_from_path(filepath: Path, fields: Sequence[str]) -> Sequence[Sequenc
     :param fields: A list of paths to log data in the file
     :return: List in form [[(time,value)...]] for each field
     """
-    h5file = h5.File(filepath)
-    rundata = []
-    for name in fields:
-        rundata.append(h5file[name])
+    with FILE_CACHE.open(filepath) as h5file:
+        return [logvalues(h5file[name]) for name in fields]
 
-    return rundata
+
+def timerange_from_path(filepath: Path) -> Tuple[str, str]:
+    """Return the (start_time, end_time) of the first entry in the file at
+    the given path"""
+    with FILE_CACHE.open(filepath) as h5file:
+        return timerange(group_at(h5file, 0))
 
 
 def timerange(h5group: h5.Group) -> Tuple[str, str]:
@@ -106,13 +526,123 @@ def logvalues(h5group: h5.Group) -> MutableSequence[Tuple[float, float]]:
     :param h5group: An open HDF5 Group containing logged values.
                     Looks for a value or value_log dataset in the group
     """
+    times, values, _ = logvalue_arrays(h5group)
+    return list(zip(times.tolist(), values.tolist()))
+
+
+def logvalue_arrays(h5group: h5.Group,
+                    start: int = 0,
+                    stop: Optional[int] = None) -> Tuple[np.ndarray, np.ndarray, Optional[Sequence[str]]]:
+    """Return the times and values of the given group as float64 arrays
+
+    The datasets are read in bulk. String-valued logs are returned as
+    indices into a sorted list of the distinct strings (categories).
+    :param h5group: An open HDF5 Group containing logged values.
+                    Looks for a value or value_log dataset in the group
+    :param start: Index of the first sample to return
+    :param stop: Index after the last sample to return (default is all)
+    :return: Tuple of (times, values, categories), where categories is None
+             for numeric logs
+    """
     value_log = (
         h5group[NXStrings.ValueLog] if NXStrings.ValueLog in h5group else h5group
     )
-    return [
-        (float(time), float(value))
-        for time, value in zip(value_log["time"], value_log["value"])  # type: ignore
-    ]
+    times = np.asarray(value_log["time"][start:stop], dtype="float64").ravel()
+    raw_values = np.asarray(value_log["value"][start:stop])
+    if raw_values.dtype.kind in ("S", "O", "U"):
+        labels = np.array([value.decode("UTF-8") if isinstance(value, bytes) else str(value)
+                           for value in raw_values.ravel()])
+        categories, indices = np.unique(labels, return_inverse=True)
+        return times, indices.astype("float64"), categories.tolist()
+
+    return times, raw_values.astype("float64").ravel(), None
+
+
+def tail_logvalues(filepath: Path,
+                   log_path: str,
+                   first: int) -> Tuple[int, np.ndarray, np.ndarray, Optional[Sequence[str]]]:
+    """Return log samples appended to a (possibly still being written) file
+
+    The file is held open between calls and its datasets refreshed, so
+    only the new samples are read.
+    :param filepath: A path to a NeXus file
+    :param log_path: Full path to the log group within the file
+    :param first: Index of the first sample to return
+    :return: Tuple of (total, times, values, categories), where total is the
+             number of samples now in the log and categories is None for
+             numeric logs (and otherwise refers only to the samples returned)
+    """
+    with LIVE_FILE_CACHE.open(filepath) as h5file:
+        group = h5file[log_path]
+        value_log = (
+            group[NXStrings.ValueLog] if NXStrings.ValueLog in group else group
+        )
+        for name in ("time", "value"):
+            value_log[name].refresh()
+
+        # The writer may have extended one dataset but not yet the other
+        total = min(len(value_log["time"]), len(value_log["value"]))
+        times, values, categories = logvalue_arrays(group, min(first, total), total)
+        return total, times, values, categories
+
+
+def read_logvalues(
+    filepath: Path,
+    log_paths: Sequence[str]
+) -> Tuple[Tuple[str, str], Dict[str, Tuple[np.ndarray, np.ndarray, Optional[Sequence[str]]]], List[str]]:
+    """Return the time range of the first entry in the file together with the
+    arrays of each of the given logs, reading them all in a single pass
+
+    :param filepath: A path to a NeXus file
+    :param log_paths: Paths to the log groups, relative to the first entry
+    :return: Tuple of (time_range, logs, missing), where logs maps each log
+             path found to its (times, values, categories) and missing lists
+             the log paths not present in the file
+    :raises KeyError: If none of the logs are present in the file
+    """
+    logs = {}
+    missing = []
+    with open_at(filepath, 0) as first_group:
+        time_range = timerange(first_group)
+        for log_path in log_paths:
+            if log_path not in first_group:
+                missing.append(log_path)
+                continue
+            logs[log_path] = logvalue_arrays(first_group[log_path])
+
+    if not logs:
+        raise KeyError(f"None of the requested logs ({', '.join(missing)}) exist")
+    return time_range, logs, missing
+
+
+def log_statistics(filepath: Path, log_path: str) -> Dict[str, Any]:
+    """Return summary statistics of a log in the first entry of the file
+
+    The log is read in bulk. Samples which are not finite are ignored.
+    :param filepath: A path to a NeXus file
+    :param log_path: Path to the log group, relative to the first entry
+    :return: A dict containing the number of samples and their mean, minimum,
+             maximum and last values (None if there are no such samples).
+             For string-valued logs only the last value is given
+    """
+    with open_at(filepath, 0) as first_group:
+        _, values, categories = logvalue_arrays(first_group[log_path])
+
+    statistics = {"samples": int(values.size), "mean": None, "min": None, "max": None, "last": None}
+    if categories is not None:
+        if values.size > 0:
+            statistics["last"] = categories[int(values[-1])]
+        return statistics
+
+    values = values[np.isfinite(values)]
+    if values.size > 0:
+        statistics.update({
+            "mean": float(values.mean()),
+            "min": float(values.min()),
+            "max": float(values.max()),
+            "last": float(values[-1]),
+        })
+    return statistics
 
 
 def get_detector_count(filepath: Path) -> int:
@@ -121,33 +651,124 @@ def get_detector_count(filepath: Path) -> int:
     :param filepath: A path to a NeXus file
     :return: The number of spectra
     """
-    with h5.File(filepath) as h5file:
-        return len(group_at(h5file, 0)[NXStrings.DetectorPrefix + "1"][NXStrings.Counts][0])  # type: ignore
+    with FILE_CACHE.open(filepath) as h5file:
+        # Counts are stored as (period, spectrum, tof) so the shape is all we need
+        return group_at(h5file, 0)[NXStrings.DetectorPrefix + "1"][NXStrings.Counts].shape[1]  # type: ignore
+
+
+def get_detector_bin_count(filepath: Path) -> int:
+    """Return the number of time-of-flight bins in detector_1
+
+    :param filepath: A path to a NeXus file
+    :return: The number of bins in each spectrum
+    """
+    with FILE_CACHE.open(filepath) as h5file:
+        return group_at(h5file, 0)[NXStrings.DetectorPrefix + "1"][NXStrings.Counts].shape[2]  # type: ignore
 
 
 def get_detector_spectrum(filepath: Path,
-                          spectrum: int) -> Sequence[Tuple[float, float]]:
-    """Return a single spectra of data from a file as a list of (tof,signal) pairs
+                          spectrum: int,
+                          rebinning: Optional[Rebinning] = None) -> Spectrum:
+    """Return a single spectrum of data from a file
 
-    If the TOF values are bin edges then they are converted to bin centres.
-    :param filepath: _description_
-    :param spectrum: _description_
-    :return: A list of (tof,signal) pairs as float64
+    :param filepath: A path to a NeXus file
+    :param spectrum: Index of the spectrum to return
+    :param rebinning: Optional window / rebinning to apply
+    :return: The spectrum as float64 arrays
     """
-    with h5.File(filepath) as h5file:
+    with FILE_CACHE.open(filepath) as h5file:
         det1 = group_at(h5file, 0)[NXStrings.DetectorPrefix + "1"]
-        return _tof_signal_points(
-            det1[NXStrings.ToF], det1[NXStrings.Counts][0][spectrum]
+        # Read only the single (period 0) spectrum row rather than the whole counts block
+        return _tof_spectrum(
+            det1[NXStrings.ToF], det1[NXStrings.Counts][0, spectrum, :], rebinning
         )
 
 
+def get_detector_spectra_sum(filepath: Path,
+                             spectra: Sequence[int],
+                             rebinning: Optional[Rebinning] = None) -> Spectrum:
+    """Return the sum of several detector spectra from a file
+
+    :param filepath: A path to a NeXus file
+    :param spectra: Sorted, unique indices of the spectra to sum
+    :param rebinning: Optional window / rebinning to apply
+    :return: The summed spectrum as float64 arrays
+    :raises: ValueError if any of the spectra do not exist
+    """
+    with FILE_CACHE.open(filepath) as h5file:
+        det1 = group_at(h5file, 0)[NXStrings.DetectorPrefix + "1"]
+        counts = det1[NXStrings.Counts]
+        if spectra[0] < 0 or spectra[-1] >= counts.shape[1]:
+            raise ValueError(f"Spectra must be in the range 0 to {counts.shape[1] - 1}.")
+
+        # Sum a block of spectra at a time, reading contiguous runs of indices as single slices
+        total = np.zeros(counts.shape[2], dtype="float64")
+        indices = np.asarray(spectra)
+        breaks = np.flatnonzero(np.diff(indices) != 1) + 1
+        for run in np.split(indices, breaks):
+            for first in range(run[0], run[-1] + 1, _SPECTRUM_BLOCK_SIZE):
+                last = min(first + _SPECTRUM_BLOCK_SIZE, run[-1] + 1)
+                total += counts[0, first:last, :].sum(axis=0)
+
+        return _tof_spectrum(det1[NXStrings.ToF], total, rebinning)
+
+
+def read_spectrum(filepath: Path, spectrum_type: str, spectrum: Union[int, Sequence[int]],
+                  rebinning: Optional[Rebinning] = None) -> Spectrum:
+    """Return a monitor spectrum, detector spectrum, or sum of detector
+    spectra from a file
+
+    :param filepath: A path to a NeXus file
+    :param spectrum_type: Either "monitor" or "detector"
+    :param spectrum: Monitor number or detector spectrum index, or a sorted
+                     sequence of detector spectrum indices to sum
+    :param rebinning: Optional window / rebinning to apply
+    :return: The spectrum as float64 arrays
+    :raises: ValueError if the spectrum type is not recognised
+    """
+    if spectrum_type == "monitor":
+        return get_monitor_spectrum(filepath, int(spectrum), rebinning)
+    elif spectrum_type == "detector" and isinstance(spectrum, int):
+        return get_detector_spectrum(filepath, spectrum, rebinning)
+    elif spectrum_type == "detector":
+        return get_detector_spectra_sum(filepath, spectrum, rebinning)
+
+    raise ValueError(f"Unrecognised spectrum type '{spectrum_type}'.")
+
+
+def cached_spectrum(filepath: Path, spectrum_type: str, spectrum: Union[int, Sequence[int]],
+                    rebinning: Optional[Rebinning] = None) -> Spectrum:
+    """Return a spectrum as read_spectrum, reusing recent reads of the same
+    spectrum while the file is unchanged
+
+    Used for the monitor and reference spectra which others are normalised
+    against, which are typically requested repeatedly. The returned arrays
+    are shared, and must not be modified.
+    """
+    key = spectrum if isinstance(spectrum, int) else tuple(spectrum)
+    return _cached_spectrum(str(filepath), os.stat(filepath).st_mtime_ns, spectrum_type, key, rebinning)
+
+
+def get_proton_charge(filepath: Path) -> float:
+    """Return the proton charge (µAh) of the first entry in the file
+
+    :param filepath: A path to a NeXus file
+    :return: The proton charge, or zero if it is not recorded
+    """
+    with FILE_CACHE.open(filepath) as h5file:
+        first_group = group_at(h5file, 0)
+        if NXStrings.ProtonCharge not in first_group:
+            return 0.0
+        return float(first_group[NXStrings.ProtonCharge][0])
+
+
 def get_monitor_count(filepath: Path) -> int:
     """Return the number of monitors in the first group
 
     :param filepath: A path to a NeXus file
     :return: The number of spectra
     """
-    with h5.File(filepath) as h5file:
+    with FILE_CACHE.open(filepath) as h5file:
         first_group = group_at(h5file, 0)
         return len(
             [key for key in first_group.keys() if _MonitorRE.match(key) is not None]
@@ -155,38 +776,135 @@ def get_monitor_count(filepath: Path) -> int:
 
 
 def get_monitor_spectrum(filepath: Path,
-                         monitor: int) -> Sequence[Tuple[float, float]]:
-    """Return a single monitor spectrum from a file as a list of (tof,signal)
-    pairs
+                         monitor: int,
+                         rebinning: Optional[Rebinning] = None) -> Spectrum:
+    """Return a single monitor spectrum from a file
 
-    If the TOF values are bin edges then they are converted to bin centres.
     :param filepath: Path to a HDF5 file
     :param monitor: The number of the monitor whose data should be returned
-    :return: A list of (tof,signal) pairs as float64
+    :param rebinning: Optional window / rebinning to apply
+    :return: The spectrum as float64 arrays
     """
-    with h5.File(filepath) as h5file:
+    with FILE_CACHE.open(filepath) as h5file:
         monitor_group = group_at(h5file, 0)[NXStrings.MonitorPrefix + str(monitor)]
-        return _tof_signal_points(
-            monitor_group[NXStrings.ToF], monitor_group[NXStrings.Data][0][0]
+        return _tof_spectrum(
+            monitor_group[NXStrings.ToF], monitor_group[NXStrings.Data][0, 0, :], rebinning
         )
 
 
+def detector_health(filepath: Path) -> Dict[str, Any]:
+    """Return a summary of the counts recorded in detector_1
+
+    Counts are read a block of spectra at a time so that memory use is
+    bounded regardless of the size of the detector.
+    :param filepath: A path to a NeXus file
+    :return: A dict containing the number of spectra, the number of those
+             with non-zero counts, the total counts, the total counts per µAh
+             of proton charge (None if no charge was recorded), and the
+             maximum count in any single bin
+    """
+    with FILE_CACHE.open(filepath) as h5file:
+        counts = group_at(h5file, 0)[NXStrings.DetectorPrefix + "1"][NXStrings.Counts]
+        n_spectra = counts.shape[1]
+
+        non_zero_count = 0
+        total_counts = 0
+        max_count = 0
+        for first in range(0, n_spectra, _SPECTRUM_BLOCK_SIZE):
+            block = counts[0, first:first + _SPECTRUM_BLOCK_SIZE, :]
+            sums = np.sum(block, axis=1, dtype=np.int64)
+            non_zero_count += int(np.count_nonzero(sums))
+            total_counts += int(sums.sum())
+            if block.size > 0:
+                max_count = max(max_count, int(block.max()))
+
+    proton_charge = get_proton_charge(filepath)
+    return {
+        "spectra": n_spectra,
+        "nonZeroSpectra": non_zero_count,
+        "totalCounts": total_counts,
+        "countsPerMicroAmpHour": total_counts / proton_charge if proton_charge > 0 else None,
+        "maxCount": max_count,
+    }
+
+
 def nonzero_spectra_ratio(filepath: Path) -> str:
     """Return the ratio of number of (non_zero spectra/spectra_count)
 
     :param filepath: A path to a NeXus file
     :return: The nonzero_spectra ratio
     """
-    with h5.File(filepath) as h5file:
-        counts = group_at(h5file, 0)[NXStrings.DetectorPrefix + "1"][NXStrings.Counts]  # type: ignore
-        non_zero_count = np.count_nonzero(np.sum(counts[0], axis=1))  # type: ignore
-        return f"{non_zero_count}/{len(counts[0])}"  # type: ignore
+    health = detector_health(filepath)
+    return f"{health['nonZeroSpectra']}/{health['spectra']}"
 
 
-def open_at(filepath: Path, index: int) -> Tuple[h5.File, h5.Group]:
-    """Return the group at the index given"""
-    h5file = h5.File(filepath)
-    return h5file, group_at(h5file, index)
+def get_detector_map_info(filepath: Path, tile_size: int = DETECTOR_MAP_TILE_SIZE,
+                          max_count: Optional[int] = None) -> Dict[str, Any]:
+    """Return the layout of the detector map tile pyramid for detector_1
+
+    Level 0 of the pyramid is the full resolution (spectrum, tof) counts
+    array. Each subsequent level halves the resolution along both axes,
+    until the whole map fits within a single tile.
+    :param filepath: A path to a NeXus file
+    :param tile_size: Number of bins along each side of a tile
+    :param max_count: Maximum count in any single bin, if already known
+                      (finding it requires a read of the full counts)
+    :return: A dict describing the map dimensions, the number of levels,
+             the maximum count in any single bin, and the time-of-flight
+             bin edges
+    """
+    if max_count is None:
+        max_count = detector_health(filepath)["maxCount"]
+
+    with FILE_CACHE.open(filepath) as h5file:
+        det1 = group_at(h5file, 0)[NXStrings.DetectorPrefix + "1"]
+        counts = det1[NXStrings.Counts]
+        n_spectra, n_bins = counts.shape[1], counts.shape[2]
+
+        return {
+            "spectra": n_spectra,
+            "bins": n_bins,
+            "tileSize": tile_size,
+            "levels": _detector_map_levels(n_spectra, n_bins, tile_size),
+            "maxCount": max_count,
+            "timeOfFlight": det1[NXStrings.ToF][()].astype("float64").tolist(),
+        }
+
+
+def get_detector_map_tile(filepath: Path, level: int, row: int, column: int,
+                          tile_size: int = DETECTOR_MAP_TILE_SIZE) -> Dict[str, Any]:
+    """Return a single tile of the detector map tile pyramid for detector_1
+
+    Each value in the tile is the mean count over the (2^level x 2^level)
+    block of (spectrum, tof) bins that it covers, or over the part of it
+    lying within the map for blocks at its edges. Tiles at the edges of the
+    map may be smaller than tile_size. Values are encoded as by
+    encode_float64_array, in row-major order.
+    :param filepath: A path to a NeXus file
+    :param level: Pyramid level, with 0 being full resolution
+    :param row: Tile row (spectrum axis) within the level
+    :param column: Tile column (tof axis) within the level
+    :param tile_size: Number of bins along each side of a tile
+    :return: A dict containing the tile location, shape and mean counts
+    :raises: ValueError if the tile does not exist
+    """
+    stat = Path(filepath).stat()
+    data = _detector_map_tile(str(filepath), stat.st_mtime_ns, level, row,
+                              column, tile_size)
+    return {
+        "level": level,
+        "row": row,
+        "column": column,
+        "shape": list(data.shape),
+        "data": encode_float64_array(data),
+    }
+
+
+@contextmanager
+def open_at(filepath: Path, index: int) -> Iterator[h5.Group]:
+    """Yield the group at the index given from the (cached) file"""
+    with FILE_CACHE.open(filepath) as h5file:
+        yield group_at(h5file, index)
 
 
 def group_at(h5file: h5.File, index: int) -> h5.Group:
@@ -197,18 +915,72 @@ def group_at(h5file: h5.File, index: int) -> h5.Group:
 # private helpers
 
 
-def _tof_signal_points(
-    tof_bins: h5.Dataset, counts: h5.Dataset
-) -> Sequence[Tuple[float, float]]:
-    """Take 2 datasets of binned TOF values and point count values
-    and convert to a single list of (tof,signal) pairs where tof is the bin centre
+@lru_cache(maxsize=64)
+def _cached_spectrum(filepath: str, mtime: int, spectrum_type: str,
+                     spectrum: Union[int, Tuple[int, ...]],
+                     rebinning: Optional[Rebinning]) -> Spectrum:
+    """Read a spectrum, cached on path, modification time and arguments"""
+    return read_spectrum(filepath, spectrum_type, spectrum, rebinning)
+
+
+def _detector_map_levels(n_spectra: int, n_bins: int, tile_size: int) -> int:
+    """Return the number of levels in a detector map tile pyramid"""
+    extent = max(n_spectra, n_bins, 1)
+    return 1 + max(0, math.ceil(math.log2(extent / tile_size)))
+
+
+# Tiles are at most 512 KiB (256 x 256 float64), so this holds about 16 MiB
+@lru_cache(maxsize=32)
+def _detector_map_tile(filepath: str, mtime: int, level: int, row: int,
+                       column: int, tile_size: int) -> np.ndarray:
+    """Read and bin a single detector map tile. The file modification time
+    forms part of the cache key so that tiles are recalculated if the file
+    changes.
+    """
+    with FILE_CACHE.open(filepath) as h5file:
+        counts = group_at(h5file, 0)[NXStrings.DetectorPrefix + "1"][NXStrings.Counts]
+        n_spectra, n_bins = counts.shape[1], counts.shape[2]
+        if not 0 <= level < _detector_map_levels(n_spectra, n_bins, tile_size):
+            raise ValueError(f"Detector map level {level} does not exist.")
+
+        # Read only the region of the dataset covered by the tile
+        factor = 2 ** level
+        span = tile_size * factor
+        first_spectrum, first_bin = row * span, column * span
+        if row < 0 or column < 0 or first_spectrum >= n_spectra or first_bin >= n_bins:
+            raise ValueError(f"Detector map tile ({row}, {column}) does not "
+                             f"exist at level {level}.")
+        block = counts[0,
+                       first_spectrum:min(first_spectrum + span, n_spectra),
+                       first_bin:min(first_bin + span, n_bins)].astype("int64")
+
+    # Pad to a whole number of blocks and sum each (factor x factor) block
+    rows, columns = -(-block.shape[0] // factor), -(-block.shape[1] // factor)
+    padded = np.zeros((rows * factor, columns * factor), dtype="int64")
+    padded[:block.shape[0], :block.shape[1]] = block
+    sums = padded.reshape(rows, factor, columns, factor).sum(axis=(1, 3))
+
+    # Divide by the number of bins actually covered, which is smaller for
+    # blocks overhanging the edges of the map
+    row_bins = np.minimum(factor, block.shape[0] - factor * np.arange(rows))
+    column_bins = np.minimum(factor, block.shape[1] - factor * np.arange(columns))
+    return sums / np.outer(row_bins, column_bins)
+
+
+def _tof_spectrum(
+    tof_bins: h5.Dataset, counts: h5.Dataset, rebinning: Optional[Rebinning] = None
+) -> Spectrum:
+    """Take 2 datasets of binned TOF values and point count values and
+    convert them to a float64 spectrum
 
     :param tof_bins: Bin edge values for ToF
     :param counts: Count values
-    :return: A single list of (tof,signal) pairs where tof is the bin centre
+    :param rebinning: Optional window / rebinning to apply
+    :return: The spectrum
     """
-    tof_centres = 0.5 * (tof_bins[1:] + tof_bins[:-1])
-    return [
-        (tof.astype("float64"), count.astype("float64"))
-        for tof, count in zip(tof_centres, counts)
-    ]
+    edges = np.asarray(tof_bins, dtype="float64")
+    signal = np.asarray(counts, dtype="float64")
+    if rebinning is not None:
+        edges, signal = rebinning.apply(edges, signal)
+
+    return Spectrum(edges, signal)
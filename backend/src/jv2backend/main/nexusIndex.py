@@ -0,0 +1,216 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+"""Persistent index of per-file NeXus metadata.
+
+Metadata which is costly to determine (requiring a walk of the group
+hierarchy or a read of the detector counts) is recorded in an SQLite
+database in the user data directory. Entries are keyed by file path and
+discarded when the size or modification time of the file changes.
+"""
+from pathlib import Path
+from platformdirs import user_data_dir
+import json
+import logging
+import os
+import sqlite3
+import threading
+from typing import Any, Callable, Dict, Optional, Sequence
+
+import jv2backend.main.nexus
+import jv2backend.main.userCache
+
+# Name of the index database in the user data directory
+INDEX_FILENAME = "nexus_index.sqlite3"
+
+# Metadata recorded for each file, and the functions used to determine it
+FIELDS: Dict[str, Callable[[Path], Any]] = {
+    "logPaths": jv2backend.main.nexus.logpaths_from_path,
+    "monitorCount": jv2backend.main.nexus.get_monitor_count,
+    "spectrumCount": jv2backend.main.nexus.get_detector_count,
+    "tofBinCount": jv2backend.main.nexus.get_detector_bin_count,
+    "timeRange": jv2backend.main.nexus.timerange_from_path,
+    "detectorHealth": jv2backend.main.nexus.detector_health,
+}
+
+# Fields cheap enough to record while generating journals (detectorHealth
+# requires a read of the full detector counts)
+GENERATION_FIELDS = ("logPaths", "monitorCount", "spectrumCount", "tofBinCount", "timeRange")
+
+_SCHEMA = """
+    CREATE TABLE IF NOT EXISTS files (
+        path TEXT PRIMARY KEY,
+        size INTEGER NOT NULL,
+        mtime_ns INTEGER NOT NULL
+    );
+    CREATE TABLE IF NOT EXISTS metadata (
+        path TEXT NOT NULL REFERENCES files(path) ON DELETE CASCADE,
+        name TEXT NOT NULL,
+        value TEXT NOT NULL,
+        PRIMARY KEY (path, name)
+    );
+"""
+
+
+class NexusIndex:
+    """SQLite-backed store of metadata values for individual NeXus files.
+
+    Values are stored as JSON. A single connection is shared between
+    threads and serialised with a lock, while the (slow) determination of
+    missing values takes place outside of it.
+    """
+
+    def __init__(self, database: str = ":memory:"):
+        self._lock = threading.Lock()
+        self._connection = sqlite3.connect(database, timeout=30, check_same_thread=False)
+        with self._lock, self._connection:
+            if database != ":memory:":
+                self._connection.execute("PRAGMA journal_mode=WAL")
+            self._connection.execute("PRAGMA foreign_keys=ON")
+            self._connection.executescript(_SCHEMA)
+
+    def get(self, filepath: Path, name: str, determine: Callable[[Path], Any]) -> Any:
+        """Return the named metadata value for the file, determining and
+        recording it if it is not present or out of date
+
+        :param filepath: A path to a NeXus file
+        :param name: Name of the metadata value
+        :param determine: Function returning the value from the file
+        :raises: FileNotFoundError if the file does not exist
+        """
+        stat = os.stat(filepath)
+        with self._lock:
+            row = self._connection.execute(
+                "SELECT metadata.value FROM metadata JOIN files USING (path) "
+                "WHERE path = ? AND name = ? AND size = ? AND mtime_ns = ?",
+                (str(filepath), name, stat.st_size, stat.st_mtime_ns)
+            ).fetchone()
+        if row is not None:
+            return json.loads(row[0])
+
+        value = determine(filepath)
+        self.put(filepath, {name: value}, stat)
+        return value
+
+    def put(self, filepath: Path, values: Dict[str, Any],
+            stat: Optional[os.stat_result] = None) -> None:
+        """Record metadata values for the file
+
+        Any existing values are discarded if the file has changed since they
+        were recorded.
+        :param filepath: A path to a NeXus file
+        :param values: Dict of metadata names and values
+        :param stat: Status of the file at the time the values were
+                     determined, if already known
+        """
+        stat = os.stat(filepath) if stat is None else stat
+        path = str(filepath)
+        with self._lock, self._connection:
+            row = self._connection.execute(
+                "SELECT size, mtime_ns FROM files WHERE path = ?", (path,)
+            ).fetchone()
+            if row != (stat.st_size, stat.st_mtime_ns):
+                self._connection.execute("DELETE FROM files WHERE path = ?", (path,))
+                self._connection.execute(
+                    "INSERT INTO files (path, size, mtime_ns) VALUES (?, ?, ?)",
+                    (path, stat.st_size, stat.st_mtime_ns)
+                )
+            self._connection.executemany(
+                "INSERT OR REPLACE INTO metadata (path, name, value) VALUES (?, ?, ?)",
+                [(path, name, json.dumps(value)) for name, value in values.items()]
+            )
+
+    def __len__(self) -> int:
+        with self._lock:
+            return self._connection.execute("SELECT COUNT(*) FROM files").fetchone()[0]
+
+    def close(self) -> None:
+        """Close the underlying database connection"""
+        with self._lock:
+            self._connection.close()
+
+
+# Index shared by all routes, if activated
+_INDEX: Optional[NexusIndex] = None
+
+
+def initialise(database: Optional[str] = None) -> None:
+    """Open (creating if necessary) the index database, by default in the
+    user data directory"""
+    global _INDEX
+    if database is None:
+        directory = Path(user_data_dir(jv2backend.main.userCache.CACHE_APP_NAME,
+                                       jv2backend.main.userCache.CACHE_APP_AUTHORS))
+        directory.mkdir(parents=True, exist_ok=True)
+        database = str(directory / INDEX_FILENAME)
+
+    try:
+        _INDEX = NexusIndex(database)
+    except sqlite3.Error as exc:
+        logging.error(f"Couldn't open NeXus index {database}: {str(exc)}")
+        _INDEX = None
+
+
+def lookup(filepath: Path, name: str) -> Any:
+    """Return the named metadata value for the file, from the index if
+    possible
+
+    :param filepath: A path to a NeXus file
+    :param name: Name of the metadata value (see FIELDS)
+    """
+    if _INDEX is None:
+        return FIELDS[name](filepath)
+
+    return _INDEX.get(filepath, name, FIELDS[name])
+
+
+def log_statistics(filepath: Path, log_path: str) -> Dict[str, Any]:
+    """Return summary statistics of the log in the file, from the index if
+    possible
+
+    :param filepath: A path to a NeXus file
+    :param log_path: Path to the log group, relative to the first entry
+    """
+    if _INDEX is None:
+        return jv2backend.main.nexus.log_statistics(filepath, log_path)
+
+    return _INDEX.get(filepath, f"logStatistics:{log_path}",
+                      lambda path: jv2backend.main.nexus.log_statistics(path, log_path))
+
+
+def detector_health(filepath: Path) -> Dict[str, Any]:
+    """Return the summary of the detector_1 counts, from the index if
+    possible
+
+    :param filepath: A path to a NeXus file
+    """
+    return lookup(filepath, "detectorHealth")
+
+
+def nonzero_spectra_ratio(filepath: Path) -> str:
+    """Return the ratio of non-zero to total spectra as a string, derived
+    from the indexed detector health
+
+    :param filepath: A path to a NeXus file
+    """
+    health = detector_health(filepath)
+    return f"{health['nonZeroSpectra']}/{health['spectra']}"
+
+
+def detector_map_info(filepath: Path) -> Dict[str, Any]:
+    """Return the layout of the detector map tile pyramid, taking the
+    maximum count from the indexed detector health so that the full counts
+    are read at most once per file
+
+    :param filepath: A path to a NeXus file
+    """
+    return jv2backend.main.nexus.get_detector_map_info(filepath, max_count=detector_health(filepath)["maxCount"])
+
+
+def populate(filepath: Path, names: Sequence[str] = GENERATION_FIELDS) -> None:
+    """Make sure that the named metadata values for the file are indexed"""
+    if _INDEX is None:
+        return
+
+    for name in names:
+        _INDEX.get(filepath, name, FIELDS[name])
@@ -0,0 +1,227 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+"""Background searching of all journals in a collection.
+
+Journals whose run data are already loaded are searched at once through the
+collection's search index. The remainder are loaded and searched by a pool of
+workers, the matches from each being made available as soon as its journal
+completes so that results can be displayed while the search continues.
+The search terms are checked before any journal is loaded, and a journal
+which cannot be loaded or searched is reported against its filename without
+ending the search.
+
+Matches are fed through a TopRuns heap as each chunk is found, so that only
+the leading matches (up to the limit given when the search is started) are
+retained, in sort order or by decreasing similarity to a search term, and the
+rest are only counted. Matches are returned a page at a time. Sorted or
+ranked matches are only returned once the search completes, since their order
+may change until then.
+"""
+from concurrent.futures import ThreadPoolExecutor, as_completed
+import itertools
+import logging
+from threading import Thread, Event, Lock
+from typing import Any, Dict, List, Optional
+
+import requests
+import lxml.etree as etree
+
+from jv2backend.classes.collection import JournalCollection
+from jv2backend.classes.journal import Journal
+from jv2backend.classes.searchIndex import TopRuns
+import jv2backend.main.selector
+
+# Worker threads loading and searching journals at once, mostly waiting on
+# network retrieval
+MAX_SEARCH_WORKERS = 8
+
+# Number of leading matches retained by a search if no limit is given
+DEFAULT_MATCH_LIMIT = 10000
+
+# Errors on loading or searching a single journal, which are recorded against
+# that journal while the search continues
+_JOURNAL_ERRORS = (requests.HTTPError, requests.ConnectionError, FileNotFoundError,
+                   etree.XMLSyntaxError, ValueError, RuntimeError)
+
+
+class SearchThread(Thread):
+    """Thread searching the journals of a collection"""
+
+    def __init__(self, search_id: int, collection: JournalCollection, search_terms: Dict[str, str],
+                 case_sensitive: bool, sort_by: Optional[str] = None, limit: int = DEFAULT_MATCH_LIMIT):
+        Thread.__init__(self, daemon=True)
+        self.search_id = search_id
+        self._collection = collection
+        self._search_terms = search_terms
+        self._case_sensitive = case_sensitive
+        self._sort_by = sort_by
+        # Term by whose similarity unsorted matches are ranked, if any
+        self._rank_term = None if sort_by else next(
+            ((field[:-len(jv2backend.main.selector.SIMILAR_SUFFIX)], value) for field, value in search_terms.items()
+             if field.endswith(jv2backend.main.selector.SIMILAR_SUFFIX)), None)
+        self._journals: List[Journal] = list(collection.journals)
+        self._stop_event = Event()
+        self._lock = Lock()
+        self._matches = self._top_runs(limit)
+        self._errors: Dict[str, str] = {}
+        self._num_completed = 0
+        self._complete = False
+
+    def run(self):
+        # Check the search terms once, before any journals are loaded
+        try:
+            self._collection.check_search_terms(self._search_terms)
+        except (ValueError, RuntimeError) as exc:
+            with self._lock:
+                self._errors["searchTerms"] = str(exc)
+                self._complete = True
+            return
+
+        # Journals already loaded are answered together from the index
+        loaded = [journal for journal in self._journals if journal.is_loaded()]
+        try:
+            self._search_journals(loaded)
+        except _JOURNAL_ERRORS as exc:
+            self._add_errors(loaded, exc)
+
+        # Load and search the remainder in parallel, streaming the matches from each as they are found
+        pending = [journal for journal in self._journals if not journal.is_loaded()]
+        with self._collection.batched_index_writes(), \
+                ThreadPoolExecutor(max_workers=MAX_SEARCH_WORKERS, thread_name_prefix="search") as executor:
+            futures = {executor.submit(self._search_journals, [journal]): journal for journal in pending}
+            for future in as_completed(futures):
+                if self._stop_event.is_set():
+                    for other in futures:
+                        other.cancel()
+                    break
+                try:
+                    future.result()
+                except _JOURNAL_ERRORS as exc:
+                    self._add_errors([futures[future]], exc)
+
+        with self._lock:
+            self._complete = True
+
+    def _top_runs(self, limit: int) -> TopRuns:
+        """Return the heap retaining the leading matches, in sort order or
+        by decreasing similarity to the ranking term"""
+        if self._rank_term is None:
+            return TopRuns.sorted_by(self._sort_by, limit)
+
+        field, value = self._rank_term
+        search_trigrams = jv2backend.main.selector.trigrams(value)
+        return TopRuns(limit, lambda data: jv2backend.main.selector.similarity(
+            search_trigrams, jv2backend.main.selector.trigrams(data.get(field, ""))), descending=True)
+
+    def _search_journals(self, journals: List[Journal]) -> None:
+        """Load and search journals, recording their matches a chunk at a
+        time, unless the search is stopping"""
+        if not self._stop_event.is_set():
+            for matches in self._collection.search_journals_in_chunks(journals, self._search_terms,
+                                                                      self._case_sensitive):
+                with self._lock:
+                    self._matches.add(matches.values())
+        with self._lock:
+            self._num_completed += len(journals)
+
+    def _add_errors(self, journals: List[Journal], exc: Exception) -> None:
+        """Record the error on searching one or more journals, which are
+        counted as completed"""
+        with self._lock:
+            for journal in journals:
+                logging.debug(f"Failed to search journal {journal.filename}: {str(exc)}")
+                self._errors[journal.filename] = str(exc)
+            self._num_completed += len(journals)
+
+    def stop(self) -> None:
+        """Request that the thread stops, abandoning journals not yet started"""
+        self._stop_event.set()
+
+    def get_update(self, first: int = 0, limit: Optional[int] = None) -> Dict[str, Any]:
+        """Return progress and a page of matches from the specified index
+
+        :param first: Index of the first match to return
+        :param limit: Maximum number of matches to return, or None for all
+        """
+        with self._lock:
+            num_matches = self._matches.total
+            if self._complete:
+                total_estimate = num_matches
+            elif self._num_completed > 0:
+                total_estimate = round(num_matches * len(self._journals) / self._num_completed)
+            else:
+                total_estimate = None
+
+            return {
+                "searchId": self.search_id,
+                "numJournals": len(self._journals),
+                "numCompleted": self._num_completed,
+                "complete": self._complete,
+                "stopped": self._stop_event.is_set(),
+                "errors": dict(self._errors),
+                "numMatches": num_matches,
+                "numRetained": self._matches.retained,
+                "totalEstimate": total_estimate,
+                "sortBy": self._sort_by,
+                "first": first,
+                "results": ([] if (self._sort_by or self._rank_term) and not self._complete
+                            else self._matches.runs(first, limit))
+            }
+
+
+class JournalSearcher:
+    """Runs a single background search at a time"""
+
+    def __init__(self) -> None:
+        self._lock = Lock()
+        self._ids = itertools.count(1)
+        self._thread: Optional[SearchThread] = None
+
+    def start(self, collection: JournalCollection, search_terms: Dict[str, str],
+              sort_by: Optional[str] = None, limit: int = DEFAULT_MATCH_LIMIT) -> Dict[str, Any]:
+        """Start searching the collection, stopping any other search
+
+        :param collection: Collection whose journals are to be searched
+        :param search_terms: Dict of search field/values, possibly including
+                             the 'caseSensitive' flag
+        :param sort_by: Field by which to sort matches, prefixed with '-' for
+                        descending order, or None to return them as found
+        :param limit: Number of leading matches to retain, the rest being
+                      only counted
+        :return: The initial progress of the search, including its ID
+        """
+        search_terms, case_sensitive = JournalCollection.parse_search_terms(search_terms)
+        with self._lock:
+            if self._thread is not None:
+                self._thread.stop()
+            self._thread = SearchThread(next(self._ids), collection, search_terms, case_sensitive, sort_by,
+                                        limit)
+            self._thread.start()
+            logging.debug(f"Started search {self._thread.search_id} for {search_terms} "
+                          f"over {collection.get_journal_count()} journals...")
+            return self._thread.get_update(0, 0)
+
+    def get_update(self, search_id: int, first: int = 0, limit: Optional[int] = None) -> Optional[Dict[str, Any]]:
+        """Return progress and a page of matches of the search with the
+        specified ID
+
+        :param search_id: ID of the search
+        :param first: Index of the first match to return
+        :param limit: Maximum number of matches to return, or None for all
+        :return: The progress of the search, or None if it is not the current one
+        """
+        with self._lock:
+            thread = self._thread
+        if thread is None or thread.search_id != search_id:
+            return None
+        return thread.get_update(first, limit)
+
+    def stop(self, search_id: int) -> bool:
+        """Stop the search with the specified ID, returning whether it was
+        the current one"""
+        with self._lock:
+            if self._thread is None or self._thread.search_id != search_id:
+                return False
+            self._thread.stop()
+            return True
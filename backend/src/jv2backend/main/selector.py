@@ -2,12 +2,27 @@
 # Copyright (c) 2024 Team JournalViewer and contributors
 
 import datetime
+import functools
+import re
+import typing
 from jv2backend.classes.integerRange import IntegerRange
 
 # Format of start time search string
 USERINPUT_DT_FORMAT_STR = "%Y/%m/%d"
 UNIX_DT_FORMAT_STR = "%Y-%m-%dT%H:%M:%S"
 
+# Suffix to a field name requesting that values similar to the search string
+# are matched, rather than those containing it
+SIMILAR_SUFFIX = "~"
+
+# Minimum similarity (Dice coefficient of trigrams) of a field to a search
+# string for it to be considered similar. This accepts, for example, "LCO 10 K"
+# for "La2CuO4 10K" (0.29), while a short string shares too few trigrams with
+# a longer field to match it
+SIMILARITY_THRESHOLD = 0.25
+
+_WORD_REGEX = re.compile(r"\w+")
+
 def _to_datetime(user_input: str, input_format: str) -> datetime.datetime:
     """Convert from a string of specified format to a datetime object"""
     return datetime.datetime.strptime(user_input, input_format)
@@ -58,114 +73,170 @@ def _query_string_equals(
             results[run] = data[run]
     return results
 
-def _query_integer_in_range(
+def trigrams(text: str) -> typing.Set[str]:
+    """Return the distinct (lower case) trigrams of the words in the text.
+
+    Each word is padded with two leading spaces and one trailing space, so
+    that short words still have trigrams and word beginnings weigh more than
+    their endings.
+    """
+    result = set()
+    for word in _WORD_REGEX.findall(text.lower()):
+        result.update(_word_trigrams(word))
+    return result
+
+
+@functools.lru_cache(maxsize=65536)
+def _word_trigrams(word: str) -> typing.FrozenSet[str]:
+    """Return the trigrams of the padded word. Words recur across many
+    titles, so are cached."""
+    padded = f"  {word} "
+    return frozenset(padded[i:i + 3] for i in range(len(padded) - 2))
+
+
+def similarity(search_trigrams: typing.Set[str], text_trigrams: typing.Set[str]) -> float:
+    """Return the Dice coefficient of the search and text trigrams - twice
+    the number shared over the total number in both. The measure is
+    symmetric, so that neither a short search string nor a long text
+    matches merely by being contained in the other."""
+    if not search_trigrams or not text_trigrams:
+        return 0.0
+    return 2 * len(search_trigrams & text_trigrams) / (len(search_trigrams) + len(text_trigrams))
+
+
+def _query_string_similar(
         data: {}, field: str, value: str, case_sensitive: bool
 ) -> {}:
-    """Return a dict of run data whose specified field, when converted to an
-    int, falls within the range specified in the value parameter. It is
-    assumed that the field can be reliably converted to an int, and the search
-    is inclusive.
+    """Return a dict of run data whose specified field is similar to the
+    string provided, most similar first. Similarity is measured by the
+    trigrams shared by the string and the field (see similarity()), so
+    that differences in spacing, punctuation, word order, and small typing
+    errors are tolerated.
 
     :param data: A dict of input run data
-    :param field: The name of the field that should be matched
+    :param field: The name of the field that should be matched, suffixed
+                  with SIMILAR_SUFFIX
+    :param value: Text to search
+    :param case_sensitive: <Unused, required by API>
+    :return: A dict with matching runs, ordered by decreasing similarity
+    """
+    field = field[:-len(SIMILAR_SUFFIX)]
+    search_trigrams = trigrams(value)
+    scores = {}
+    for run in data:
+        if field not in data[run]:
+            continue
+        score = similarity(search_trigrams, trigrams(data[run][field]))
+        if score >= SIMILARITY_THRESHOLD:
+            scores[run] = score
+
+    return {run: data[run] for run in sorted(scores, key=lambda run: -scores[run])}
+
+def integer_bounds(value: str) -> typing.Optional[typing.Tuple[typing.Optional[int], typing.Optional[int]]]:
+    """Return the inclusive (first, last) bounds of the integer range given
+    in the value, either of which is None if the range is open at that end.
+
     :param value: Integer range, which can be of the following construction:
                    N-M - A range of N to M inclusive
                    <N  - Any number less than N
                    >N  - Any number greater than N
-    :param case_sensitive: <Unused, required by API>
-    :return: A dict with matching runs
+                   N   - The number N
+    :return: The bounds, or None if the range (N-M) is invalid
     """
-    results = {}
-
     if "-" in value:
-        # Range search
         try:
             irange = IntegerRange.from_string(value)
         except ValueError:
-            return {}
+            return None
+        return irange.first, irange.last
+    elif value.startswith("<"):
+        return None, int(value.lstrip("<>")) - 1
+    elif value.startswith(">"):
+        return int(value.lstrip("<>")) + 1, None
+    else:
+        ivalue = int(value)
+        return ivalue, ivalue
 
-        for run in data:
-            if field in data[run] and int(data[run][field]) in irange:
-                results[run] = data[run]
 
-    elif value.startswith("<"):
-        # Less than
-        ivalue = int(value.lstrip("<>"))
-        for run in data:
-            if field in data[run] and int(data[run][field]) < ivalue:
-                results[run] = data[run]
+def datetime_bounds(value: str) -> typing.Optional[
+        typing.Tuple[typing.Optional[datetime.datetime], typing.Optional[datetime.datetime], bool]]:
+    """Return the (start, end) bounds of the datetime range given in the
+    value, either of which is None if the range is open at that end, and
+    whether the bounds are inclusive.
 
+    :param value: Datetime range, which can be of the following construction:
+                   N-M - A range of N to M inclusive
+                   <N  - Any datetime before N
+                   >N  - Any datetime after N
+    :return: The bounds, or None if the range (N-M) is invalid
+    """
+    if "-" in value:
+        try:
+            start, end = value.split("-")
+            return (_to_datetime(start.strip(), USERINPUT_DT_FORMAT_STR),
+                    _to_datetime(end.strip(), USERINPUT_DT_FORMAT_STR), True)
+        except ValueError:
+            return None
+    elif value.startswith("<"):
+        return None, _to_datetime(value.lstrip("<>"), USERINPUT_DT_FORMAT_STR), False
     elif value.startswith(">"):
-        # Greater than
-        ivalue = int(value.lstrip("<>"))
-        for run in data:
-            if field in data[run] and int(data[run][field]) > ivalue:
-                results[run] = data[run]
-
+        return _to_datetime(value.lstrip("<>"), USERINPUT_DT_FORMAT_STR), None, False
     else:
-        # Equal to
-        ivalue = int(value)
-        for run in data:
-            if field in data[run] and int(data[run][field]) == ivalue:
-                results[run] = data[run]
+        raise RuntimeError("Can't perform a literal time comparison.")
 
-    return results
 
+def _in_bounds(x, first, last, inclusive: bool) -> bool:
+    """Return whether x lies within the (possibly open-ended) bounds"""
+    if inclusive:
+        return (first is None or x >= first) and (last is None or x <= last)
+    return (first is None or x > first) and (last is None or x < last)
 
-def _query_datetime_in_range(
+
+def _query_integer_in_range(
         data: {}, field: str, value: str, case_sensitive: bool
 ) -> {}:
     """Return a dict of run data whose specified field, when converted to an
-    datetime, falls within the range specified in the value parameter. It is
-    assumed that the field can be reliably converted to a datetime, and the
-    search is inclusive.
+    int, falls within the range specified in the value parameter. It is
+    assumed that the field can be reliably converted to an int, and the search
+    is inclusive.
 
     :param data: A dict of input run data
     :param field: The name of the field that should be matched
-    :param value: Datetime range, which can be of the following construction:
-                   N-M - A range of N to M inclusive
-                   <N  - Any datetime before N
-                   >N  - Any datetime after N
+    :param value: Integer range (see integer_bounds())
     :param case_sensitive: <Unused, required by API>
     :return: A dict with matching runs
     """
-    results = {}
-
-    if "-" in value:
-        # Range search
-        try:
-            start, end = value.split("-")
-            start = _to_datetime(start.strip(), USERINPUT_DT_FORMAT_STR)
-            end = _to_datetime(end.strip(), USERINPUT_DT_FORMAT_STR)
-        except ValueError:
-            return {}
+    bounds = integer_bounds(value)
+    if bounds is None:
+        return {}
+    first, last = bounds
 
-        for run in data:
-            if (field in data[run] and
-                start <= _to_datetime(data[run][field], UNIX_DT_FORMAT_STR)
-                <= end):
-                results[run] = data[run]
+    return {run: data[run] for run in data
+            if field in data[run] and _in_bounds(int(data[run][field]), first, last, True)}
 
-    elif value.startswith("<"):
-        # Less than
-        mark = _to_datetime(value.lstrip("<>"), USERINPUT_DT_FORMAT_STR)
-        for run in data:
-            if (field in data[run] and
-                _to_datetime(data[run][field], UNIX_DT_FORMAT_STR) < mark):
-                results[run] = data[run]
 
-    elif value.startswith(">"):
-        # Greater than
-        mark = _to_datetime(value.lstrip("<>"), USERINPUT_DT_FORMAT_STR)
-        for run in data:
-            if (field in data[run] and
-                    _to_datetime(data[run][field], UNIX_DT_FORMAT_STR) > mark):
-                results[run] = data[run]
+def _query_datetime_in_range(
+        data: {}, field: str, value: str, case_sensitive: bool
+) -> {}:
+    """Return a dict of run data whose specified field, when converted to an
+    datetime, falls within the range specified in the value parameter. It is
+    assumed that the field can be reliably converted to a datetime, and the
+    search is inclusive.
 
-    else:
-        raise RuntimeError("Can't perform a literal time comparison.")
+    :param data: A dict of input run data
+    :param field: The name of the field that should be matched
+    :param value: Datetime range (see datetime_bounds())
+    :param case_sensitive: <Unused, required by API>
+    :return: A dict with matching runs
+    """
+    bounds = datetime_bounds(value)
+    if bounds is None:
+        return {}
+    start, end, inclusive = bounds
 
-    return results
+    return {run: data[run] for run in data
+            if field in data[run] and
+            _in_bounds(_to_datetime(data[run][field], UNIX_DT_FORMAT_STR), start, end, inclusive)}
 
 # Map a field name to a handler for that query if it should have special
 # handling
@@ -173,6 +244,7 @@ _SPECIAL_QUERY_HANDLERS = {
     "experiment_identifier": _query_string_equals,
     "run_number": _query_integer_in_range,
     "start_time": _query_datetime_in_range,
+    "title" + SIMILAR_SUFFIX: _query_string_similar,
 }
 
 
@@ -1,18 +1,58 @@
 # SPDX-License-Identifier: GPL-3.0-or-later
 # Copyright (c) 2024 Team JournalViewer and contributors
 
+"""User cache of journal data, stored locally between sessions.
+
+Each source has a single SQLite store in the user data directory, holding a
+zlib-compressed record and modification time for each item of data
+(typically a journal file). A manifest of the names, modification times and
+sizes of the items in each store is held in memory, so checking for cached
+data or its modification time requires no file access.
+
+Items written by earlier versions, which used one file per item (plus a
+separate '.mtime' file) named by a hash of the source id and item name, are
+found by a single listing of the cache directory, shared by all stores. The
+names a source expects to hold (its index and journals) are declared with
+expect_data(), which claims the matching files for that source's store once,
+and each is moved into the store the first time it is looked for. Lookups
+then cost nothing once a source's files have all been moved.
+"""
 from platformdirs import user_data_dir
 from pathlib import Path
-import os.path
+import os
 import hashlib
 import datetime
 import logging
+import re
+import sqlite3
+import threading
+import typing
+import zlib
 
 # App and author names to identify user data
 CACHE_APP_NAME = "JournalViewer2"
 CACHE_APP_AUTHORS = "TeamJournalViewer"
 _CACHE_ACTIVATED = False
 
+# Names of the data and mtime files written by earlier versions
+_LEGACY_FILENAME = re.compile(r"[0-9a-f]{64}(\.mtime)?")
+
+_SCHEMA = """
+    CREATE TABLE IF NOT EXISTS items (
+        name TEXT PRIMARY KEY,
+        data BLOB NOT NULL,
+        size INTEGER NOT NULL,
+        mtime TEXT
+    );
+"""
+
+
+class _ManifestEntry(typing.NamedTuple):
+    """In-memory record of an item in a store"""
+    # Uncompressed size of the data
+    size: int
+    mtime: typing.Optional[datetime.datetime]
+
 
 def _item_hash(source_id: str, data_name: str) -> str:
     """Return the hash for the supplied source id and data name"""
@@ -24,20 +64,182 @@ def _cache_dir() -> str:
     return user_data_dir(CACHE_APP_NAME, CACHE_APP_AUTHORS)
 
 
-def _cache_file(source_id: str, data_name: str) -> Path:
-    """Return the full path to a cache file in the user space.
+def _legacy_cache_file(source_id: str, data_name: str) -> Path:
+    """Return the full path to a cache file written by earlier versions.
     The filename is a hash of the source id and data name provided.
     """
     return Path(_cache_dir()) / _item_hash(source_id, data_name)
 
 
-def _cache_file_mtime(source_id: str, data_name: str) -> Path:
-    """Return the full path to a cache file in the user space.
-    The filename is a hash of the source id and data name provided.
-    """
+def _legacy_cache_file_mtime(source_id: str, data_name: str) -> Path:
+    """Return the full path to a cached mtime written by earlier versions"""
     return Path(_cache_dir()) / (_item_hash(source_id, data_name) + ".mtime")
 
 
+def _parse_mtime(mtime: typing.Optional[str]) -> typing.Optional[datetime.datetime]:
+    """Return the stored mtime as a datetime, or None if absent or invalid"""
+    if mtime is None:
+        return None
+    try:
+        return datetime.datetime.fromisoformat(mtime)
+    except ValueError as exc:
+        logging.warning(f"Ignoring invalid cached mtime '{mtime}': {str(exc)}")
+        return None
+
+
+# Cache files written by earlier versions and not yet claimed by any store,
+# listed once for each cache directory
+_LEGACY_FILES: typing.Dict[str, typing.Set[str]] = {}
+_LEGACY_FILES_LOCK = threading.Lock()
+
+
+def _legacy_files() -> typing.Set[str]:
+    """Return the unclaimed cache files written by earlier versions in the
+    cache directory, listing it if this has not yet been done"""
+    directory = _cache_dir()
+    with _LEGACY_FILES_LOCK:
+        if directory not in _LEGACY_FILES:
+            try:
+                with os.scandir(directory) as entries:
+                    _LEGACY_FILES[directory] = {entry.name for entry in entries
+                                                if _LEGACY_FILENAME.fullmatch(entry.name)}
+            except OSError as exc:
+                logging.warning(f"Couldn't list cache directory {directory}: {str(exc)}")
+                _LEGACY_FILES[directory] = set()
+        return _LEGACY_FILES[directory]
+
+
+class CacheStore:
+    """SQLite store of the cached data for a single source.
+
+    The manifest is read when the store is opened, and kept up to date as
+    data is written. A single connection is shared between threads and
+    serialised with a lock.
+    """
+
+    def __init__(self, source_id: str, database: str):
+        self._source_id = source_id
+        self._lock = threading.Lock()
+        self._connection = sqlite3.connect(database, timeout=30, check_same_thread=False)
+        # Expected data written by earlier versions for this source, not yet
+        # moved into the store, and whether each has an mtime file
+        self._legacy_items: typing.Dict[str, bool] = {}
+        with self._lock, self._connection:
+            self._connection.execute("PRAGMA journal_mode=WAL")
+            self._connection.executescript(_SCHEMA)
+            self._manifest: typing.Dict[str, _ManifestEntry] = {
+                name: _ManifestEntry(size, _parse_mtime(mtime))
+                for name, size, mtime in self._connection.execute("SELECT name, size, mtime FROM items")
+            }
+
+    def __contains__(self, data_name: str) -> bool:
+        """Return whether the named data is in the store"""
+        if self._legacy_items and data_name in self._legacy_items:
+            self._import_legacy(data_name)
+        return data_name in self._manifest
+
+    def expect(self, data_names: typing.Iterable[str]) -> None:
+        """Claim any cache files written by earlier versions for the named
+        data, which are then moved into the store when first looked for"""
+        legacy_files = _legacy_files()
+        if not legacy_files:
+            return
+
+        with _LEGACY_FILES_LOCK:
+            for data_name in data_names:
+                if data_name in self._manifest or data_name in self._legacy_items:
+                    continue
+                item_hash = _item_hash(self._source_id, data_name)
+                if item_hash in legacy_files:
+                    self._legacy_items[data_name] = item_hash + ".mtime" in legacy_files
+                    legacy_files.difference_update((item_hash, item_hash + ".mtime"))
+
+    def __len__(self) -> int:
+        """Return the number of items in the store"""
+        return len(self._manifest)
+
+    def entry(self, data_name: str) -> typing.Optional[_ManifestEntry]:
+        """Return the manifest entry for the named data, if present"""
+        return self._manifest.get(data_name) if data_name in self else None
+
+    def put(self, data_name: str, data: bytes, mtime: typing.Optional[datetime.datetime]) -> None:
+        """Store the named data, replacing any existing record"""
+        with self._lock, self._connection:
+            self._connection.execute(
+                "INSERT OR REPLACE INTO items (name, data, size, mtime) VALUES (?, ?, ?, ?)",
+                (data_name, zlib.compress(data), len(data), None if mtime is None else mtime.isoformat())
+            )
+            self._manifest[data_name] = _ManifestEntry(len(data), mtime)
+
+    def get(self, data_name: str) -> typing.Optional[bytes]:
+        """Return the named data, or None if it is not in the store"""
+        if data_name not in self:
+            return None
+        with self._lock:
+            row = self._connection.execute("SELECT data FROM items WHERE name = ?", (data_name,)).fetchone()
+        return None if row is None else zlib.decompress(row[0])
+
+    def _import_legacy(self, data_name: str) -> None:
+        """Move the cache files written by earlier versions for the named
+        data into the store"""
+        with _LEGACY_FILES_LOCK:
+            has_mtime = self._legacy_items.pop(data_name, None)
+            if has_mtime is None:
+                return
+        data_file = _legacy_cache_file(self._source_id, data_name)
+        mtime_file = _legacy_cache_file_mtime(self._source_id, data_name)
+
+        try:
+            with open(data_file, "rb") as file:
+                data = file.read()
+            mtime = None
+            if has_mtime:
+                with open(mtime_file, "rb") as file:
+                    mtime = _parse_mtime(file.read().decode("utf-8"))
+        except OSError as exc:
+            logging.warning(f"Couldn't read legacy cache file {data_file} for "
+                            f"({self._source_id}, {data_name}): {str(exc)}")
+            return
+
+        logging.debug(f"Moving legacy cache file {data_file} for "
+                      f"({self._source_id}, {data_name}) into the store")
+        self.put(data_name, data, mtime)
+        for file in (data_file, mtime_file):
+            try:
+                os.remove(file)
+            except OSError:
+                pass
+
+    def close(self) -> None:
+        """Close the underlying database connection"""
+        with self._lock:
+            self._connection.close()
+
+
+# Open stores, keyed by cache directory and source id
+_STORES: typing.Dict[typing.Tuple[str, str], CacheStore] = {}
+_STORES_LOCK = threading.Lock()
+
+
+def _store(source_id: str) -> typing.Optional[CacheStore]:
+    """Return the store for the source, opening it if necessary, or None if
+    it could not be opened"""
+    key = (_cache_dir(), source_id)
+    store = _STORES.get(key)
+    if store is not None:
+        return store
+
+    with _STORES_LOCK:
+        if key not in _STORES:
+            database = Path(key[0]) / (hashlib.sha256(source_id.encode("utf-8")).hexdigest() + ".sqlite3")
+            try:
+                _STORES[key] = CacheStore(source_id, str(database))
+            except sqlite3.Error as exc:
+                logging.error(f"Couldn't open cache store {database} for '{source_id}': {str(exc)}")
+                return None
+        return _STORES[key]
+
+
 def initialise() -> None:
     """Perform basic set up of the cache, principally making sure the target
     user data directory exists before we try and use it"""
@@ -51,34 +253,33 @@ def initialise() -> None:
 
 def put_data(source_id: str, data_name: str, data: str,
              mtime: datetime.datetime = None) -> None:
-    """Create a user data file with a hashed name reflecting the supplied
-    source identifier and data name. Typically the data name will be a
-    journal filename.
+    """Store data in the cache for the supplied source identifier under the
+    given name. Typically the data name will be a journal filename.
     """
     if not _CACHE_ACTIVATED:
         return
 
-    logging.debug(f"Putting cache data for '{source_id}' / '{data_name}' "
-                  f" => '{_cache_file(source_id, data_name)}")
+    logging.debug(f"Putting cache data for '{source_id}' / '{data_name}'")
 
-    # Write main file data
+    store = _store(source_id)
+    if store is None:
+        return
     try:
-        with open(_cache_file(source_id, data_name), "wb") as file:
-            file.write(bytes(data, "utf-8"))
-    except Exception as exc:
-        logging.error(f"Couldn't write cache file "
-                      f"{_cache_file(source_id, data_name)} for "
+        store.put(data_name, bytes(data, "utf-8"), mtime)
+    except sqlite3.Error as exc:
+        logging.error(f"Couldn't write cache data for "
                       f"({source_id}, {data_name}): {str(exc)}")
 
-    # Write mtime if supplied
-    if mtime is not None:
-        try:
-            with open(_cache_file_mtime(source_id, data_name), "wb") as file:
-                file.write(bytes(str(mtime), "utf-8"))
-        except Exception as exc:
-            logging.error(f"Couldn't write cached mtime "
-                          f"{_cache_file_mtime(source_id, data_name)} for "
-                          f"({source_id}, {data_name}): {str(exc)}")
+
+def expect_data(source_id: str, data_names: typing.Iterable[str]) -> None:
+    """Declare the names of data the source may hold, so that any stored by
+    earlier versions of the cache can be found"""
+    if not _CACHE_ACTIVATED:
+        return
+
+    store = _store(source_id)
+    if store is not None:
+        store.expect(data_names)
 
 
 def has_data(source_id: str, data_name: str) -> bool:
@@ -86,62 +287,53 @@ def has_data(source_id: str, data_name: str) -> bool:
     if not _CACHE_ACTIVATED:
         return False
 
-    logging.debug(f"Checking cache data for '{source_id}' / '{data_name}' "
-                  f" => '{_cache_file(source_id, data_name)}")
-
-    return os.path.exists(_cache_file(source_id, data_name))
+    store = _store(source_id)
+    return store is not None and data_name in store
 
 
 def has_mtime(source_id: str, data_name: str) -> bool:
     """Return whether the specified mtime exists in the user cache."""
-    if not _CACHE_ACTIVATED:
-        return False
+    return get_mtime(source_id, data_name) is not None
 
-    return os.path.exists(_cache_file_mtime(source_id, data_name))
 
+def count_missing(source_id: str, data_names: typing.Iterable[str]) -> int:
+    """Return how many of the named data are not in the user cache"""
+    return sum(1 for data_name in data_names if not has_data(source_id, data_name))
 
-def get_data(source_id: str, data_name: str) -> (bytes, datetime.datetime):
+
+def get_data(source_id: str, data_name: str) -> (bytes, typing.Optional[datetime.datetime]):
     """Retrieve the data and associated mtime (if available)"""
-    data = bytes
-    mtime = datetime.datetime
+    logging.debug(f"Getting cache data for '{source_id}' / '{data_name}'")
 
-    logging.debug(f"Getting cache data for '{source_id}' / '{data_name}' "
-                  f" => '{_cache_file(source_id, data_name)}")
+    store = _store(source_id) if _CACHE_ACTIVATED else None
+    if store is None:
+        return None, None
 
-    # Get data file
     try:
-        with open(_cache_file(source_id, data_name), "rb") as data_file:
-            data = data_file.read()
-    except Exception as exc:
-        logging.error(f"Couldn't read cache file "
-                      f"{_cache_file(source_id, data_name)} for "
+        data = store.get(data_name)
+    except (sqlite3.Error, zlib.error) as exc:
+        logging.error(f"Couldn't read cache data for "
                       f"({source_id}, {data_name}): {str(exc)}")
+        return None, None
 
-    # Get mtime
-    if os.path.exists(_cache_file_mtime(source_id, data_name)):
-        mtime = get_mtime(source_id, data_name)
-
-    return data, mtime
+    return data, get_mtime(source_id, data_name)
 
 
-def get_mtime(source_id: str, data_name: str) -> datetime.datetime:
+def get_mtime(source_id: str, data_name: str) -> typing.Optional[datetime.datetime]:
     """Retrieve the specified mtime"""
-    try:
-        with open(_cache_file_mtime(source_id,
-                                    data_name), "rb") as mtime_file:
-            mtime_data = mtime_file.read()
-            return datetime.datetime.fromisoformat(mtime_data.decode("utf-8"))
-    except Exception as exc:
-        logging.warning(f"Couldn't read cached mtime "
-                        f"{_cache_file_mtime(source_id, data_name)} for "
-                        f"({source_id}, {data_name}): {str(exc)}")
-
-
-def get_file_size(source_id: str, data_name: str) -> int:
-    """Retrieve the file size of the cached data on disk"""
-    try:
-        return os.path.getsize(_cache_file(source_id, data_name))
-    except Exception as exc:
-        logging.warning(f"Couldn't read cached file size of "
-                        f"{_cache_file(source_id, data_name)} for "
-                        f"({source_id}, {data_name}): {str(exc)}")
+    if not _CACHE_ACTIVATED:
+        return None
+
+    store = _store(source_id)
+    entry = None if store is None else store.entry(data_name)
+    return None if entry is None else entry.mtime
+
+
+def get_file_size(source_id: str, data_name: str) -> typing.Optional[int]:
+    """Retrieve the (uncompressed) size of the cached data"""
+    if not _CACHE_ACTIVATED:
+        return None
+
+    store = _store(source_id)
+    entry = None if store is None else store.entry(data_name)
+    return None if entry is None else entry.size
@@ -8,12 +8,15 @@ from flask.wrappers import Response as FlaskResponse
 from jv2backend.utils import url_join
 from jv2backend.classes.requestData import RequestData, InvalidRequest
 from jv2backend.main.library import JournalLibrary
+from jv2backend.main.searcher import JournalSearcher, DEFAULT_MATCH_LIMIT
+from jv2backend.classes.searchIndex import TopRuns
 import jv2backend.classes.journal
 
 
 def add_routes(
     app: Flask,
-    journalLibrary: JournalLibrary
+    journalLibrary: JournalLibrary,
+    journalSearcher: JournalSearcher
 ) -> Flask:
     """Add routes to the given Flask application."""
 
@@ -150,12 +153,28 @@ def add_routes(
         generate a new journal containing matching run data - this is stored
         in the library for future retrieval.
 
-        :return: A JSON-formatted list of run data, or None
+        The POST data may also contain:
+          sortBy: Field by which to sort matches, prefixed with '-' for
+                  descending order (e.g. '-start_time')
+          offset: Index of the first match to return
+          limit: Maximum number of matches to return
+
+        When paging, matches are fed through a heap bounded to offset + limit
+        runs as they are found, and the rest are only counted, so the whole
+        set of matches is never held.
+
+        :return: A JSON-formatted list of run data, or None. If any of sortBy,
+                 offset, or limit are given, a JSON object containing the
+                 total number of matches and the requested page of run data
         """
         try:
             post_data = RequestData(request.json,
-                                    require_value_map=True)
-        except InvalidRequest as exc:
+                                    require_value_map=True,
+                                    optional_parameters="sortBy,offset,limit")
+            sort_by = post_data.parameter("sortBy") if post_data.has_parameter("sortBy") else None
+            offset = int(post_data.parameter("offset")) if post_data.has_parameter("offset") else 0
+            limit = int(post_data.parameter("limit")) if post_data.has_parameter("limit") else None
+        except (InvalidRequest, ValueError) as exc:
             return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
 
         logging.debug(f"Search {post_data.library_key()}...")
@@ -168,12 +187,106 @@ def add_routes(
                 200
             )
 
-        return make_response(
-            jv2backend.classes.journal.Journal.convert_run_data_to_json_array(
-                collection.search(post_data.value_map)
-            ),
-            200
-        )
+        if sort_by is None and offset == 0 and limit is None:
+            return make_response(
+                jv2backend.classes.journal.Journal.convert_run_data_to_json_array(
+                    collection.search(post_data.value_map)),
+                200
+            )
+
+        search_terms, case_sensitive = collection.parse_search_terms(post_data.value_map)
+        matches = TopRuns.sorted_by(sort_by, None if limit is None else offset + limit)
+        for chunk in collection.search_journals_in_chunks(collection.journals, search_terms, case_sensitive):
+            matches.add(chunk.values())
+
+        return make_response(jsonify({
+            "total": matches.total,
+            "offset": offset,
+            "results": matches.runs(offset, limit)
+        }), 200)
+
+    @app.post("/journals/search/start")
+    def search_start() -> FlaskResponse:
+        """Start searching all available journals in a target source in the
+        background, loading those not yet retrieved in parallel. Any search
+        already in progress is stopped.
+
+        In addition to basic source information the POST data should contain
+        one or more parameters on which to search the data, and optionally:
+          sortBy: Field by which to sort matches, prefixed with '-' for
+                  descending order (e.g. '-start_time')
+           limit: Number of leading matches to retain for paging, the rest
+                  being only counted (default 10000)
+
+        :return: A JSON object describing the progress of the search,
+                 including the searchId with which to request updates
+        """
+        try:
+            post_data = RequestData(request.json,
+                                    require_value_map=True,
+                                    optional_parameters="sortBy,limit")
+            limit = int(post_data.parameter("limit")) if post_data.has_parameter("limit") else DEFAULT_MATCH_LIMIT
+        except (InvalidRequest, ValueError) as exc:
+            return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
+
+        collection = journalLibrary[post_data.library_key()]
+        if collection is None:
+            return make_response(jsonify(
+                {"CollectionNotFoundError": f"No collection '{post_data.library_key()}' "
+                                            f"currently exists."}),
+                200
+            )
+
+        sort_by = post_data.parameter("sortBy") if post_data.has_parameter("sortBy") else None
+        return make_response(jsonify(journalSearcher.start(collection, post_data.value_map, sort_by, limit)), 200)
+
+    @app.post("/journals/search/update")
+    def search_update() -> FlaskResponse:
+        """Return the progress and matches of a background search
+
+        The POST data should contain:
+          searchId: ID of the search to query
+          first: Index of the first match to return (optional)
+          limit: Maximum number of matches to return (optional)
+
+        Only the leading matches retained by the search (numRetained of
+        numMatches) can be returned. Sorted searches return no matches until
+        they are complete.
+
+        :return: A JSON object describing the progress of the search and
+                 containing a page of the matching run data from 'first'
+                 onwards, or "NOT_RUNNING" if the search is not the current one
+        """
+        try:
+            post_data = RequestData(request.json,
+                                    require_parameters="searchId",
+                                    optional_parameters="first,limit")
+            search_id = int(post_data.parameter("searchId"))
+            first = int(post_data.parameter("first")) if post_data.has_parameter("first") else 0
+            limit = int(post_data.parameter("limit")) if post_data.has_parameter("limit") else None
+        except (InvalidRequest, ValueError) as exc:
+            return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
+
+        update = journalSearcher.get_update(search_id, first, limit)
+        return make_response(jsonify("NOT_RUNNING" if update is None else update), 200)
+
+    @app.post("/journals/search/stop")
+    def search_stop() -> FlaskResponse:
+        """Stop a background search. Matches found so far remain available.
+
+        The POST data should contain:
+          searchId: ID of the search to stop
+
+        :return: "OK", or "NOT_RUNNING" if the search is not the current one
+        """
+        try:
+            post_data = RequestData(request.json,
+                                    require_parameters="searchId")
+            search_id = int(post_data.parameter("searchId"))
+        except (InvalidRequest, ValueError) as exc:
+            return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
+
+        return make_response(jsonify("OK" if journalSearcher.stop(search_id) else "NOT_RUNNING"), 200)
 
     @app.post("/journals/findJournal")
     def find_journal_for_run() -> FlaskResponse:
@@ -206,7 +319,7 @@ def add_routes(
         # Try to find the journal
         journal = collection.journal_for_run(run_number)
         return make_response(jsonify(
-            {"journal_display_name": journal.display_name,
+            {"journal_display_name": journal.display_name if journal is not None else None,
              "run_number": run_number if journal is not None else -1}), 200)
 
     # ------------------------ End Routes -------------------------
@@ -7,14 +7,19 @@ import logging
 from flask import Flask, jsonify, request, make_response
 from flask.wrappers import Response as FlaskResponse
 from jv2backend.classes.requestData import RequestData, InvalidRequest
+from jv2backend.utils import encode_float64_array
 import jv2backend.main.nexus
+import jv2backend.main.nexusIndex
 import jv2backend.main.library
+import jv2backend.main.detectorHealth
 import json
+import typing
 
 
 def add_routes(
     app: Flask,
-    journalLibrary: jv2backend.main.library.JournalLibrary
+    journalLibrary: jv2backend.main.library.JournalLibrary,
+    detectorHealthScanner: jv2backend.main.detectorHealth.DetectorHealthScanner
 ) -> Flask:
     """Add routes to the given Flask application."""
 
@@ -49,10 +54,10 @@ def add_routes(
             if data_files[run] is None:
                 return make_response(
                     jsonify({"FileNotFoundError": f"Unable to find data file for run "
-                             "{run}"}), 200
+                             f"{run}"}), 200
                 )
             try:
-                logpaths.extend(jv2backend.main.nexus.logpaths_from_path(data_files[run]))
+                logpaths.extend(jv2backend.main.nexusIndex.lookup(data_files[run], "logPaths"))
             except FileNotFoundError as exc:
                 return make_response(jsonify({"FileNotFoundError": str(exc)}), 200)
 
@@ -64,14 +69,35 @@ def add_routes(
 
         The POST data should contain:
          runNumbers: Array of run numbers to probe for SE log values
-           logValue: Log value to retrieve
+           logValue: Log value to retrieve, or
+          logValues: Array of log values to retrieve together
+
+        The data for each run contains the "time" and "value" arrays as
+        base64-encoded little-endian float64. String-valued logs also
+        contain "categories", with values being indices into that list.
+
+        When "logValues" is given, all of the logs are read from each file
+        in a single pass and the run data is returned per log in "logs",
+        mapping log value to the data for each run. Runs lacking some of the
+        logs are simply omitted from those logs' data.
+
+        Runs which could not be read are omitted from the data and listed in
+        "errors", mapping run number to the error encountered.
 
         :return: A list of the log data
         """
         try:
             post_data = RequestData(request.json,
                                     require_run_numbers=True,
-                                    require_parameters="logValue")
+                                    optional_parameters="logValue,logValues")
+            if post_data.has_parameter("logValues"):
+                log_values = post_data.parameter("logValues")
+                if not isinstance(log_values, list) or not log_values:
+                    raise InvalidRequest("The 'logValues' parameter must be a non-empty list.")
+            elif post_data.has_parameter("logValue"):
+                log_values = [post_data.parameter("logValue")]
+            else:
+                raise InvalidRequest("No 'logValue' or 'logValues' provided in request.")
         except InvalidRequest as exc:
             return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
 
@@ -86,33 +112,154 @@ def add_routes(
         # Locate data files for the specified run numbers in the collection
         data_files = collection.locate_data_files(post_data.run_numbers)
 
-        # Retrieve the log value data
-        log_value = post_data.parameter("logValue")
-        log_value_data = {}
-        for run in data_files:
-            if data_files[run] is None:
-                return make_response(
-                    jsonify({"FileNotFoundError": f"Unable to find data file for run "
-                                      "{run}"}), 200
-                )
+        # Retrieve the log value data from each run's file concurrently
+        def read_log_values(filepath: str) -> dict:
+            time_range, logs, missing = jv2backend.main.nexus.read_logvalues(filepath, log_values)
+            if missing:
+                logging.debug(f"Logs not present in {filepath}: {', '.join(missing)}")
+
+            log_data = {}
+            for log_value, (times, values, categories) in logs.items():
+                run_data = {
+                    "timeRange": [time_range],
+                    "time": encode_float64_array(times),
+                    "value": encode_float64_array(values)
+                }
+                if categories is not None:
+                    run_data["categories"] = categories
+                log_data[log_value] = run_data
+            return log_data
+
+        results = jv2backend.main.nexus.read_runs(read_log_values, data_files)
+        if not any(result.error is None for result in results.values()):
+            return _read_failure_response(results)
+
+        log_value_data = {log_value: {} for log_value in log_values}
+        for run, result in results.items():
+            if result.error is None:
+                for log_value, run_data in result.value.items():
+                    log_value_data[log_value][run] = {"runNumber": str(run), **run_data}
+
+        response = {
+            "runNumbers": post_data.run_numbers,
+            "errors": _read_errors(results)
+        }
+        if post_data.has_parameter("logValues"):
+            response["logValues"] = log_values
+            response["logs"] = log_value_data
+        else:
+            response["logValue"] = log_values[0]
+            response["data"] = log_value_data[log_values[0]]
+        return make_response(jsonify(response), 200)
 
-            run_data = {}
-            try:
-                nxsfile, first_group = jv2backend.main.nexus.open_at(data_files[run], 0)
-            except FileNotFoundError as exc:
-                return make_response(jsonify({"FileNotFoundError": str(exc)}), 200)
+    @app.post("/runData/nexus/getLiveLogValueData")
+    def get_live_log_value_data() -> FlaskResponse:
+        """Return log samples recorded since those already retrieved for a
+        run, which may still be being written.
+
+        The POST data should contain:
+         runNumbers: Array containing the run number to probe
+           logValue: Log value to retrieve
+              first: Number of samples already retrieved (optional)
+
+        The "time" and "value" arrays of the new samples are base64-encoded
+        little-endian float64. String-valued logs also contain "categories"
+        for the new samples, with values being indices into that list.
+
+        :return: A JSON object containing the new samples, the index of the
+                 first of them, and the total number of samples in the log
+        """
+        try:
+            post_data = RequestData(request.json,
+                                    require_run_numbers=True,
+                                    require_parameters="logValue",
+                                    optional_parameters="first")
+            first = int(post_data.parameter("first")) if post_data.has_parameter("first") else 0
+        except (InvalidRequest, ValueError) as exc:
+            return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
+
+        # Check for valid collection
+        if post_data.library_key() not in journalLibrary:
+            return make_response(
+                jsonify({"CollectionNotFoundError": f"Collection {post_data.library_key()} "
+                                  f"does not exist."}), 200
+            )
+        collection = journalLibrary[post_data.library_key()]
+
+        # Locate data file for the specified run number in the collection
+        run_number = post_data.run_numbers[0]
+        data_file = collection.locate_data_file(run_number)
+        if data_file is None:
+            return make_response(
+                jsonify({"FileNotFoundError": f"Unable to find data file for run "
+                                  f"{run_number}"}), 200
+            )
+
+        try:
+            total, times, values, categories = jv2backend.main.nexus.tail_logvalues(
+                data_file, post_data.parameter("logValue"), first
+            )
+        except (OSError, KeyError, ValueError) as exc:
+            return make_response(jsonify({"FileNotFoundError": str(exc)}), 200)
+
+        run_data = {
+            "runNumber": str(run_number),
+            "first": min(first, total),
+            "total": total,
+            "time": encode_float64_array(times),
+            "value": encode_float64_array(values)
+        }
+        if categories is not None:
+            run_data["categories"] = categories
+        return make_response(jsonify(run_data), 200)
+
+    @app.post("/runData/nexus/getLogStatistics")
+    def get_log_statistics() -> FlaskResponse:
+        """Return summary statistics of a log value for one or more run
+        numbers.
+
+        The POST data should contain:
+         runNumbers: Array of run numbers to probe for SE log values
+           logValue: Log value to summarise
+
+        Statistics are recorded in the NeXus metadata index, so are only
+        determined once for each file. Runs for which they could not be
+        determined (e.g. because the log is absent) are listed in "errors",
+        mapping run number to the error encountered, rather than failing the
+        request.
 
-            run_data["runNumber"] = str(run)
-            run_data["timeRange"] = [jv2backend.main.nexus.timerange(first_group)]
-            run_data["data"] = jv2backend.main.nexus.logvalues(first_group[log_value])
+        :return: A JSON object containing a list of the statistics (samples,
+                 mean, min, max and last) for each run
+        """
+        try:
+            post_data = RequestData(request.json,
+                                    require_run_numbers=True,
+                                    require_parameters="logValue")
+        except InvalidRequest as exc:
+            return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
+
+        # Check for valid collection
+        if post_data.library_key() not in journalLibrary:
+            return make_response(
+                jsonify({"CollectionNotFoundError": f"Collection {post_data.library_key()} "
+                                  f"does not exist."}), 200
+            )
+        collection = journalLibrary[post_data.library_key()]
+
+        # Locate data files for the specified run numbers in the collection
+        data_files = collection.locate_data_files(post_data.run_numbers)
 
-            log_value_data[run] = run_data
+        log_value = post_data.parameter("logValue")
+        results = jv2backend.main.nexus.read_runs(
+            lambda filepath: jv2backend.main.nexusIndex.log_statistics(filepath, log_value), data_files
+        )
 
         return make_response(jsonify(
             {
                 "logValue": log_value,
-                "runNumbers":  post_data.run_numbers,
-                "data": log_value_data
+                "results": [{"runNumber": run, **result.value}
+                            for run, result in results.items() if result.error is None],
+                "errors": _read_errors(results)
             }
         ), 200)
 
@@ -147,17 +294,17 @@ def add_routes(
         if data_file is None:
             return make_response(
                 jsonify({"FileNotFoundError": f"Unable to find data file for run "
-                                  "{run}"}), 200
+                                  f"{run_number}"}), 200
             )
 
         spectrum_type = post_data.parameter("spectrumType")
         if spectrum_type == "monitor":
             return make_response(
-                jsonify(jv2backend.main.nexus.get_monitor_count(data_file)),
+                jsonify(jv2backend.main.nexusIndex.lookup(data_file, "monitorCount")),
                 200)
         elif spectrum_type == "detector":
             return make_response(
-                jsonify(jv2backend.main.nexus.get_detector_count(data_file)),
+                jsonify(jv2backend.main.nexusIndex.lookup(data_file, "spectrumCount")),
                 200)
         else:
             return make_response(
@@ -174,12 +321,36 @@ def add_routes(
            spectrumId: Target spectrum index to return
          spectrumType: Spectrum type to return - either monitor or detector
 
-        :return: A list of the detector spectra
+        The POST data may also contain:
+              spectra: Detector spectra to sum instead of spectrumId, either as
+                       an array of indices or a string such as "1-8,12"
+             binCount: Number of bins to rebin the spectra to
+              binning: Either "linear" (default) or "log" spacing of new bins
+               tofMin: Minimum time-of-flight to return
+               tofMax: Maximum time-of-flight to return
+        normalisation: Object specifying normalisation of the spectra, with
+                       any of perProtonCharge (bool), perMicrosecond (bool),
+                       referenceRun (run number whose same spectrum to divide
+                       by) and monitor (monitor of each run to divide by)
+             divisors: If true, return the spectra without normalisation,
+                       each with the proton charge of its run and any monitor
+                       or reference spectrum given in the normalisation, on
+                       its own bins, so that the client can normalise them
+
+        Runs from the same instrument setup usually share their bin edges, so
+        each distinct set of edges is returned once in "axes" and referenced
+        by index from the entries in "spectra" (see encode_spectra). Runs
+        which could not be read or normalised (e.g. with no proton charge
+        recorded) have no spectrum, and are listed in "errors".
+
+        :return: The run numbers, spectrum, type, errors, axes, and spectra
         """
         try:
             post_data = RequestData(request.json,
                                     require_run_numbers=True,
-                                    require_parameters="spectrumId,spectrumType")
+                                    require_parameters="spectrumId,spectrumType",
+                                    optional_parameters="spectra,binCount,binning,tofMin,tofMax,"
+                                                        "normalisation,divisors")
         except InvalidRequest as exc:
             return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
 
@@ -194,27 +365,75 @@ def add_routes(
         # Locate data files for the specified run numbers in the collection
         data_files = collection.locate_data_files(post_data.run_numbers)
 
+        # Summing no spectra at all can't give a spectrum for any run
+        if post_data.has_parameter("spectra") and not post_data.parameter("spectra"):
+            return make_response(jsonify({"InvalidRequestError": "No spectra were given to sum."}), 400)
+
         # Get request parameters
-        spectrum_id = int(post_data.parameter("spectrumId"))
-        spectrum_type = post_data.parameter("spectrumType")
+        try:
+            spectrum_id = int(post_data.parameter("spectrumId"))
+            spectrum_type = post_data.parameter("spectrumType")
+            summed_spectra = _summed_spectra(post_data)
+            rebinning = _rebinning(post_data)
+            normalisation, reference_run = _normalisation(post_data)
+            divisors = post_data.has_parameter("divisors") and bool(post_data.parameter("divisors"))
+        except (ValueError, TypeError) as exc:
+            return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
 
-        # first entry matches sata expectation of the frontend
-        spectra = [[post_data.run_numbers, spectrum_id, spectrum_type]]
-        for run in data_files:
-            if run is None:
-                continue
-            if spectrum_type == "monitor":
-                spectra.append(jv2backend.main.nexus.get_monitor_spectrum(
-                    data_files[run],
-                    spectrum_id)
-                )
-            elif spectrum_type == "detector":
-                spectra.append(jv2backend.main.nexus.get_detector_spectrum(
-                    data_files[run],
-                    spectrum_id)
+        if spectrum_type not in ("monitor", "detector"):
+            return make_response(jsonify({"InvalidRequestError": f"Unrecognised spectrum type "
+                                                                  f"'{spectrum_type}'."}), 200)
+        spectrum = spectrum_id if spectrum_type == "monitor" or summed_spectra is None else summed_spectra
+
+        # Read any reference spectrum once, for use with every run
+        reference = None
+        if reference_run is not None:
+            reference_file = collection.locate_data_file(reference_run)
+            if reference_file is None:
+                return make_response(
+                    jsonify({"FileNotFoundError": f"Unable to find data file for reference run "
+                                                  f"{reference_run}"}), 200
                 )
+            try:
+                reference = jv2backend.main.nexus.cached_spectrum(reference_file, spectrum_type, spectrum,
+                                                                  rebinning)
+            except (OSError, KeyError, ValueError, IndexError) as exc:
+                return make_response(jsonify({"FileNotFoundError": f"Unable to read reference run "
+                                                                   f"{reference_run}: {exc}"}), 200)
+
+        # When returning divisors the proton charge is always included, since it costs little to read
+        if divisors:
+            normalisation = jv2backend.main.nexus.Normalisation(
+                per_proton_charge=True, monitor=None if normalisation is None else normalisation.monitor
+            )
 
-        return make_response(jsonify(spectra), 200)
+        # Read (and normalise, or find the divisors of) the spectrum from each run's file concurrently
+        def read_spectrum(filepath: str) -> typing.Tuple[jv2backend.main.nexus.Spectrum, typing.Optional[dict]]:
+            data = jv2backend.main.nexus.read_spectrum(filepath, spectrum_type, spectrum, rebinning)
+            if normalisation is None:
+                return data, None
+            if divisors:
+                return data, normalisation.divisors(filepath, data, rebinning, reference)
+            return normalisation.apply(filepath, data, rebinning, reference), None
+
+        results = jv2backend.main.nexus.read_runs(read_spectrum, data_files)
+        if not any(result.error is None for result in results.values()):
+            return _read_failure_response(results)
+
+        # Runs which could not be read are given no spectrum
+        spectra = jv2backend.main.nexus.encode_spectra(
+            {run: None if result.value is None else result.value[0] for run, result in results.items()},
+            {run: result.value[1] for run, result in results.items() if result.value is not None} if divisors else None
+        )
+        return make_response(jsonify(
+            {
+                "runNumbers": post_data.run_numbers,
+                "spectrum": spectrum_id if summed_spectra is None else post_data.parameter("spectra"),
+                "spectrumType": spectrum_type,
+                "errors": _read_errors(results),
+                **spectra
+            }
+        ), 200)
 
     @app.post("/runData/nexus/getDetectorAnalysis")
     def get_detector_analysis() -> FlaskResponse:
@@ -245,14 +464,234 @@ def add_routes(
         if data_file is None:
             return make_response(
                 jsonify({"FileNotFoundError": f"Unable to find data file for run "
-                                  "{run}"}), 200
+                                  f"{run_number}"}), 200
+            )
+
+        return make_response(
+            jv2backend.main.nexusIndex.nonzero_spectra_ratio(data_file),
+            200
+        )
+
+    @app.post("/runData/nexus/startDetectorHealth")
+    def start_detector_health() -> FlaskResponse:
+        """Start determining detector health for every run in a journal
+
+        Results are recorded in the NeXus metadata index, so files which
+        have been analysed before are not read again.
+
+        In addition to basic source information the POST data should contain
+        the journal file whose runs are to be analysed.
+
+        :return: A JSON object describing the progress of the scan
+        """
+        try:
+            post_data = RequestData(request.json,
+                                    require_journal_file=True)
+        except InvalidRequest as exc:
+            return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
+
+        # Check for valid collection and journal
+        if post_data.library_key() not in journalLibrary:
+            return make_response(
+                jsonify({"CollectionNotFoundError": f"Collection {post_data.library_key()} "
+                                  f"does not exist."}), 200
+            )
+        journal = journalLibrary[post_data.library_key()][post_data.journal_filename]
+        if journal is None or not journal.has_run_data():
+            return make_response(
+                jsonify({"JournalNotFoundError": f"No run data available for journal "
+                                  f"{post_data.journal_filename}."}), 200
+            )
+
+        return make_response(
+            jsonify(detectorHealthScanner.start(_detector_health_key(post_data),
+                                                journal.get_data_files())),
+            200
+        )
+
+    @app.post("/runData/nexus/getDetectorHealth")
+    def get_detector_health() -> FlaskResponse:
+        """Return the progress and results of a detector health scan
+
+        The POST data should contain:
+          journalFilename: Journal whose scan is to be queried
+          first: Index of the first result to return (optional)
+
+        :return: A JSON object describing the progress of the scan and
+                 containing the results from 'first' onwards, or
+                 "NOT_RUNNING" if the journal is not being scanned
+        """
+        try:
+            post_data = RequestData(request.json,
+                                    require_journal_file=True,
+                                    optional_parameters="first")
+            first = int(post_data.parameter("first")) if post_data.has_parameter("first") else 0
+        except (InvalidRequest, ValueError) as exc:
+            return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
+
+        update = detectorHealthScanner.get_update(_detector_health_key(post_data), first)
+        return make_response(jsonify("NOT_RUNNING" if update is None else update), 200)
+
+    @app.post("/runData/nexus/getDetectorMapInfo")
+    def get_detector_map_info() -> FlaskResponse:
+        """Return the layout of the detector map tile pyramid for a run
+
+        The POST data should contain:
+          runNumbers: Array containing the run number to describe
+
+        :return: A JSON object describing the map dimensions and levels
+        """
+        try:
+            post_data = RequestData(request.json,
+                                    require_run_numbers=True)
+        except InvalidRequest as exc:
+            return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
+
+        # Check for valid collection
+        if post_data.library_key() not in journalLibrary:
+            return make_response(
+                jsonify({"CollectionNotFoundError": f"Collection {post_data.library_key()} "
+                                  f"does not exist."}), 200
+            )
+        collection = journalLibrary[post_data.library_key()]
+
+        # Locate data file for the specified run number in the collection
+        run_number = post_data.run_numbers[0]
+        data_file = collection.locate_data_file(run_number)
+        if data_file is None:
+            return make_response(
+                jsonify({"FileNotFoundError": f"Unable to find data file for run "
+                                  f"{run_number}"}), 200
             )
 
         return make_response(
-            jv2backend.main.nexus.nonzero_spectra_ratio(data_file),
+            jsonify(jv2backend.main.nexusIndex.detector_map_info(data_file)),
             200
         )
 
+    @app.post("/runData/nexus/getDetectorMapTile")
+    def get_detector_map_tile() -> FlaskResponse:
+        """Return a single tile of the detector map for a run
+
+        The POST data should contain:
+          runNumbers: Array containing the run number to retrieve
+               level: Pyramid level of the tile, with 0 being full resolution
+                 row: Tile row (spectrum axis) within the level
+              column: Tile column (time-of-flight axis) within the level
+
+        :return: A JSON object containing the tile shape and binned counts
+        """
+        try:
+            post_data = RequestData(request.json,
+                                    require_run_numbers=True,
+                                    require_parameters="level,row,column")
+        except InvalidRequest as exc:
+            return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
+
+        # Check for valid collection
+        if post_data.library_key() not in journalLibrary:
+            return make_response(
+                jsonify({"CollectionNotFoundError": f"Collection {post_data.library_key()} "
+                                  f"does not exist."}), 200
+            )
+        collection = journalLibrary[post_data.library_key()]
+
+        # Locate data file for the specified run number in the collection
+        run_number = post_data.run_numbers[0]
+        data_file = collection.locate_data_file(run_number)
+        if data_file is None:
+            return make_response(
+                jsonify({"FileNotFoundError": f"Unable to find data file for run "
+                                  f"{run_number}"}), 200
+            )
+
+        try:
+            tile = jv2backend.main.nexus.get_detector_map_tile(
+                data_file,
+                int(post_data.parameter("level")),
+                int(post_data.parameter("row")),
+                int(post_data.parameter("column"))
+            )
+        except ValueError as exc:
+            return make_response(jsonify({"InvalidRequestError": str(exc)}), 200)
+
+        return make_response(jsonify(tile), 200)
+
     # ------------------------ End Routes -------------------------
 
     return app
+
+
+def _read_errors(
+    results: typing.Dict[int, jv2backend.main.nexus.RunResult]
+) -> typing.Dict[int, str]:
+    """Return the errors for any runs which could not be read"""
+    return {run: result.error for run, result in results.items() if result.error is not None}
+
+
+def _read_failure_response(
+    results: typing.Dict[int, jv2backend.main.nexus.RunResult]
+) -> FlaskResponse:
+    """Return an error response for a request in which no runs could be read"""
+    message = "; ".join(f"{run}: {error}" for run, error in _read_errors(results).items())
+    return make_response(jsonify({"FileNotFoundError": message}), 200)
+
+
+def _normalisation(
+    post_data: RequestData
+) -> typing.Tuple[typing.Optional[jv2backend.main.nexus.Normalisation], typing.Optional[int]]:
+    """Return the normalisation and reference run specified in the request,
+    if any"""
+    if not post_data.has_parameter("normalisation"):
+        return None, None
+
+    spec = post_data.parameter("normalisation")
+    if not isinstance(spec, dict):
+        raise ValueError("Normalisation must be given as an object.")
+    unknown = set(spec) - {"perProtonCharge", "perMicrosecond", "referenceRun", "monitor"}
+    if unknown:
+        raise ValueError(f"Unrecognised normalisation {', '.join(sorted(unknown))}.")
+
+    normalisation = jv2backend.main.nexus.Normalisation(
+        per_proton_charge=bool(spec.get("perProtonCharge", False)),
+        per_microsecond=bool(spec.get("perMicrosecond", False)),
+        monitor=int(spec["monitor"]) if spec.get("monitor") is not None else None
+    )
+    reference_run = int(spec["referenceRun"]) if spec.get("referenceRun") is not None else None
+    return normalisation, reference_run
+
+
+def _summed_spectra(post_data: RequestData) -> typing.Optional[typing.Sequence[int]]:
+    """Return the detector spectra to sum from the request, if any were given"""
+    if not post_data.has_parameter("spectra"):
+        return None
+
+    spectra = post_data.parameter("spectra")
+    if isinstance(spectra, str):
+        return jv2backend.main.nexus.spectrum_indices_from_string(spectra)
+    return sorted(set(int(spectrum) for spectrum in spectra))
+
+
+def _rebinning(post_data: RequestData) -> typing.Optional[jv2backend.main.nexus.Rebinning]:
+    """Return the rebinning specified in the request, if any"""
+    if not any(post_data.has_parameter(p) for p in ("binCount", "tofMin", "tofMax")):
+        return None
+
+    def optional_value(name: str, convert: typing.Callable) -> typing.Any:
+        return convert(post_data.parameter(name)) if post_data.has_parameter(name) else None
+
+    binning = post_data.parameter("binning") if post_data.has_parameter("binning") else "linear"
+    if binning not in ("linear", "log"):
+        raise ValueError(f"Unrecognised binning '{binning}'.")
+
+    return jv2backend.main.nexus.Rebinning(
+        bin_count=optional_value("binCount", int),
+        logarithmic=binning == "log",
+        tof_min=optional_value("tofMin", float),
+        tof_max=optional_value("tofMax", float)
+    )
+
+
+def _detector_health_key(post_data: RequestData) -> str:
+    """Return the detector health scan key for the journal in the request"""
+    return f"{post_data.library_key()}/{post_data.journal_filename}"
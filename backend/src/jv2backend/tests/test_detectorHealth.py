@@ -0,0 +1,55 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+from pathlib import Path
+import jv2backend.main.detectorHealth
+import jv2backend.main.nexus
+import jv2backend.main.nexusIndex
+
+import pytest
+
+
+@pytest.fixture()
+def sample_nexus_filepath() -> Path:
+    """Sample NeXus file on fake server"""
+    return Path(__file__).parent / "data/fake_server/ALF85423.nxs"
+
+
+def wait_for_scan(scanner, key):
+    """Wait for the scan with the specified key to finish, returning its final update"""
+    scanner._thread.join(timeout=60)
+    return scanner.get_update(key)
+
+
+def test_scan_records_results_and_errors_in_run_order(sample_nexus_filepath, tmp_path):
+    jv2backend.main.nexusIndex.initialise(str(tmp_path / "index.sqlite3"))
+    try:
+        scanner = jv2backend.main.detectorHealth.DetectorHealthScanner()
+        data_files = {85423: str(sample_nexus_filepath), 85424: str(tmp_path / "missing.nxs"), 85425: None}
+        scanner.start("journal", data_files)
+        update = wait_for_scan(scanner, "journal")
+
+        assert update["complete"]
+        assert update["numRuns"] == update["numCompleted"] == 3
+        assert [result["runNumber"] for result in update["results"]] == [85423, 85424, 85425]
+        assert update["results"][0]["nonZeroSpectra"] == 974
+        assert "error" in update["results"][1] and "error" in update["results"][2]
+
+        # Results are retained in the index, and may be retrieved incrementally
+        assert jv2backend.main.nexusIndex.lookup(str(sample_nexus_filepath), "detectorHealth") == \
+            jv2backend.main.nexus.detector_health(sample_nexus_filepath)
+        assert [result["runNumber"] for result in scanner.get_update("journal", 2)["results"]] == [85425]
+    finally:
+        jv2backend.main.nexusIndex._INDEX = None
+
+
+def test_scan_for_another_key_replaces_current_scan(sample_nexus_filepath):
+    scanner = jv2backend.main.detectorHealth.DetectorHealthScanner()
+    scanner.start("first", {85423: str(sample_nexus_filepath)})
+    scanner.start("second", {})
+
+    assert scanner.get_update("first") is None
+    assert wait_for_scan(scanner, "second")["complete"]
+
+    scanner.stop()
+    assert scanner.get_update("second") is None
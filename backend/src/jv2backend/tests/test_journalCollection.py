@@ -3,6 +3,7 @@
 
 from jv2backend.classes.collection import JournalCollection
 from jv2backend.classes.journal import Journal, SourceType
+import jv2backend.main.userCache
 import xml.etree.ElementTree as ElementTree
 from pathlib import Path
 import datetime
@@ -25,7 +26,7 @@ def _example_collection(_fake_server_data_dir):
     # Construct two example journals and make a collection
     journal1 = collection.add_journal(
         "Journal A", "simpleRunData1.xml",
-        str(_fake_server_data_dir), datetime.datetime.now()
+        str(_fake_server_data_dir)
     )
     with open(_fake_server_data_dir / "simpleRunData1.xml", "rb") as f1:
         runDataTree1 = ElementTree.parse(f1)
@@ -33,7 +34,7 @@ def _example_collection(_fake_server_data_dir):
 
     journal2 = collection.add_journal(
         "Journal B", "simpleRunData2.xml",
-        str(_fake_server_data_dir), datetime.datetime.now()
+        str(_fake_server_data_dir)
     )
     with open(_fake_server_data_dir / "simpleRunData2.xml", "rb") as f2:
         runDataTree2 = ElementTree.parse(f2)
@@ -61,6 +62,18 @@ def test_retrieve_valid_journal(_example_collection):
     assert journal.display_name == "Journal A"
 
 
+@pytest.mark.parametrize("filename,run_number", [("JVTEST00000003.nxs", 3), ("JVTEST00000005.nxs", 5)])
+def test_data_file_can_be_found_by_name(_example_collection, filename, run_number):
+    journal, data = _example_collection.find_data_file(filename)
+    assert journal is not None
+    assert int(data["run_number"]) == run_number
+    assert journal.get_run_for_file(filename) is data
+
+
+def test_data_file_not_found_by_name(_example_collection):
+    assert _example_collection.find_data_file("JVTEST00000010.nxs") == (None, None)
+
+
 def test_retrieve_invalid_journal(_example_collection):
     journal = _example_collection["simpleRunData99.xml"]
     assert journal is None
@@ -107,3 +120,139 @@ def test_data_file_can_be_found_in_collection(_example_collection, _fake_server_
 @pytest.mark.parametrize("run_number", [1001,1002])
 def test_data_file_not_found_in_collection(_example_collection, _fake_server_data_dir, run_number):
     assert _example_collection.locate_data_file(run_number) is None
+
+
+class _LoadingJournals:
+    """Supplies run data to network journals in place of retrieving them,
+    counting the number of journals loaded"""
+
+    def __init__(self, run_data: dict):
+        self.run_data = run_data
+        self.loaded = []
+
+    def __call__(self, journal: Journal, ignore_cache: bool = False):
+        self.loaded.append(journal.filename)
+        journal.run_data = self.run_data[journal.filename]
+
+
+@pytest.fixture
+def _network_journals(monkeypatch) -> _LoadingJournals:
+    # Sixteen chronological journals of ten runs each, the fifth being empty
+    run_data = {f"journal_{n:02d}.xml": {} if n == 4 else
+                {run: {"run_number": str(run), "name": f"RUN{run}"} for run in range(n * 10, n * 10 + 10)}
+                for n in range(16)}
+    loader = _LoadingJournals(run_data)
+    monkeypatch.setattr(Journal, "get_run_data", lambda journal, ignore_cache=False: loader(journal))
+    return loader
+
+
+def _network_collection(filenames) -> JournalCollection:
+    collection = JournalCollection(SourceType.Network, "NetworkKey", "http://a.server", "index.xml", "/data")
+    for filename in filenames:
+        collection.add_journal(filename, filename, "/data")
+    return collection
+
+
+@pytest.mark.parametrize("run_number", [0, 39, 55, 100, 159])
+def test_journal_for_run_bisects_network_journals(_network_journals, run_number):
+    collection = _network_collection(_network_journals.run_data)
+
+    journal = collection.journal_for_run(run_number)
+    assert journal.filename == f"journal_{run_number // 10:02d}.xml"
+    assert len(_network_journals.loaded) <= 6
+
+    # A second lookup in the same journal is resolved from the index alone
+    _network_journals.loaded.clear()
+    assert collection.journal_for_run(run_number + 1 if run_number % 10 < 9 else run_number - 1) is journal
+    assert not _network_journals.loaded
+
+
+@pytest.mark.parametrize("run_number", [-1, 45, 160])
+def test_journal_for_run_returns_None_for_runs_outside_network_journals(_network_journals, run_number):
+    collection = _network_collection(_network_journals.run_data)
+    assert collection.journal_for_run(run_number) is None
+
+
+def test_run_range_index_is_retained_in_user_cache(_network_journals, monkeypatch, tmp_path):
+    monkeypatch.setattr(jv2backend.main.userCache, "_cache_dir", lambda: str(tmp_path))
+    monkeypatch.setattr(jv2backend.main.userCache, "_CACHE_ACTIVATED", True)
+
+    collection = _network_collection(_network_journals.run_data)
+    for journal in collection.journals:
+        journal.get_run_data()
+
+    # A new collection for the same source locates runs without loading any journals
+    _network_journals.loaded.clear()
+    collection = _network_collection(_network_journals.run_data)
+    assert collection.journal_for_run(123).filename == "journal_12.xml"
+    assert not _network_journals.loaded
+    assert collection.locate_data_file(123) == "/data/RUN123.nxs"
+    assert _network_journals.loaded == ["journal_12.xml"]
+
+
+def test_find_data_file_loads_journals_only_for_unknown_files(_network_journals):
+    collection = _network_collection(_network_journals.run_data)
+    journal, data = collection.find_data_file("RUN123.nxs")
+    assert journal.filename == "journal_12.xml" and data["run_number"] == "123"
+    assert len(_network_journals.loaded) == len(collection.journals)
+
+    # Known files are found from the index, and missing ones don't reload
+    # any journal (including the empty one)
+    _network_journals.loaded.clear()
+    assert collection.find_data_file("RUN57.nxs")[0].filename == "journal_05.xml"
+    assert collection.find_data_file("RUN45.nxs") == (None, None)
+    assert collection["journal_04.xml"].is_loaded() and not collection["journal_04.xml"].has_run_data()
+    assert not _network_journals.loaded
+
+
+def test_run_range_index_is_stored_once_per_batch_of_loads(_network_journals, monkeypatch):
+    stored = []
+    monkeypatch.setattr(jv2backend.main.userCache, "put_data",
+                        lambda key, name, data: stored.append(name))
+
+    collection = _network_collection(_network_journals.run_data)
+    collection.search({"run_number": "0-159"})
+    assert len(_network_journals.loaded) == len(collection.journals)
+    assert stored == ["runRangeIndex"]
+
+
+def test_journal_for_run_finds_runs_in_overlapping_generated_journals(monkeypatch, tmp_path):
+    monkeypatch.setattr(jv2backend.main.userCache, "_cache_dir", lambda: str(tmp_path))
+    monkeypatch.setattr(jv2backend.main.userCache, "_CACHE_ACTIVATED", True)
+
+    # An outer journal whose run range encloses that of the second
+    run_data = {filename: {run: {"run_number": str(run), "name": f"RUN{run}"} for run in runs}
+                for filename, runs in (("outer.xml", range(1, 31)), ("inner.xml", range(10, 16)))}
+    loader = _LoadingJournals(run_data)
+    monkeypatch.setattr(Journal, "get_run_data", lambda journal, ignore_cache=False: loader(journal))
+
+    def generated_collection() -> JournalCollection:
+        collection = JournalCollection(SourceType.Generated, "GeneratedKey", "/a/local/disk", "index.xml", "/data")
+        for filename in run_data:
+            collection.add_journal(filename, filename, "/data")
+        return collection
+
+    collection = generated_collection()
+    assert collection.journal_for_run(20).filename == "outer.xml"
+    assert collection.journal_for_run(12).filename == "inner.xml"
+
+    # A new collection for the same source locates runs without loading any journals
+    loader.loaded.clear()
+    collection = generated_collection()
+    assert collection.journal_for_run(20).filename == "outer.xml"
+    assert collection.journal_for_run(31) is None
+    assert not loader.loaded
+
+
+def test_search_only_loads_journals_which_may_contain_run_numbers(_network_journals, monkeypatch, tmp_path):
+    monkeypatch.setattr(jv2backend.main.userCache, "_cache_dir", lambda: str(tmp_path))
+    monkeypatch.setattr(jv2backend.main.userCache, "_CACHE_ACTIVATED", True)
+
+    collection = _network_collection(_network_journals.run_data)
+    for journal in collection.journals:
+        journal.get_run_data()
+
+    _network_journals.loaded.clear()
+    collection = _network_collection(_network_journals.run_data)
+    assert list(collection.search({"run_number": "118-123"})) == [118, 119, 120, 121, 122, 123]
+    assert sorted(_network_journals.loaded) == ["journal_11.xml", "journal_12.xml"]
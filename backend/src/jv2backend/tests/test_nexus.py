@@ -1,9 +1,12 @@
 # SPDX-License-Identifier: GPL-3.0-or-later
 # Copyright (c) 2024 Team JournalViewer and contributors
 
+import os
 from pathlib import Path
 import h5py as h5
+import numpy as np
 import jv2backend.main.nexus
+from jv2backend.utils import decode_float64_array
 
 import pytest
 
@@ -20,6 +23,20 @@ def sample_nexus_filepath(test_data_dir) -> Path:
     return test_data_dir / "ALF85423.nxs"
 
 
+@pytest.fixture()
+def synthetic_nexus_filepath(tmp_path) -> Path:
+    """Chunked, compressed NeXus-like file with known detector counts"""
+    filepath = tmp_path / "synthetic.nxs"
+    with h5.File(filepath, "w") as h5file:
+        entry = h5file.create_group("raw_data_1")
+        entry.attrs["NX_class"] = b"NXentry"
+        detector = entry.create_group("detector_1")
+        detector["time_of_flight"] = np.linspace(0.0, 1000.0, 101, dtype="float32")
+        counts = np.arange(1 * 64 * 100, dtype="int32").reshape(1, 64, 100)
+        detector.create_dataset("counts", data=counts, chunks=(1, 8, 100), compression="gzip")
+    return filepath
+
+
 def test_log_paths_returns_expected_paths_to_log_entries_if_file_is_accessible(
     sample_nexus_filepath,
 ):
@@ -66,12 +83,133 @@ def test_logvalues_gives_list_of_time_value_pairs_for_open_block(
         assert logdata[0][1] == pytest.approx(0.0)
 
 
+def test_logvalue_arrays_match_logvalues(sample_nexus_filepath):
+    with h5.File(sample_nexus_filepath) as h5file:
+        group = h5file["/raw_data_1/runlog/dae_beam_current"]
+        times, values, categories = jv2backend.main.nexus.logvalue_arrays(group)
+        logdata = jv2backend.main.nexus.logvalues(group)
+
+    assert categories is None
+    assert times.dtype == np.float64 and values.dtype == np.float64
+    assert list(zip(times.tolist(), values.tolist())) == logdata
+
+
+def test_logvalue_arrays_returns_category_indices_for_string_logs(tmp_path):
+    filepath = tmp_path / "strings.nxs"
+    with h5.File(filepath, "w") as h5file:
+        value_log = h5file.create_group("state").create_group("value_log")
+        value_log["time"] = np.array([0.0, 1.0, 2.0, 3.0], dtype="float32")
+        value_log["value"] = np.array([b"SETUP", b"RUNNING", b"SETUP", b"PAUSED"])
+
+    with h5.File(filepath) as h5file:
+        times, values, categories = jv2backend.main.nexus.logvalue_arrays(h5file["state"])
+
+    assert times.tolist() == [0.0, 1.0, 2.0, 3.0]
+    assert categories == ["PAUSED", "RUNNING", "SETUP"]
+    assert values.tolist() == [2.0, 1.0, 2.0, 0.0]
+
+
+def test_read_logvalues_reads_several_logs_and_reports_missing_ones(sample_nexus_filepath):
+    log_paths = ["runlog/dae_beam_current", "runlog/no_such_log", "runlog/good_frames"]
+    time_range, logs, missing = jv2backend.main.nexus.read_logvalues(sample_nexus_filepath, log_paths)
+
+    assert time_range == jv2backend.main.nexus.timerange_from_path(sample_nexus_filepath)
+    assert list(logs.keys()) == ["runlog/dae_beam_current", "runlog/good_frames"]
+    assert missing == ["runlog/no_such_log"]
+    with h5.File(sample_nexus_filepath) as h5file:
+        times, values, _ = jv2backend.main.nexus.logvalue_arrays(h5file["/raw_data_1/runlog/good_frames"])
+    assert logs["runlog/good_frames"][0].tolist() == times.tolist()
+    assert logs["runlog/good_frames"][1].tolist() == values.tolist()
+
+    with pytest.raises(KeyError):
+        jv2backend.main.nexus.read_logvalues(sample_nexus_filepath, ["runlog/no_such_log"])
+
+
+def test_log_statistics_summarise_numeric_and_string_logs(sample_nexus_filepath, tmp_path):
+    with h5.File(sample_nexus_filepath) as h5file:
+        _, values, _ = jv2backend.main.nexus.logvalue_arrays(h5file["/raw_data_1/runlog/dae_beam_current"])
+    statistics = jv2backend.main.nexus.log_statistics(sample_nexus_filepath, "runlog/dae_beam_current")
+    assert statistics["samples"] == values.size
+    assert statistics["mean"] == pytest.approx(values.mean())
+    assert statistics["min"] == values.min() and statistics["max"] == values.max()
+    assert statistics["last"] == values[-1]
+
+    filepath = tmp_path / "logs.nxs"
+    with h5.File(filepath, "w") as h5file:
+        entry = h5file.create_group("raw_data_1")
+        state = entry.create_group("state").create_group("value_log")
+        state["time"] = np.array([0.0, 1.0, 2.0])
+        state["value"] = np.array([b"SETUP", b"RUNNING", b"PAUSED"])
+        empty = entry.create_group("empty").create_group("value_log")
+        empty["time"] = np.array([0.0, 1.0])
+        empty["value"] = np.array([np.nan, np.inf])
+
+    assert jv2backend.main.nexus.log_statistics(filepath, "state") == \
+        {"samples": 3, "mean": None, "min": None, "max": None, "last": "PAUSED"}
+    assert jv2backend.main.nexus.log_statistics(filepath, "empty") == \
+        {"samples": 2, "mean": None, "min": None, "max": None, "last": None}
+
+
+def test_tail_logvalues_returns_samples_appended_while_file_is_written(tmp_path):
+    filepath = tmp_path / "live.nxs"
+    log_path = "/raw_data_1/selog/temperature"
+    with h5.File(filepath, "w", libver="latest") as writer:
+        value_log = writer.create_group(log_path + "/value_log")
+        times = value_log.create_dataset("time", data=np.arange(3, dtype="float32"), maxshape=(None,), chunks=(64,))
+        values = value_log.create_dataset("value", data=np.arange(3, dtype="float64") * 10, maxshape=(None,),
+                                          chunks=(64,))
+        writer.swmr_mode = True
+
+        try:
+            total, new_times, new_values, categories = jv2backend.main.nexus.tail_logvalues(filepath, log_path, 0)
+            assert total == 3 and categories is None
+            assert new_values.tolist() == [0.0, 10.0, 20.0]
+
+            # Append two samples, with the value of the second yet to be written
+            times.resize((5,))
+            times[3:] = [3.0, 4.0]
+            times.flush()
+            values.resize((4,))
+            values[3] = 30.0
+            values.flush()
+
+            total, new_times, new_values, _ = jv2backend.main.nexus.tail_logvalues(filepath, log_path, 3)
+            assert total == 4
+            assert new_times.tolist() == [3.0]
+            assert new_values.tolist() == [30.0]
+        finally:
+            jv2backend.main.nexus.LIVE_FILE_CACHE.clear()
+
+
+def test_tail_logvalues_reads_complete_files(sample_nexus_filepath):
+    log_path = "/raw_data_1/runlog/dae_beam_current"
+    with h5.File(sample_nexus_filepath) as h5file:
+        all_times, all_values, _ = jv2backend.main.nexus.logvalue_arrays(h5file[log_path])
+
+    try:
+        total, times, values, _ = jv2backend.main.nexus.tail_logvalues(sample_nexus_filepath, log_path, 2)
+        assert total == len(all_times)
+        assert times.tolist() == all_times[2:].tolist()
+        assert values.tolist() == all_values[2:].tolist()
+    finally:
+        jv2backend.main.nexus.LIVE_FILE_CACHE.clear()
+
+
 def test_spectra_count_returns_the_number_spectra_in_detector_1_entry(
     sample_nexus_filepath,
 ):
     assert jv2backend.main.nexus.get_detector_count(sample_nexus_filepath) == 2368
 
 
+def test_spectra_count_and_spectrum_read_from_chunked_file(synthetic_nexus_filepath):
+    assert jv2backend.main.nexus.get_detector_count(synthetic_nexus_filepath) == 64
+
+    data = jv2backend.main.nexus.get_detector_spectrum(synthetic_nexus_filepath, spectrum=37).points()
+    assert len(data) == 100
+    assert data[0] == pytest.approx((5.0, 3700.0))
+    assert data[99] == pytest.approx((995.0, 3799.0))
+
+
 def test_monitor_count_returns_the_number_monitors_in_the_first_entry(
     sample_nexus_filepath,
 ):
@@ -79,7 +217,7 @@ def test_monitor_count_returns_the_number_monitors_in_the_first_entry(
 
 
 def test_spectrum_returns_expected_spectrum_data(sample_nexus_filepath):
-    data = jv2backend.main.nexus.get_detector_spectrum(sample_nexus_filepath, spectrum=15)
+    data = jv2backend.main.nexus.get_detector_spectrum(sample_nexus_filepath, spectrum=15).points()
 
     assert len(data) == 1361
     assert data[714][0] == pytest.approx(793.703125)
@@ -87,7 +225,7 @@ def test_spectrum_returns_expected_spectrum_data(sample_nexus_filepath):
 
 
 def test_monitor_spectrum_returns_expected_monitor_data(sample_nexus_filepath):
-    data = jv2backend.main.nexus.get_monitor_spectrum(sample_nexus_filepath, monitor=2)
+    data = jv2backend.main.nexus.get_monitor_spectrum(sample_nexus_filepath, monitor=2).points()
 
     assert len(data) == 1361
     assert data[714][0] == pytest.approx(793.703125)
@@ -98,3 +236,279 @@ def test_nonzero_spectra_returns_ratio_as_string(sample_nexus_filepath):
     ratio_str = jv2backend.main.nexus.nonzero_spectra_ratio(sample_nexus_filepath)
 
     assert ratio_str == "974/2368"
+
+
+def test_detector_health_streams_counts_in_blocks(synthetic_nexus_filepath, sample_nexus_filepath):
+    health = jv2backend.main.nexus.detector_health(synthetic_nexus_filepath)
+    counts = np.arange(1 * 64 * 100).reshape(1, 64, 100)
+    assert health["spectra"] == 64
+    assert health["nonZeroSpectra"] == 64
+    assert health["totalCounts"] == int(counts.sum())
+    assert health["countsPerMicroAmpHour"] is None
+
+    health = jv2backend.main.nexus.detector_health(sample_nexus_filepath)
+    proton_charge = jv2backend.main.nexus.get_proton_charge(sample_nexus_filepath)
+    assert f"{health['nonZeroSpectra']}/{health['spectra']}" == "974/2368"
+    assert health["countsPerMicroAmpHour"] == pytest.approx(health["totalCounts"] / proton_charge)
+
+
+def test_detector_map_info_describes_tile_pyramid(sample_nexus_filepath):
+    info = jv2backend.main.nexus.get_detector_map_info(sample_nexus_filepath)
+
+    assert info["spectra"] == 2368
+    assert info["bins"] == 1361
+    assert info["tileSize"] == 256
+    # 2368 spectra need 16x reduction to fit a single tile
+    assert info["levels"] == 5
+    assert len(info["timeOfFlight"]) == 1362
+    with h5.File(sample_nexus_filepath) as h5file:
+        assert info["maxCount"] == h5file["raw_data_1/detector_1/counts"][()].max()
+
+
+def test_detector_map_tiles_average_blocks_of_counts(sample_nexus_filepath):
+    with h5.File(sample_nexus_filepath) as h5file:
+        counts = h5file["raw_data_1/detector_1/counts"][0]
+
+    def tile_values(tile):
+        return decode_float64_array(tile["data"]).reshape(tile["shape"])
+
+    full_resolution = jv2backend.main.nexus.get_detector_map_tile(sample_nexus_filepath, 0, 1, 2)
+    assert full_resolution["shape"] == [256, 256]
+    np.testing.assert_array_equal(tile_values(full_resolution), counts[256:512, 512:768])
+
+    top = jv2backend.main.nexus.get_detector_map_tile(sample_nexus_filepath, 4, 0, 0)
+    assert top["shape"] == [148, 86]
+    values = tile_values(top)
+    assert values[1][2] == pytest.approx(counts[16:32, 32:48].mean())
+    # The last column covers the single remaining time-of-flight bin
+    assert values[3][85] == pytest.approx(counts[48:64, 1360:].mean())
+
+
+@pytest.mark.parametrize("level, row, column", [(5, 0, 0), (0, 10, 0), (0, 0, 6), (1, -1, 0)])
+def test_detector_map_tile_raises_ValueError_for_missing_tiles(sample_nexus_filepath, level, row, column):
+    with pytest.raises(ValueError):
+        jv2backend.main.nexus.get_detector_map_tile(sample_nexus_filepath, level, row, column)
+
+
+def test_summed_spectra_match_sum_of_individual_spectra(sample_nexus_filepath):
+    spectra = jv2backend.main.nexus.spectrum_indices_from_string("10-12,15")
+    assert spectra == [10, 11, 12, 15]
+
+    summed = jv2backend.main.nexus.get_detector_spectra_sum(sample_nexus_filepath, spectra).points()
+    individual = [jv2backend.main.nexus.get_detector_spectrum(sample_nexus_filepath, s).points() for s in spectra]
+
+    assert len(summed) == 1361
+    for n in (0, 714, 1360):
+        assert summed[n][0] == pytest.approx(individual[0][n][0])
+        assert summed[n][1] == pytest.approx(sum(spectrum[n][1] for spectrum in individual))
+
+
+def test_encode_spectra_sends_shared_bin_edges_once(sample_nexus_filepath):
+    first = jv2backend.main.nexus.get_detector_spectrum(sample_nexus_filepath, 15)
+    second = jv2backend.main.nexus.get_detector_spectrum(sample_nexus_filepath, 16)
+    other = jv2backend.main.nexus.Spectrum(np.array([0.0, 1.0, 2.0]), np.array([3.0, 4.0]))
+
+    encoded = jv2backend.main.nexus.encode_spectra({1: first, 2: None, 3: second, 4: other})
+
+    assert len(encoded["axes"]) == 2
+    assert [entry["runNumber"] for entry in encoded["spectra"]] == [1, 2, 3, 4]
+    assert [entry.get("axis") for entry in encoded["spectra"]] == [0, None, 0, 1]
+    assert decode_float64_array(encoded["axes"][0]).tolist() == first.edges.tolist()
+    assert decode_float64_array(encoded["spectra"][2]["counts"]).tolist() == second.counts.tolist()
+    assert decode_float64_array(encoded["axes"][1]).tolist() == [0.0, 1.0, 2.0]
+
+
+def test_normalisation_combines_divisors_in_one_pass(sample_nexus_filepath):
+    raw = jv2backend.main.nexus.get_detector_spectrum(sample_nexus_filepath, 15)
+    monitor = jv2backend.main.nexus.get_monitor_spectrum(sample_nexus_filepath, 1)
+    charge = jv2backend.main.nexus.get_proton_charge(sample_nexus_filepath)
+    assert charge == pytest.approx(0.9252417)
+
+    normalisation = jv2backend.main.nexus.Normalisation(
+        per_proton_charge=True, per_microsecond=True, monitor=1
+    )
+    normalised = normalisation.apply(sample_nexus_filepath, raw)
+
+    divisor = charge * np.diff(raw.edges) * monitor.counts
+    expected = np.where(divisor != 0.0, raw.counts / np.where(divisor != 0.0, divisor, 1.0), raw.counts)
+    assert normalised.edges.tolist() == raw.edges.tolist()
+    assert normalised.counts == pytest.approx(expected)
+
+
+def test_normalisation_divisors_are_sent_with_raw_spectra(sample_nexus_filepath):
+    raw = jv2backend.main.nexus.get_detector_spectrum(sample_nexus_filepath, 15)
+    reference = jv2backend.main.nexus.Spectrum(raw.edges[::2], np.ones(len(raw.edges[::2]) - 1))
+
+    normalisation = jv2backend.main.nexus.Normalisation(per_proton_charge=True, monitor=1)
+    divisors = normalisation.divisors(sample_nexus_filepath, raw, reference=reference)
+    assert sorted(divisors) == ["monitor", "protonCharge", "reference"]
+    assert divisors["protonCharge"] == jv2backend.main.nexus.get_proton_charge(sample_nexus_filepath)
+    assert len(divisors["monitor"]) == len(divisors["reference"]) == len(raw.counts)
+
+    encoded = jv2backend.main.nexus.encode_spectra({1: raw}, {1: divisors})
+    entry = encoded["spectra"][0]
+    assert decode_float64_array(entry["counts"]).tolist() == raw.counts.tolist()
+    assert entry["divisors"]["protonCharge"] == divisors["protonCharge"]
+    assert decode_float64_array(entry["divisors"]["reference"]).tolist() == divisors["reference"].tolist()
+
+
+def test_normalisation_redistributes_reference_onto_spectrum_bins():
+    spectrum = jv2backend.main.nexus.Spectrum(np.array([0.0, 1.0, 2.0]), np.array([4.0, 9.0]))
+    reference = jv2backend.main.nexus.Spectrum(np.array([0.0, 2.0]), np.array([6.0]))
+
+    normalised = jv2backend.main.nexus.Normalisation().apply(Path("unused"), spectrum, reference=reference)
+    assert normalised.counts.tolist() == [4.0 / 3.0, 3.0]
+
+    empty = jv2backend.main.nexus.Spectrum(np.array([0.0, 1.0, 2.0]), np.array([0.0, 2.0]))
+    normalised = jv2backend.main.nexus.Normalisation().apply(Path("unused"), spectrum, reference=empty)
+    assert normalised.counts.tolist() == [4.0, 4.5]
+
+
+def test_normalisation_leaves_counts_unchanged_where_divisor_is_zero():
+    spectrum = jv2backend.main.nexus.Spectrum(np.array([0.0, 2.0, 2.0, 4.0, 6.0]), np.array([4.0, 5.0, 6.0, 8.0]))
+    reference = jv2backend.main.nexus.Spectrum(np.array([0.0, 2.0, 2.0, 4.0, 6.0]), np.array([1.0, 1.0, 0.0, 2.0]))
+
+    normalised = jv2backend.main.nexus.Normalisation(per_microsecond=True).apply(Path("unused"), spectrum,
+                                                                                 reference=reference)
+    # The second bin has zero width and the third a zero reference count
+    assert normalised.counts.tolist() == [2.0, 5.0, 6.0, 2.0]
+
+
+def test_normalisation_per_proton_charge_fails_without_charge(synthetic_nexus_filepath):
+    spectrum = jv2backend.main.nexus.read_spectrum(synthetic_nexus_filepath, "detector", 3)
+    with pytest.raises(ValueError):
+        jv2backend.main.nexus.Normalisation(per_proton_charge=True).apply(synthetic_nexus_filepath, spectrum)
+
+    # A read of several runs reports the run, rather than returning its raw counts
+    results = jv2backend.main.nexus.read_runs(
+        lambda filepath: jv2backend.main.nexus.Normalisation(per_proton_charge=True).apply(filepath, spectrum),
+        {1: str(synthetic_nexus_filepath)})
+    assert results[1].value is None
+    assert "proton charge" in results[1].error
+
+
+def test_cached_spectrum_reuses_reads_until_file_changes(synthetic_nexus_filepath):
+    first = jv2backend.main.nexus.cached_spectrum(synthetic_nexus_filepath, "detector", 3)
+    assert jv2backend.main.nexus.cached_spectrum(synthetic_nexus_filepath, "detector", 3) is first
+
+    stat = os.stat(synthetic_nexus_filepath)
+    os.utime(synthetic_nexus_filepath, ns=(stat.st_atime_ns, stat.st_mtime_ns + 1_000_000_000))
+    assert jv2backend.main.nexus.cached_spectrum(synthetic_nexus_filepath, "detector", 3) is not first
+
+
+def test_summed_spectra_raises_ValueError_for_missing_spectra(sample_nexus_filepath):
+    with pytest.raises(ValueError):
+        jv2backend.main.nexus.get_detector_spectra_sum(sample_nexus_filepath, [2367, 2368])
+
+
+@pytest.mark.parametrize("logarithmic", [False, True])
+def test_rebinned_spectrum_conserves_counts(sample_nexus_filepath, logarithmic):
+    rebinning = jv2backend.main.nexus.Rebinning(bin_count=100, logarithmic=logarithmic)
+    original = jv2backend.main.nexus.get_monitor_spectrum(sample_nexus_filepath, 1).points()
+    rebinned = jv2backend.main.nexus.get_monitor_spectrum(sample_nexus_filepath, 1, rebinning).points()
+
+    assert len(rebinned) == 100
+    assert sum(count for _, count in rebinned) == pytest.approx(sum(count for _, count in original))
+    assert all(a[0] < b[0] for a, b in zip(rebinned, rebinned[1:]))
+
+
+def test_rebinning_window_keeps_original_bins():
+    edges = [0.0, 1.0, 2.0, 3.0, 4.0]
+    counts = [1.0, 2.0, 3.0, 4.0]
+
+    new_edges, new_counts = jv2backend.main.nexus.Rebinning(tof_min=1.5, tof_max=3.0).apply(edges, counts)
+    assert new_edges.tolist() == [1.0, 2.0, 3.0]
+    assert new_counts.tolist() == [2.0, 3.0]
+
+    new_edges, new_counts = jv2backend.main.nexus.Rebinning(bin_count=2, tof_min=1.0, tof_max=3.0).apply(edges, counts)
+    assert new_edges.tolist() == [1.0, 2.0, 3.0]
+    assert new_counts.tolist() == pytest.approx([2.0, 3.0])
+
+    with pytest.raises(ValueError):
+        jv2backend.main.nexus.Rebinning(tof_min=5.0).apply(edges, counts)
+
+
+def test_file_cache_reuses_handles_and_reopens_modified_files(synthetic_nexus_filepath):
+    cache = jv2backend.main.nexus.NexusFileCache(max_size=2)
+
+    with cache.open(synthetic_nexus_filepath) as first:
+        pass
+    with cache.open(synthetic_nexus_filepath) as second:
+        assert second is first
+        assert second.mode == "r"
+
+    # Changing the modification time should result in a fresh handle
+    stat = synthetic_nexus_filepath.stat()
+    os.utime(synthetic_nexus_filepath, ns=(stat.st_atime_ns, stat.st_mtime_ns + 1000000000))
+    with cache.open(synthetic_nexus_filepath) as third:
+        assert third is not first
+        assert third.id.valid
+    assert not first.id.valid
+
+
+def test_file_cache_is_bounded_and_defers_closing_files_in_use(synthetic_nexus_filepath, sample_nexus_filepath, tmp_path):
+    cache = jv2backend.main.nexus.NexusFileCache(max_size=1)
+    other_filepath = tmp_path / "other.nxs"
+    other_filepath.write_bytes(sample_nexus_filepath.read_bytes())
+
+    with cache.open(synthetic_nexus_filepath) as in_use:
+        with cache.open(other_filepath):
+            assert len(cache) == 1
+        # Evicted, but still usable until released
+        assert in_use.id.valid
+        assert in_use["raw_data_1/detector_1/counts"].shape == (1, 64, 100)
+    assert not in_use.id.valid
+
+    cache.clear()
+    assert len(cache) == 0
+
+
+def test_file_cache_opens_files_outside_lock_and_keeps_first_handle(synthetic_nexus_filepath, monkeypatch):
+    cache = jv2backend.main.nexus.NexusFileCache()
+    h5_file = h5.File
+    opened = []
+
+    def open_file(*args, **kwargs):
+        assert not cache._lock.locked()
+        h5file = h5_file(*args, **kwargs)
+        opened.append(h5file)
+        # Simulate another thread opening the same file meanwhile
+        if len(opened) == 1:
+            with cache.open(synthetic_nexus_filepath):
+                pass
+        return h5file
+
+    monkeypatch.setattr(jv2backend.main.nexus.h5, "File", open_file)
+    with cache.open(synthetic_nexus_filepath) as h5file:
+        assert h5file is opened[1]
+        assert h5file.id.valid
+    assert not opened[0].id.valid
+    assert len(cache) == 1
+
+
+def test_read_runs_returns_results_in_run_order_with_per_run_errors(
+    sample_nexus_filepath, synthetic_nexus_filepath
+):
+    data_files = {
+        3: str(synthetic_nexus_filepath),
+        1: None,
+        2: str(sample_nexus_filepath),
+        4: "/bad/file/path.nxs",
+    }
+    results = jv2backend.main.nexus.read_runs(jv2backend.main.nexus.get_detector_count, data_files)
+
+    assert list(results.keys()) == [3, 1, 2, 4]
+    assert results[3].value == 64 and results[3].error is None
+    assert results[2].value == 2368 and results[2].error is None
+    assert "Unable to find data file for run 1" in results[1].error
+    assert results[4].value is None and results[4].error is not None
+
+
+def test_read_runs_reads_only_files_which_exist(sample_nexus_filepath):
+    read = []
+    data_files = {1: "/bad/file/path.nxs", 2: str(sample_nexus_filepath)}
+    results = jv2backend.main.nexus.read_runs(lambda filepath: read.append(filepath), data_files)
+
+    assert read == [str(sample_nexus_filepath)]
+    assert "path.nxs" in results[1].error
+    assert results[2].error is None
@@ -0,0 +1,122 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+import os
+from pathlib import Path
+import jv2backend.main.nexus
+import jv2backend.main.nexusIndex
+
+import pytest
+
+
+@pytest.fixture()
+def sample_nexus_filepath() -> Path:
+    """Sample NeXus file on fake server"""
+    return Path(__file__).parent / "data/fake_server/ALF85423.nxs"
+
+
+@pytest.fixture()
+def synthetic_file(tmp_path) -> Path:
+    """Arbitrary file whose metadata can be changed"""
+    filepath = tmp_path / "file.nxs"
+    filepath.write_bytes(b"0123456789")
+    return filepath
+
+
+class CountingReader:
+    """Wraps a metadata function, counting the number of times it is called"""
+
+    def __init__(self, function):
+        self.function = function
+        self.calls = 0
+
+    def __call__(self, filepath):
+        self.calls += 1
+        return self.function(filepath)
+
+
+def test_index_records_values_persistently(sample_nexus_filepath, tmp_path):
+    database = str(tmp_path / "index.sqlite3")
+    reader = CountingReader(jv2backend.main.nexus.logpaths_from_path)
+
+    index = jv2backend.main.nexusIndex.NexusIndex(database)
+    first = index.get(sample_nexus_filepath, "logPaths", reader)
+    assert index.get(sample_nexus_filepath, "logPaths", reader) == first
+    assert reader.calls == 1
+    index.close()
+
+    # A new index on the same database answers without reading the file
+    index = jv2backend.main.nexusIndex.NexusIndex(database)
+    assert index.get(sample_nexus_filepath, "logPaths", reader) == first
+    assert reader.calls == 1
+    assert len(index) == 1
+    index.close()
+
+
+def test_index_discards_values_when_file_changes(synthetic_file, tmp_path):
+    index = jv2backend.main.nexusIndex.NexusIndex(str(tmp_path / "index.sqlite3"))
+    reader = CountingReader(lambda filepath: os.path.getsize(filepath))
+
+    index.get(synthetic_file, "size", reader)
+    index.put(synthetic_file, {"other": 1})
+    stat = os.stat(synthetic_file)
+    os.utime(synthetic_file, ns=(stat.st_atime_ns, stat.st_mtime_ns + 1_000_000_000))
+
+    index.get(synthetic_file, "size", reader)
+    assert reader.calls == 2
+    other = CountingReader(lambda filepath: 2)
+    assert index.get(synthetic_file, "other", other) == 2
+    assert other.calls == 1
+
+
+def test_index_raises_for_missing_files(tmp_path):
+    index = jv2backend.main.nexusIndex.NexusIndex()
+    with pytest.raises(FileNotFoundError):
+        index.get(tmp_path / "missing.nxs", "logPaths", jv2backend.main.nexus.logpaths_from_path)
+
+
+def test_lookup_and_populate_use_initialised_index(sample_nexus_filepath, tmp_path):
+    jv2backend.main.nexusIndex.initialise(str(tmp_path / "index.sqlite3"))
+    try:
+        jv2backend.main.nexusIndex.populate(sample_nexus_filepath)
+        assert len(jv2backend.main.nexusIndex._INDEX) == 1
+        assert jv2backend.main.nexusIndex.lookup(sample_nexus_filepath, "spectrumCount") == 2368
+        assert jv2backend.main.nexusIndex.nonzero_spectra_ratio(sample_nexus_filepath) == \
+            jv2backend.main.nexus.nonzero_spectra_ratio(sample_nexus_filepath)
+    finally:
+        jv2backend.main.nexusIndex._INDEX = None
+
+
+def test_log_statistics_are_recorded_per_log(sample_nexus_filepath, tmp_path):
+    jv2backend.main.nexusIndex.initialise(str(tmp_path / "index.sqlite3"))
+    try:
+        statistics = jv2backend.main.nexusIndex.log_statistics(sample_nexus_filepath, "runlog/dae_beam_current")
+        assert statistics == jv2backend.main.nexus.log_statistics(sample_nexus_filepath, "runlog/dae_beam_current")
+        assert jv2backend.main.nexusIndex.log_statistics(sample_nexus_filepath, "runlog/good_frames") != statistics
+
+        # Both logs are held against the one file
+        assert len(jv2backend.main.nexusIndex._INDEX) == 1
+        with pytest.raises(KeyError):
+            jv2backend.main.nexusIndex.log_statistics(sample_nexus_filepath, "runlog/no_such_log")
+    finally:
+        jv2backend.main.nexusIndex._INDEX = None
+
+
+def test_detector_map_info_reads_counts_once(sample_nexus_filepath, tmp_path, monkeypatch):
+    reader = CountingReader(jv2backend.main.nexus.detector_health)
+    monkeypatch.setitem(jv2backend.main.nexusIndex.FIELDS, "detectorHealth", reader)
+    jv2backend.main.nexusIndex.initialise(str(tmp_path / "index.sqlite3"))
+    try:
+        info = jv2backend.main.nexusIndex.detector_map_info(sample_nexus_filepath)
+        assert info == jv2backend.main.nexus.get_detector_map_info(sample_nexus_filepath)
+        assert jv2backend.main.nexusIndex.detector_map_info(sample_nexus_filepath) == info
+        assert reader.calls == 1
+
+        # Detector health scans and spectra ratios share the same read
+        assert jv2backend.main.nexusIndex.lookup(sample_nexus_filepath, "detectorHealth")["maxCount"] == \
+            info["maxCount"]
+        assert jv2backend.main.nexusIndex.nonzero_spectra_ratio(sample_nexus_filepath) == \
+            jv2backend.main.nexus.nonzero_spectra_ratio(sample_nexus_filepath)
+        assert reader.calls == 1
+    finally:
+        jv2backend.main.nexusIndex._INDEX = None
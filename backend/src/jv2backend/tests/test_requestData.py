@@ -161,3 +161,20 @@ def test_unknown_parameter_requested():
     with pytest.raises(RuntimeError) as exc:
         value = data.parameter("beta")
     assert str(exc.value) == "The parameter 'beta' is not in the request data."
+
+
+def test_optional_parameters():
+    post_data = {
+        "sourceID": POST_SOURCE_ID,
+        "sourceType": POST_JOURNAL_SOURCE_TYPE,
+        "alpha": "man"
+    }
+
+    try:
+        data = RequestData(post_data, optional_parameters="alpha,beta")
+    except Exception as exc:
+        pytest.fail(f"Unexpected exception: {exc}")
+
+    assert data.has_parameter("alpha")
+    assert data.parameter("alpha") == "man"
+    assert not data.has_parameter("beta")
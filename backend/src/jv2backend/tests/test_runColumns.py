@@ -0,0 +1,58 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+import datetime
+
+from jv2backend.classes.runColumns import RunColumns
+
+import pytest
+
+_RUN_DATA = {
+    12: {"start_time": "2023-02-03T12:30:00"},
+    10: {"start_time": "2023-02-01T09:00:00"},
+    11: {"start_time": "2023-02-02T09:00:00"},
+    14: {},
+    13: {"start_time": "2023-02-02T09:00:00"},
+}
+
+
+@pytest.fixture
+def _columns() -> RunColumns:
+    return RunColumns(_RUN_DATA)
+
+
+@pytest.mark.parametrize("first,last,runs", [(None, None, [10, 11, 12, 13, 14]), (11, 13, [11, 12, 13]),
+                                             (None, 10, [10]), (14, None, [14]), (15, 20, [])])
+def test_runs_in_number_range(_columns, first, last, runs):
+    assert _columns.runs_in_number_range(first, last).tolist() == runs
+
+
+@pytest.mark.parametrize("start,end,inclusive,runs", [
+    (datetime.datetime(2023, 2, 2, 9), datetime.datetime(2023, 2, 3, 12, 30), True, [11, 13, 12]),
+    (datetime.datetime(2023, 2, 2, 9), datetime.datetime(2023, 2, 3, 12, 30), False, []),
+    (None, datetime.datetime(2023, 2, 2, 9), False, [10]),
+    (datetime.datetime(2023, 2, 2, 9), None, False, [12]),
+    (None, None, True, [10, 11, 13, 12]),
+])
+def test_runs_in_time_range(_columns, start, end, inclusive, runs):
+    assert _columns.runs_in_time_range(start, end, inclusive).tolist() == runs
+
+
+def test_bounds(_columns):
+    assert len(_columns) == 5
+    assert _columns.run_bounds() == (10, 14)
+    epoch = datetime.datetime(1970, 1, 1)
+    assert _columns.start_time_bounds() == ((datetime.datetime(2023, 2, 1, 9) - epoch).total_seconds(),
+                                            (datetime.datetime(2023, 2, 3, 12, 30) - epoch).total_seconds())
+
+
+def test_non_iso_start_times_are_parsed_individually():
+    columns = RunColumns({1: {"start_time": "2023-02-01T09:00:00"}, 2: {"start_time": "yesterday"}})
+    assert columns.runs_in_time_range(None, None, True).tolist() == [1]
+
+
+def test_empty_columns_have_no_bounds():
+    columns = RunColumns(None)
+    assert columns.run_bounds() is None
+    assert columns.start_time_bounds() is None
+    assert columns.runs_in_number_range(1, 10).tolist() == []
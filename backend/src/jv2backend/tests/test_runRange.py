@@ -33,6 +33,13 @@ def test_construction_from_string_missing_last():
     assert 11 not in irange
 
 
+def test_construction_from_string_single_value():
+    irange = IntegerRange.from_string("10")
+    assert 10 in irange
+    assert 9 not in irange
+    assert 11 not in irange
+
+
 def test_extend_range():
     irange = IntegerRange(1, 8)
 
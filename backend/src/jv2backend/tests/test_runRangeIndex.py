@@ -0,0 +1,52 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+from jv2backend.classes.runRangeIndex import RunRangeIndex
+
+import pytest
+
+
+@pytest.fixture
+def _index() -> RunRangeIndex:
+    index = RunRangeIndex()
+    index.update("b.xml", [(20, 29), (35, 40)])
+    index.update("a.xml", [(1, 10)])
+    index.update("empty.xml", [])
+    return index
+
+
+@pytest.mark.parametrize("run_number,filename", [(1, "a.xml"), (10, "a.xml"), (20, "b.xml"), (37, "b.xml"),
+                                                 (0, None), (11, None), (30, None), (41, None)])
+def test_find_returns_journal_containing_run(_index, run_number, filename):
+    assert _index.find(run_number) == filename
+
+
+@pytest.mark.parametrize("run_number,filename", [(5, "outer.xml"), (12, "inner.xml"), (18, "outer.xml"),
+                                                 (25, "overlap.xml"), (45, "overlap.xml"), (51, None)])
+def test_find_returns_journal_containing_run_in_overlapping_ranges(run_number, filename):
+    index = RunRangeIndex()
+    index.update("outer.xml", [(1, 30)])
+    index.update("inner.xml", [(10, 15)])
+    index.update("overlap.xml", [(25, 50)])
+    assert index.find(run_number) == filename
+
+
+def test_journals_without_runs_are_known_but_have_no_bounds(_index):
+    assert "empty.xml" in _index
+    assert "missing.xml" not in _index
+    assert _index.bounds("empty.xml") is None
+    assert _index.bounds("b.xml") == (20, 40)
+
+
+def test_update_replaces_ranges_and_reports_changes(_index):
+    assert not _index.update("a.xml", [(1, 10)])
+    assert _index.update("a.xml", [(1, 15)])
+    assert _index.find(15) == "a.xml"
+    assert len(_index) == 3
+
+
+def test_index_round_trips_through_json(_index):
+    restored = RunRangeIndex.from_json(_index.to_json())
+    assert len(restored) == 3
+    assert restored.find(38) == "b.xml"
+    assert restored.bounds("a.xml") == (1, 10)
@@ -0,0 +1,167 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+from jv2backend.classes.searchIndex import SearchIndex, TopRuns
+import jv2backend.classes.searchIndex
+import jv2backend.main.selector
+
+import pytest
+
+
+def _run(run_number: int, title: str, user_name: str, start_time: str, experiment_identifier: str = "1000") -> dict:
+    return {"run_number": str(run_number), "title": title, "user_name": user_name,
+            "start_time": start_time, "experiment_identifier": experiment_identifier}
+
+
+_JOURNAL_A = {
+    1: _run(1, "Silicon powder 300K", "Smith", "2023-02-01T09:00:00"),
+    2: _run(2, "Silicon powder 10K", "Smith", "2023-02-02T09:00:00"),
+    3: _run(3, "Empty can", "Jones-Smith", "2023-02-03T12:30:00", "2000"),
+}
+_JOURNAL_B = {
+    10: _run(10, "Vanadium rod", "Jones", "2023-03-01T00:00:00", "2000"),
+    11: _run(11, "Powdered sugar", "Brown", "2023-03-02T18:45:00", "3000"),
+}
+
+
+@pytest.fixture
+def _index() -> SearchIndex:
+    index = SearchIndex()
+    index.update("a.xml", _JOURNAL_A)
+    index.update("b.xml", _JOURNAL_B)
+    return index
+
+
+def _scan(search_terms: dict, case_sensitive: bool = False) -> dict:
+    """Return the matches for the search terms from a full scan with the
+    selector"""
+    matches = {**_JOURNAL_A, **_JOURNAL_B}
+    for field, value in search_terms.items():
+        matches = jv2backend.main.selector.select(matches, field, value, case_sensitive)
+    return matches
+
+
+@pytest.mark.parametrize("search_terms", [
+    {"title": "powder"}, {"title": "POWDER"}, {"title": "silicon pow"}, {"title": "con pow"},
+    {"title": "der 1"}, {"title": "  "}, {"title": "nothing"}, {"user_name": "smith"},
+    {"user_name": "s-sm"}, {"experiment_identifier": "2000"}, {"run_number": "2-10"},
+    {"run_number": "<3"}, {"run_number": ">3"}, {"run_number": "11"}, {"run_number": "1-x"},
+    {"start_time": "2023/02/02-2023/03/01"}, {"start_time": "<2023/02/03"}, {"start_time": ">2023/02/03"},
+    {"title": "powder", "user_name": "smith", "run_number": ">1"},
+    {"title": "o", "start_time": ">2023/02/01", "experiment_identifier": "1000"},
+])
+@pytest.mark.parametrize("case_sensitive", [False, True])
+def test_search_matches_full_scan(_index, search_terms, case_sensitive):
+    matches = _index.search(search_terms, case_sensitive)
+    assert matches == _scan(search_terms, case_sensitive)
+    assert list(matches) == sorted(matches)
+
+
+@pytest.mark.parametrize("search_terms", [
+    {"title~": "silicon powdr"}, {"title~": "10K powder Silicon"}, {"title~": "vanadum"}, {"title~": "powder"},
+    {"title~": "!!"}, {"title~": "powder", "user_name": "smith"}, {"title~": "can empty", "run_number": "<3"},
+])
+def test_similar_titles_match_full_scan_in_order(_index, search_terms):
+    assert list(_index.search(search_terms).items()) == list(_scan(search_terms).items())
+
+
+def test_similar_titles_are_ranked(_index):
+    assert list(_index.search({"title~": "Silicon powder 10"})) == [2, 1, 11]
+    assert list(_index.search({"title~": "powder"})) == [11, 2, 1]
+
+
+def test_similarity_is_symmetric():
+    lco, la2cuo4 = jv2backend.main.selector.trigrams("LCO 10 K"), jv2backend.main.selector.trigrams("La2CuO4 10K")
+    assert jv2backend.main.selector.similarity(lco, la2cuo4) == jv2backend.main.selector.similarity(la2cuo4, lco)
+
+
+def test_similar_titles_include_abbreviations_but_not_fragments(_index):
+    _index.update("c.xml", {20: _run(20, "La2CuO4 10K", "Brown", "2023-04-01T00:00:00")})
+    assert list(_index.search({"title~": "LCO 10 K"})) == [20]
+    # A short string is not similar to a longer title merely by being part of it
+    assert list(_index.search({"title~": "LC"})) == []
+    assert list(_index.search({"title~": "LCO 10 K"}).items()) == \
+        list(jv2backend.main.selector.select(_index.search({}), "title~", "LCO 10 K").items())
+
+
+def test_update_replaces_runs_of_journal(_index):
+    _index.update("a.xml", {4: _run(4, "Nickel powder", "Smith", "2023-02-04T09:00:00")})
+    assert len(_index) == 3
+    assert list(_index.search({"title": "powder"})) == [4, 11]
+    assert list(_index.search({"title": "silicon"})) == []
+    assert list(_index.search({"title~": "silicon"})) == []
+    assert list(_index.search({"title~": "nickle powder"})) == [4, 11]
+    assert list(_index.search({"run_number": "<10"})) == [4]
+
+    _index.update("b.xml", None)
+    assert list(_index.search({})) == [4]
+
+
+def test_invalid_values_are_rejected(_index):
+    with pytest.raises(ValueError):
+        _index.search({"run_number": "x"})
+    with pytest.raises(RuntimeError):
+        _index.search({"start_time": "2023/02/01"})
+
+
+def test_plan_orders_terms_by_cost_and_selectivity(_index):
+    plan = _index.plan({"title": "powder", "foo": "bar", "run_number": "1-11", "experiment_identifier": "3000"})
+    assert [(step.field, step.method, step.estimate) for step in plan.steps] == [
+        ("experiment_identifier", "values", 1), ("run_number", "columns", 5),
+        ("title", "tokens", None), ("foo", "scan", None)]
+    assert sorted(plan.journals) == ["a.xml", "b.xml"]
+
+
+@pytest.mark.parametrize("search_terms,journals", [
+    ({"run_number": "<10"}, ["a.xml"]), ({"run_number": "4-9"}, []), ({"run_number": "1-x"}, []),
+    ({"start_time": ">2023/02/28"}, ["b.xml"]), ({"start_time": "<2023/02/03", "run_number": ">2"}, ["a.xml"]),
+    ({"start_time": "2024/01/01-2024/12/31"}, []),
+])
+def test_plan_excludes_journals_outside_bounds(_index, search_terms, journals):
+    assert _index.plan(search_terms).journals == journals
+    assert _index.search(search_terms) == _scan(search_terms)
+
+
+_RUNS = list(_JOURNAL_A.values()) + list(_JOURNAL_B.values()) + [{"run_number": "x", "title": "No start time"}]
+
+
+@pytest.mark.parametrize("sort_by,offset,limit,runs", [
+    (None, 0, None, ["1", "2", "3", "10", "11", "x"]),
+    (None, 2, 2, ["3", "10"]),
+    ("run_number", 0, None, ["1", "2", "3", "10", "11", "x"]),
+    ("-run_number", 0, 3, ["11", "10", "3"]),
+    ("-start_time", 1, 2, ["10", "3"]),
+    ("-start_time", 4, None, ["1", "x"]),
+    ("title", 0, 2, ["3", "x"]),
+])
+def test_top_runs_retains_leading_runs(sort_by, offset, limit, runs):
+    top = TopRuns.sorted_by(sort_by, None if limit is None else offset + limit)
+    top.add(iter(_RUNS[:3]))
+    top.add(iter(_RUNS[3:]))
+    assert [run["run_number"] for run in top.runs(offset, limit)] == runs
+    assert top.total == len(_RUNS)
+    assert top.retained == len(_RUNS) if limit is None else offset + limit
+
+
+@pytest.mark.parametrize("sort_by", [None, "run_number", "-run_number", "-start_time", "title"])
+def test_bounded_top_runs_match_all_sorted_runs(sort_by):
+    everything = TopRuns.sorted_by(sort_by)
+    everything.add(_RUNS)
+    for capacity in range(len(_RUNS) + 1):
+        top = TopRuns.sorted_by(sort_by, capacity)
+        top.add(_RUNS)
+        assert top.runs() == everything.runs()[:capacity]
+
+
+def test_top_runs_rank_by_key_keeping_earlier_of_equal_runs():
+    top = TopRuns(2, key=lambda run: len(run["title"]), descending=True)
+    top.add([{"title": "abc"}, {"title": "abcd"}, {"title": "wxyz"}, {"title": "a"}])
+    assert top.runs() == [{"title": "abcd"}, {"title": "wxyz"}]
+    assert top.total == 4
+
+
+def test_search_chunks_match_search(_index, monkeypatch):
+    monkeypatch.setattr(jv2backend.classes.searchIndex, "MATCH_CHUNK_SIZE", 2)
+    chunks = list(_index.search_chunks({"title": "powder"}))
+    assert [list(chunk) for chunk in chunks] == [[1, 2], [11]]
+    assert {run: data for chunk in chunks for run, data in chunk.items()} == _index.search({"title": "powder"})
@@ -0,0 +1,135 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+from threading import Event
+
+from jv2backend.classes.collection import JournalCollection
+from jv2backend.classes.journal import Journal, SourceType
+from jv2backend.main.searcher import JournalSearcher
+
+import pytest
+import requests
+
+
+def _run_data(n: int) -> dict:
+    return {run: {"run_number": str(run), "name": f"RUN{run}", "title": "vanadium" if run % 2 else "empty can"}
+            for run in range(n * 10, n * 10 + 10)}
+
+
+@pytest.fixture
+def _collection(monkeypatch) -> JournalCollection:
+    # Eight journals of ten runs each, the first already loaded and the last failing to load
+    def get_run_data(journal: Journal, ignore_cache: bool = False):
+        n = int(journal.filename[8:10])
+        if n == 7:
+            raise requests.HTTPError("Not found")
+        journal.run_data = _run_data(n)
+
+    monkeypatch.setattr(Journal, "get_run_data", get_run_data)
+    collection = JournalCollection(SourceType.Network, "SearchKey", "http://a.server", "index.xml", "/data")
+    for n in range(8):
+        collection.add_journal(f"journal_{n:02d}.xml", f"journal_{n:02d}.xml", "/data",
+                               _run_data(0) if n == 0 else None)
+    return collection
+
+
+def _wait(searcher: JournalSearcher, search_id: int) -> dict:
+    while True:
+        update = searcher.get_update(search_id)
+        if update["complete"]:
+            return update
+        Event().wait(0.01)
+
+
+def test_search_streams_matches_from_all_journals(_collection):
+    searcher = JournalSearcher()
+    started = searcher.start(_collection, {"title": "VANADIUM", "caseSensitive": "false"})
+    assert started["numJournals"] == 8
+
+    update = _wait(searcher, started["searchId"])
+    assert update["numCompleted"] == 8
+    assert sorted(int(run["run_number"]) for run in update["results"]) == [run for run in range(70) if run % 2]
+    assert list(update["errors"]) == ["journal_07.xml"]
+
+    # Matches from the first requested onwards
+    assert len(searcher.get_update(started["searchId"], 30)["results"]) == 5
+
+
+def test_search_continues_past_journals_which_fail(_collection, monkeypatch):
+    # A journal whose run data can't be interpreted, in addition to the last which fails to load
+    get_run_data = Journal.get_run_data
+
+    def failing_get_run_data(journal: Journal, ignore_cache: bool = False):
+        if journal.filename == "journal_03.xml":
+            raise ValueError("invalid literal for int() with base 10: 'x'")
+        get_run_data(journal, ignore_cache)
+
+    monkeypatch.setattr(Journal, "get_run_data", failing_get_run_data)
+    searcher = JournalSearcher()
+    search_id = searcher.start(_collection, {"title": "vanadium"})["searchId"]
+
+    update = _wait(searcher, search_id)
+    assert update["numCompleted"] == 8
+    assert sorted(update["errors"]) == ["journal_03.xml", "journal_07.xml"]
+    assert sorted(int(run["run_number"]) for run in update["results"]) == \
+        [run for run in range(70) if run % 2 and run // 10 != 3]
+
+
+def test_new_search_replaces_old(_collection):
+    searcher = JournalSearcher()
+    first = searcher.start(_collection, {"title": "can"})["searchId"]
+    second = searcher.start(_collection, {"run_number": "10-12"})["searchId"]
+
+    assert searcher.get_update(first) is None
+    assert not searcher.stop(first)
+    assert [run["run_number"] for run in _wait(searcher, second)["results"]] == ["10", "11", "12"]
+
+
+def test_stopped_search_completes(_collection):
+    searcher = JournalSearcher()
+    search_id = searcher.start(_collection, {"title": "can"})["searchId"]
+    assert searcher.stop(search_id)
+
+    update = _wait(searcher, search_id)
+    assert update["stopped"]
+    assert update["numCompleted"] <= 8
+
+
+def test_invalid_search_terms_are_reported(_collection):
+    searcher = JournalSearcher()
+    search_id = searcher.start(_collection, {"run_number": "x"})["searchId"]
+    assert "searchTerms" in _wait(searcher, search_id)["errors"]
+
+
+def test_sorted_matches_are_paged_once_complete(_collection):
+    searcher = JournalSearcher()
+    search_id = searcher.start(_collection, {"title": "vanadium"}, "-run_number")["searchId"]
+
+    update = _wait(searcher, search_id)
+    assert update["numMatches"] == update["totalEstimate"] == 35
+    assert [run["run_number"] for run in update["results"][:3]] == ["69", "67", "65"]
+
+    page = searcher.get_update(search_id, 10, 5)
+    assert [run["run_number"] for run in page["results"]] == ["49", "47", "45", "43", "41"]
+
+
+def test_only_leading_matches_are_retained(_collection):
+    searcher = JournalSearcher()
+    search_id = searcher.start(_collection, {"title": "vanadium"}, "run_number", limit=4)["searchId"]
+
+    update = _wait(searcher, search_id)
+    assert update["numMatches"] == 35
+    assert update["numRetained"] == 4
+    assert [run["run_number"] for run in update["results"]] == ["1", "3", "5", "7"]
+    assert searcher.get_update(search_id, 4)["results"] == []
+
+
+def test_similar_matches_are_ranked_within_limit(_collection):
+    _collection.journals[2].run_data = {20: {"run_number": "20", "name": "RUN20", "title": "vanadium rod"}}
+    searcher = JournalSearcher()
+    search_id = searcher.start(_collection, {"title~": "vanadium rod"}, limit=2)["searchId"]
+
+    update = _wait(searcher, search_id)
+    # The closest match leads, followed by the first found of those equally close
+    assert [run["run_number"] for run in update["results"]] == ["20", "1"]
+    assert update["numMatches"] > update["numRetained"] == 2
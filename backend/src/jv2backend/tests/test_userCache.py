@@ -0,0 +1,111 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# Copyright (c) 2024 Team JournalViewer and contributors
+
+import datetime
+
+import jv2backend.main.userCache
+
+import pytest
+
+
+@pytest.fixture
+def _cache(monkeypatch, tmp_path):
+    monkeypatch.setattr(jv2backend.main.userCache, "_cache_dir", lambda: str(tmp_path))
+    monkeypatch.setattr(jv2backend.main.userCache, "_CACHE_ACTIVATED", True)
+    monkeypatch.setattr(jv2backend.main.userCache, "_STORES", {})
+    monkeypatch.setattr(jv2backend.main.userCache, "_LEGACY_FILES", {})
+    return tmp_path
+
+
+def test_data_round_trip(_cache):
+    mtime = datetime.datetime(2024, 3, 1, 12, 30)
+    jv2backend.main.userCache.put_data("SOURCE", "journal_1.xml", '{"1": {"title": "Vanadium"}}', mtime)
+    jv2backend.main.userCache.put_data("SOURCE", "journal_2.xml", "{}")
+
+    assert jv2backend.main.userCache.has_data("SOURCE", "journal_1.xml")
+    assert not jv2backend.main.userCache.has_data("SOURCE", "journal_3.xml")
+    assert not jv2backend.main.userCache.has_data("OTHER", "journal_1.xml")
+    assert jv2backend.main.userCache.get_data("SOURCE", "journal_1.xml") == (b'{"1": {"title": "Vanadium"}}', mtime)
+    assert jv2backend.main.userCache.get_data("SOURCE", "journal_2.xml") == (b"{}", None)
+    assert jv2backend.main.userCache.has_mtime("SOURCE", "journal_1.xml")
+    assert not jv2backend.main.userCache.has_mtime("SOURCE", "journal_2.xml")
+    assert jv2backend.main.userCache.get_file_size("SOURCE", "journal_1.xml") == 28
+    assert jv2backend.main.userCache.count_missing("SOURCE", ["journal_1.xml", "journal_2.xml", "journal_3.xml"]) == 1
+
+    # Replacing data updates the manifest
+    jv2backend.main.userCache.put_data("SOURCE", "journal_2.xml", "[]", mtime)
+    assert jv2backend.main.userCache.get_data("SOURCE", "journal_2.xml") == (b"[]", mtime)
+
+
+def test_manifest_is_read_from_existing_store(_cache, monkeypatch):
+    mtime = datetime.datetime(2024, 3, 1, 12, 30)
+    jv2backend.main.userCache.put_data("SOURCE", "journal_1.xml", "{}", mtime)
+
+    monkeypatch.setattr(jv2backend.main.userCache, "_STORES", {})
+    assert jv2backend.main.userCache.get_mtime("SOURCE", "journal_1.xml") == mtime
+    assert jv2backend.main.userCache.get_data("SOURCE", "journal_1.xml") == (b"{}", mtime)
+
+
+def test_legacy_cache_files_are_moved_into_store(_cache):
+    mtime = datetime.datetime(2024, 3, 1, 12, 30)
+    data_file = jv2backend.main.userCache._legacy_cache_file("SOURCE", "journal_1.xml")
+    data_file.write_bytes(b'{"1": {}}')
+    mtime_file = jv2backend.main.userCache._legacy_cache_file_mtime("SOURCE", "journal_1.xml")
+    mtime_file.write_bytes(bytes(str(mtime), "utf-8"))
+
+    jv2backend.main.userCache.expect_data("SOURCE", ["journal_1.xml"])
+    assert jv2backend.main.userCache.has_data("SOURCE", "journal_1.xml")
+    assert jv2backend.main.userCache.get_data("SOURCE", "journal_1.xml") == (b'{"1": {}}', mtime)
+    assert not data_file.exists()
+    assert not mtime_file.exists()
+
+
+def test_legacy_cache_files_are_only_found_when_cache_directory_is_listed(_cache, monkeypatch):
+    jv2backend.main.userCache.expect_data("SOURCE", ["journal_1.xml"])
+    assert jv2backend.main.userCache.count_missing("SOURCE", ["journal_1.xml"]) == 1
+
+    # Lookups use the listing of the cache directory taken when data were first expected
+    jv2backend.main.userCache._legacy_cache_file("SOURCE", "journal_1.xml").write_bytes(b"{}")
+    jv2backend.main.userCache.expect_data("SOURCE", ["journal_1.xml"])
+    assert not jv2backend.main.userCache.has_data("SOURCE", "journal_1.xml")
+
+    monkeypatch.setattr(jv2backend.main.userCache, "_STORES", {})
+    monkeypatch.setattr(jv2backend.main.userCache, "_LEGACY_FILES", {})
+    jv2backend.main.userCache.expect_data("SOURCE", ["journal_1.xml", "journal_2.xml"])
+    assert jv2backend.main.userCache.count_missing("SOURCE", ["journal_1.xml", "journal_2.xml"]) == 1
+    assert jv2backend.main.userCache.get_data("SOURCE", "journal_1.xml") == (b"{}", None)
+
+
+def test_legacy_cache_files_are_claimed_only_by_their_source(_cache, monkeypatch):
+    for source_id in ("SOURCE", "OTHER"):
+        jv2backend.main.userCache._legacy_cache_file(source_id, "journal_1.xml").write_bytes(b"{}")
+    jv2backend.main.userCache._legacy_cache_file("SOURCE", "orphan.xml").write_bytes(b"{}")
+
+    hashed = []
+    item_hash = jv2backend.main.userCache._item_hash
+    monkeypatch.setattr(jv2backend.main.userCache, "_item_hash",
+                        lambda source_id, data_name: hashed.append(data_name) or item_hash(source_id, data_name))
+
+    # Only expected names are hashed, and lookups of other names hash nothing
+    jv2backend.main.userCache.expect_data("SOURCE", ["journal_1.xml", "journal_2.xml"])
+    assert hashed == ["journal_1.xml", "journal_2.xml"]
+    hashed.clear()
+    assert jv2backend.main.userCache.count_missing("SOURCE", ["journal_2.xml", "journal_3.xml"]) == 2
+    assert not jv2backend.main.userCache.has_data("SOURCE", "orphan.xml")
+    assert not hashed
+
+    # Once this source's files are moved, lookups no longer check for them,
+    # and files for other sources are left in place
+    assert jv2backend.main.userCache.get_data("SOURCE", "journal_1.xml") == (b"{}", None)
+    assert not jv2backend.main.userCache._legacy_cache_file("SOURCE", "journal_1.xml").exists()
+    assert jv2backend.main.userCache._legacy_cache_file("OTHER", "journal_1.xml").exists()
+    hashed.clear()
+    assert jv2backend.main.userCache.count_missing("SOURCE", ["journal_1.xml", "journal_2.xml"]) == 1
+    assert not hashed
+
+
+def test_inactive_cache_holds_nothing(_cache, monkeypatch):
+    monkeypatch.setattr(jv2backend.main.userCache, "_CACHE_ACTIVATED", False)
+    jv2backend.main.userCache.put_data("SOURCE", "journal_1.xml", "{}")
+    assert not jv2backend.main.userCache.has_data("SOURCE", "journal_1.xml")
+    assert jv2backend.main.userCache.count_missing("SOURCE", ["journal_1.xml"]) == 1
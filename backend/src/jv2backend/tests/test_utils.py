@@ -1,6 +1,7 @@
 # SPDX-License-Identifier: GPL-3.0-or-later
 # Copyright (c) 2024 Team JournalViewer and contributors
 
+import numpy as np
 import jv2backend.utils
 
 
@@ -28,3 +29,11 @@ def test_url_join_handles_None_correctly():
     assert jv2backend.utils.url_join(None, A, C) == A + "/" + C
     assert jv2backend.utils.url_join(A, C, None) == A + "/" + C
     assert jv2backend.utils.url_join(A, None, None) == A
+
+
+def test_float64_array_round_trips_through_base64():
+    values = np.array([0.0, -1.5, 1e300, np.pi])
+    encoded = jv2backend.utils.encode_float64_array(values)
+
+    assert isinstance(encoded, str)
+    assert jv2backend.utils.decode_float64_array(encoded).tolist() == values.tolist()
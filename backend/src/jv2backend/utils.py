@@ -4,6 +4,8 @@
 from typing import Any, Sequence
 from functools import reduce
 from datetime import datetime
+import base64
+import numpy as np
 from flask import jsonify
 from flask.wrappers import Response as FlaskResponse
 
@@ -20,6 +22,23 @@ def json_response(result: Any) -> FlaskResponse:
         return jsonify(result)
 
 
+def encode_float64_array(values: Any) -> str:
+    """Encode the supplied values as a base64 string of contiguous
+    little-endian float64 values, for compact transfer of large arrays in
+    JSON responses
+
+    :param values: Array-like of numeric values
+    :return: The base64-encoded array
+    """
+    array = np.ascontiguousarray(values, dtype="<f8")
+    return base64.b64encode(array.tobytes()).decode("ascii")
+
+
+def decode_float64_array(text: str) -> np.ndarray:
+    """Decode an array encoded by encode_float64_array"""
+    return np.frombuffer(base64.b64decode(text), dtype="<f8")
+
+
 def _join_slash(a: str, b: str):
     """Join two strings together with a forward slash"""
     if a is None or len(a) == 0:
@@ -124,9 +124,9 @@ void Backend::getUncachedJournalCount(const JournalSource *source, const HttpReq
     postRequest(createRoute("journals/getUncachedJournalCount"), source->currentJournalObjectData(), handler);
 }
 
-// Search across all journals for matching runs
-void Backend::search(const JournalSource *source, const std::map<QString, QString> &searchTerms,
-                     const HttpRequestWorker::HttpRequestHandler &handler)
+// Start searching across all journals for matching runs in the background, optionally sorted by the specified field
+void Backend::startSearch(const JournalSource *source, const std::map<QString, QString> &searchTerms, const QString &sortBy,
+                          const HttpRequestWorker::HttpRequestHandler &handler)
 {
     auto data = source->sourceObjectData();
 
@@ -136,8 +136,31 @@ void Backend::search(const JournalSource *source, const std::map<QString, QStrin
         query[key] = value;
 
     data["valueMap"] = query;
+    if (!sortBy.isEmpty())
+        data["sortBy"] = sortBy;
 
-    postRequest(createRoute("journals/search"), data, handler);
+    postRequest(createRoute("journals/search/start"), data, handler);
+}
+
+// Get progress and a page of up to 'limit' matching runs of the specified background search, from the given index
+void Backend::getSearchUpdate(const JournalSource *source, int searchId, int first, int limit,
+                              const HttpRequestWorker::HttpRequestHandler &handler)
+{
+    auto data = source->sourceObjectData();
+    data["searchId"] = searchId;
+    data["first"] = first;
+    data["limit"] = limit;
+
+    postRequest(createRoute("journals/search/update"), data, handler);
+}
+
+// Stop the specified background search
+void Backend::stopSearch(const JournalSource *source, int searchId, const HttpRequestWorker::HttpRequestHandler &handler)
+{
+    auto data = source->sourceObjectData();
+    data["searchId"] = searchId;
+
+    postRequest(createRoute("journals/search/stop"), data, handler);
 }
 
 // Find journal containing specified run number
@@ -200,6 +223,48 @@ void Backend::getNexusLogValueData(const JournalSource *source, const std::vecto
     postRequest(createRoute("runData/nexus/getLogValueData"), data, handler);
 }
 
+// Get NeXuS log value data for several log values for specified run numbers, read together in one request
+void Backend::getNexusLogValueData(const JournalSource *source, const std::vector<int> &runNos, const QStringList &logValues,
+                                   const HttpRequestWorker::HttpRequestHandler &handler)
+{
+    auto data = source->sourceObjectData();
+
+    QJsonArray runNumbers;
+    for (auto i : runNos)
+        runNumbers.append(i);
+    data["runNumbers"] = runNumbers;
+    data["logValues"] = QJsonArray::fromStringList(logValues);
+
+    postRequest(createRoute("runData/nexus/getLogValueData"), data, handler);
+}
+
+// Get summary statistics of a NeXuS log value for specified run numbers
+void Backend::getNexusLogStatistics(const JournalSource *source, const std::vector<int> &runNos, const QString &logValue,
+                                    const HttpRequestWorker::HttpRequestHandler &handler)
+{
+    auto data = source->sourceObjectData();
+
+    QJsonArray runNumbers;
+    for (auto i : runNos)
+        runNumbers.append(i);
+    data["runNumbers"] = runNumbers;
+    data["logValue"] = logValue;
+
+    postRequest(createRoute("runData/nexus/getLogStatistics"), data, handler);
+}
+
+// Get NeXuS log value data recorded since the first samples already retrieved for the specified run number
+void Backend::getNexusLiveLogValueData(const JournalSource *source, int runNo, const QString &logValue, int first,
+                                       const HttpRequestWorker::HttpRequestHandler &handler)
+{
+    auto data = source->sourceObjectData();
+    data["runNumbers"] = QJsonArray({QJsonValue(runNo)});
+    data["logValue"] = logValue;
+    data["first"] = first;
+
+    postRequest(createRoute("runData/nexus/getLiveLogValueData"), data, handler);
+}
+
 // Get NeXuS spectrum count for specified run number
 void Backend::getNexusSpectrumCount(const JournalSource *source, const QString &spectrumType, int runNo,
                                     const HttpRequestWorker::HttpRequestHandler &handler)
@@ -211,13 +276,18 @@ void Backend::getNexusSpectrumCount(const JournalSource *source, const QString &
     postRequest(createRoute("runData/nexus/getSpectrumCount"), data, handler);
 }
 
-// Get NeXuS spectrum for specified run numbers
+// Get NeXuS spectrum for specified run numbers, with optional summation / rebinning options, along with the divisors
+// needed to normalise them
 void Backend::getNexusSpectrum(const JournalSource *source, const QString &spectrumType, int monitorId,
-                               const std::vector<int> &runNos, const HttpRequestWorker::HttpRequestHandler &handler)
+                               const std::vector<int> &runNos, const QJsonObject &options,
+                               const HttpRequestWorker::HttpRequestHandler &handler)
 {
     auto data = source->sourceObjectData();
+    for (auto it = options.begin(); it != options.end(); ++it)
+        data[it.key()] = it.value();
     data["spectrumId"] = monitorId;
     data["spectrumType"] = spectrumType;
+    data["divisors"] = true;
 
     QJsonArray runNumbers;
     for (auto i : runNos)
@@ -237,6 +307,45 @@ void Backend::getNexusDetectorAnalysis(const JournalSource *source, int runNo,
     postRequest(createRoute("runData/nexus/getDetectorAnalysis"), data, handler);
 }
 
+// Start determining detector health for all runs in the current journal of the specified source
+void Backend::startNexusDetectorHealth(const JournalSource *source, const HttpRequestWorker::HttpRequestHandler &handler)
+{
+    postRequest(createRoute("runData/nexus/startDetectorHealth"), source->currentJournalObjectData(), handler);
+}
+
+// Get detector health results for the current journal of the specified source, from the given index onwards
+void Backend::getNexusDetectorHealth(const JournalSource *source, int first,
+                                     const HttpRequestWorker::HttpRequestHandler &handler)
+{
+    auto data = source->currentJournalObjectData();
+    data["first"] = first;
+
+    postRequest(createRoute("runData/nexus/getDetectorHealth"), data, handler);
+}
+
+// Get NeXuS detector map layout for specified run number
+void Backend::getNexusDetectorMapInfo(const JournalSource *source, int runNo,
+                                      const HttpRequestWorker::HttpRequestHandler &handler)
+{
+    auto data = source->sourceObjectData();
+    data["runNumbers"] = QJsonArray({QJsonValue(runNo)});
+
+    postRequest(createRoute("runData/nexus/getDetectorMapInfo"), data, handler);
+}
+
+// Get NeXuS detector map tile for specified run number
+void Backend::getNexusDetectorMapTile(const JournalSource *source, int runNo, int level, int row, int column,
+                                      const HttpRequestWorker::HttpRequestHandler &handler)
+{
+    auto data = source->sourceObjectData();
+    data["runNumbers"] = QJsonArray({QJsonValue(runNo)});
+    data["level"] = level;
+    data["row"] = row;
+    data["column"] = column;
+
+    postRequest(createRoute("runData/nexus/getDetectorMapTile"), data, handler);
+}
+
 /*
  * Generation Endpoints
  */
@@ -7,6 +7,7 @@
 #include <QNetworkAccessManager>
 #include <QProcess>
 #include <QString>
+#include <QStringList>
 
 // Forward-declarations
 class JournalSource;
@@ -72,9 +73,14 @@ class Backend : public QObject
     void getJournalUpdates(const JournalSource *source, const HttpRequestWorker::HttpRequestHandler &handler = {});
     // Get number of uncached journals for specified source
     void getUncachedJournalCount(const JournalSource *source, const HttpRequestWorker::HttpRequestHandler &handler = {});
-    // Search across all journals for matching runs
-    void search(const JournalSource *source, const std::map<QString, QString> &searchTerms,
-                const HttpRequestWorker::HttpRequestHandler &handler = {});
+    // Start searching across all journals for matching runs in the background, optionally sorted by the specified field
+    void startSearch(const JournalSource *source, const std::map<QString, QString> &searchTerms, const QString &sortBy,
+                     const HttpRequestWorker::HttpRequestHandler &handler = {});
+    // Get progress and a page of up to 'limit' matching runs of the specified background search, from the given index
+    void getSearchUpdate(const JournalSource *source, int searchId, int first, int limit,
+                         const HttpRequestWorker::HttpRequestHandler &handler = {});
+    // Stop the specified background search
+    void stopSearch(const JournalSource *source, int searchId, const HttpRequestWorker::HttpRequestHandler &handler = {});
     // Find journal containing specified run number
     void findJournal(const JournalSource *source, int runNo, const HttpRequestWorker::HttpRequestHandler &handler = {});
     // Get all journals for source in background
@@ -94,15 +100,37 @@ class Backend : public QObject
     // Get NeXuS log value data for specified run files
     void getNexusLogValueData(const JournalSource *source, const std::vector<int> &runNos, const QString &logValue,
                               const HttpRequestWorker::HttpRequestHandler &handler = {});
+    // Get NeXuS log value data for several log values for specified run numbers, read together in one request
+    void getNexusLogValueData(const JournalSource *source, const std::vector<int> &runNos, const QStringList &logValues,
+                              const HttpRequestWorker::HttpRequestHandler &handler = {});
+    // Get summary statistics of a NeXuS log value for specified run numbers
+    void getNexusLogStatistics(const JournalSource *source, const std::vector<int> &runNos, const QString &logValue,
+                               const HttpRequestWorker::HttpRequestHandler &handler = {});
+    // Get NeXuS log value data recorded since the first samples already retrieved for the specified run number
+    void getNexusLiveLogValueData(const JournalSource *source, int runNo, const QString &logValue, int first,
+                                  const HttpRequestWorker::HttpRequestHandler &handler = {});
     // Get NeXuS spectrum count for specified run number
     void getNexusSpectrumCount(const JournalSource *source, const QString &spectrumType, int runNo,
                                const HttpRequestWorker::HttpRequestHandler &handler = {});
-    // Get NeXuS spectrum for specified run numbers
+    // Get NeXuS spectrum for specified run numbers, with optional summation / rebinning options, along with the divisors
+    // needed to normalise them
     void getNexusSpectrum(const JournalSource *source, const QString &spectrumType, int monitorId,
-                          const std::vector<int> &runNos, const HttpRequestWorker::HttpRequestHandler &handler = {});
+                          const std::vector<int> &runNos, const QJsonObject &options = {},
+                          const HttpRequestWorker::HttpRequestHandler &handler = {});
     // Get NeXuS detector spectra analysis for specified run number
     void getNexusDetectorAnalysis(const JournalSource *source, int runNo,
                                   const HttpRequestWorker::HttpRequestHandler &handler = {});
+    // Start determining detector health for all runs in the current journal of the specified source
+    void startNexusDetectorHealth(const JournalSource *source, const HttpRequestWorker::HttpRequestHandler &handler = {});
+    // Get detector health results for the current journal of the specified source, from the given index onwards
+    void getNexusDetectorHealth(const JournalSource *source, int first,
+                                const HttpRequestWorker::HttpRequestHandler &handler = {});
+    // Get NeXuS detector map layout for specified run number
+    void getNexusDetectorMapInfo(const JournalSource *source, int runNo,
+                                 const HttpRequestWorker::HttpRequestHandler &handler = {});
+    // Get NeXuS detector map tile for specified run number
+    void getNexusDetectorMapTile(const JournalSource *source, int runNo, int level, int row, int column,
+                                 const HttpRequestWorker::HttpRequestHandler &handler = {});
 
     /*
      * Generation Endpoints
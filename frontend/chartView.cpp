@@ -3,23 +3,36 @@
 
 #include "chartView.h"
 #include "httpRequestWorker.h"
+#include "seriesData.h"
 #include <QApplication>
 #include <QBrush>
+#include <QCategoryAxis>
 #include <QDateTime>
 #include <QDateTimeAxis>
 #include <QFont>
 #include <QGraphicsSimpleTextItem>
 #include <QLineSeries>
 #include <QMessageBox>
+#include <QScreen>
 #include <QValueAxis>
+#include <QXYSeries>
 #include <QtGui/QMouseEvent>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+// Distance in pixels within which a data point is considered to be hovered
+constexpr auto HoverRadius = 8.0;
+} // namespace
 
 ChartView::ChartView(QChart *chart, QWidget *parent) : QChartView(chart, parent)
 {
     setRubberBand(QChartView::HorizontalRubberBand);
     setDragMode(QGraphicsView::NoDrag);
     this->setMouseTracking(true);
-    hovered_ = "";
+    this->setUpHover();
     this->setGraphics(chart);
 }
 
@@ -28,7 +41,7 @@ ChartView::ChartView(QWidget *parent) : QChartView(parent)
     setRubberBand(QChartView::HorizontalRubberBand);
     setDragMode(QGraphicsView::NoDrag);
     this->setMouseTracking(true);
-    hovered_ = "";
+    this->setUpHover();
 }
 
 void ChartView::setGraphics(QChart *chart)
@@ -57,68 +70,66 @@ void ChartView::addSeries(HttpRequestWorker *worker)
     QString msg;
     if (worker->errorType() == QNetworkReply::NoError)
     {
-        // For each Run
-        auto array = worker->jsonResponse().array();
-        array.removeFirst();
-        foreach (const auto &runFields, array)
-        {
-            auto runFieldsArray = runFields.toArray();
-            auto startTime = QDateTime::fromString(runFieldsArray.first()[0].toString(), "yyyy-MM-dd'T'HH:mm:ss");
-            auto endTime = QDateTime::fromString(runFieldsArray.first()[1].toString(), "yyyy-MM-dd'T'HH:mm:ss");
-            runFieldsArray.removeFirst();
+        // String-valued logs are plotted as indices into the categories of the chart's vertical axis, extended by any
+        // new categories in this data
+        const auto logValueData = worker->jsonResponse().object()["data"].toObject();
+        auto *categoryAxis = qobject_cast<QCategoryAxis *>(chart()->axes(Qt::Vertical)[0]);
+        auto categories = categoryAxis ? categoryAxis->categoriesLabels() : QStringList();
+        for (const auto &category : RunLogSeriesData::categories(logValueData))
+            if (!categories.contains(category))
+                categories.append(category);
 
-            // For each field
-            foreach (const auto &fieldData, runFieldsArray)
+        // Convert the run data into series data on a worker thread, then add the series once complete
+        buildSeriesData(
+            this, [logValueData, categories]() { return RunLogSeriesData::fromLogValueData(logValueData, categories); },
+            [this, categories](std::vector<RunLogSeriesData> runSeries)
             {
-                auto fieldDataArray = fieldData.toArray();
-                auto *series = new QLineSeries();
-                auto endTime = QDateTime::fromString(runFieldsArray.first()[1].toString(), "yyyy-MM-dd'T'HH:mm:ss");
-
-                connect(series, &QLineSeries::hovered,
-                        [=](const QPointF point, bool hovered) { this->setHovered(point, hovered, series->name()); });
-
-                // Set dateSeries ID
-                QString name = fieldDataArray.first()[0].toString();
-                QString field = fieldDataArray.first()[1].toString().section(':', -1);
-                series->setName(name);
-                fieldDataArray.removeFirst();
-
-                foreach (const auto &dataPair, fieldDataArray)
-                {
-                    auto dataPairArray = dataPair.toArray();
-                    if (chart()->axes(Qt::Horizontal)[0]->type() == QAbstractAxis::AxisTypeValue)
-                        series->append(dataPairArray[0].toDouble(), dataPairArray[1].toDouble());
-                    else // if date time axis
-                        series->append(startTime.addSecs(dataPairArray[0].toDouble()).toMSecsSinceEpoch(),
-                                       dataPairArray[1].toDouble());
-
-                    auto *axis = qobject_cast<QValueAxis *>(chart()->axes(Qt::Vertical)[0]);
-                    if (dataPairArray[1].toDouble() < axis->min())
-                        axis->setMin(dataPairArray[1].toDouble());
-                    if (dataPairArray[1].toDouble() > axis->max())
-                        axis->setMax(dataPairArray[1].toDouble());
-                }
-                if (chart()->axes(Qt::Horizontal)[0]->type() == QAbstractAxis::AxisTypeValue)
+                auto dateTimeAxis = chart()->axes(Qt::Horizontal)[0]->type() != QAbstractAxis::AxisTypeValue;
+                auto *yAxis = qobject_cast<QValueAxis *>(chart()->axes(Qt::Vertical)[0]);
+                if (auto *categoryAxis = qobject_cast<QCategoryAxis *>(chart()->axes(Qt::Vertical)[0]))
                 {
-                    auto *axis = qobject_cast<QValueAxis *>(chart()->axes(Qt::Horizontal)[0]);
-                    if (series->at(0).x() < axis->min())
-                        axis->setMin(series->at(0).x());
-                    if (series->at(series->count() - 1).x() > axis->max())
-                        axis->setMax(series->at(series->count() - 1).x());
+                    for (auto n = categoryAxis->count(); n < categories.count(); ++n)
+                        categoryAxis->append(categories[n], n);
+                    categoryAxis->setRange(0, categories.count() - 1);
                 }
-                else
+
+                for (const auto &run : runSeries)
                 {
-                    auto *axis = qobject_cast<QDateTimeAxis *>(chart()->axes(Qt::Horizontal)[0]);
-                    if (startTime.addSecs(startTime.secsTo(QDateTime::fromMSecsSinceEpoch(series->at(0).x()))) < axis->min())
-                        axis->setMin(startTime.addSecs(startTime.secsTo(QDateTime::fromMSecsSinceEpoch(series->at(0).x()))));
-                    if (endTime > axis->max())
-                        axis->setMax(endTime);
+                    const auto &data = dateTimeAxis ? run.absolute : run.relative;
+                    const auto &bounds = data.bounds();
+                    if (!bounds.valid)
+                        continue;
+
+                    auto *series = new QLineSeries();
+                    data.applyTo(series);
+
+                    // Update axis limits from the precalculated bounds
+                    if (bounds.yMin < yAxis->min())
+                        yAxis->setMin(bounds.yMin);
+                    if (bounds.yMax > yAxis->max())
+                        yAxis->setMax(bounds.yMax);
+                    if (dateTimeAxis)
+                    {
+                        auto *axis = qobject_cast<QDateTimeAxis *>(chart()->axes(Qt::Horizontal)[0]);
+                        if (QDateTime::fromMSecsSinceEpoch(bounds.xMin) < axis->min())
+                            axis->setMin(QDateTime::fromMSecsSinceEpoch(bounds.xMin));
+                        if (run.endTime > axis->max())
+                            axis->setMax(run.endTime);
+                    }
+                    else
+                    {
+                        auto *axis = qobject_cast<QValueAxis *>(chart()->axes(Qt::Horizontal)[0]);
+                        if (bounds.xMin < axis->min())
+                            axis->setMin(bounds.xMin);
+                        if (bounds.xMax > axis->max())
+                            axis->setMax(bounds.xMax);
+                    }
+
+                    chart()->addSeries(series);
+                    series->attachAxis(chart()->axes(Qt::Horizontal)[0]);
+                    series->attachAxis(chart()->axes(Qt::Vertical)[0]);
                 }
-                chart()->addSeries(series);
-                series->attachAxis(chart()->axes(Qt::Horizontal)[0]);
-                series->attachAxis(chart()->axes(Qt::Vertical)[0]);
-            }
-        }
+            });
     }
     else
     {
@@ -128,6 +139,36 @@ void ChartView::addSeries(HttpRequestWorker *worker)
     }
 }
 
+// Append points to the series, extending its axes to encompass them
+void ChartView::appendPoints(QXYSeries *series, const QList<QPointF> &points)
+{
+    if (points.isEmpty())
+        return;
+
+    series->append(points);
+
+    const auto bounds = SeriesData(series->name(), points).bounds();
+    for (auto *axis : series->attachedAxes())
+    {
+        auto horizontal = axis->orientation() == Qt::Horizontal;
+        auto min = horizontal ? bounds.xMin : bounds.yMin, max = horizontal ? bounds.xMax : bounds.yMax;
+        if (auto *valueAxis = qobject_cast<QValueAxis *>(axis))
+        {
+            if (min < valueAxis->min())
+                valueAxis->setMin(min);
+            if (max > valueAxis->max())
+                valueAxis->setMax(max);
+        }
+        else if (auto *dateTimeAxis = qobject_cast<QDateTimeAxis *>(axis))
+        {
+            if (QDateTime::fromMSecsSinceEpoch(min) < dateTimeAxis->min())
+                dateTimeAxis->setMin(QDateTime::fromMSecsSinceEpoch(min));
+            if (QDateTime::fromMSecsSinceEpoch(max) > dateTimeAxis->max())
+                dateTimeAxis->setMax(QDateTime::fromMSecsSinceEpoch(max));
+        }
+    }
+}
+
 void ChartView::keyPressEvent(QKeyEvent *event)
 {
     {
@@ -212,8 +253,111 @@ void ChartView::mouseReleaseEvent(QMouseEvent *event)
     QChartView::mouseReleaseEvent(event);
 }
 
-// Set value for hover behaviour
-void ChartView::setHovered(const QPointF point, bool hovered, QString title) { hovered_ = hovered ? title : ""; }
+/*
+ * Hover
+ */
+
+// Set up hover handling
+void ChartView::setUpHover()
+{
+    hoverTimer_.setSingleShot(true);
+    connect(&hoverTimer_, &QTimer::timeout, this, &ChartView::updateHover);
+}
+
+// Return the hover index for the series, creating it if necessary
+const ChartView::HoverIndex &ChartView::hoverIndex(QXYSeries *series)
+{
+    auto it = hoverIndices_.find(series);
+    if (it != hoverIndices_.end())
+        return it.value();
+
+    // Points are usually already in x order, so only sort when we have to
+    HoverIndex index;
+    const auto points = series->points();
+    std::vector<qsizetype> order(points.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (!std::is_sorted(points.begin(), points.end(), [](const auto &a, const auto &b) { return a.x() < b.x(); }))
+        std::stable_sort(order.begin(), order.end(), [&points](auto a, auto b) { return points[a].x() < points[b].x(); });
+    index.x.reserve(points.size());
+    index.y.reserve(points.size());
+    for (auto n : order)
+    {
+        index.x.push_back(points[n].x());
+        index.y.push_back(points[n].y());
+    }
+
+    // Discard the index whenever the series data changes, leaving any other connections to the series alone
+    auto invalidate = [this, series]()
+    {
+        auto it = hoverIndices_.find(series);
+        if (it == hoverIndices_.end())
+            return;
+        for (const auto &connection : it.value().connections)
+            disconnect(connection);
+        hoverIndices_.erase(it);
+    };
+    index.connections = {connect(series, &QXYSeries::pointsReplaced, this, invalidate),
+                         connect(series, &QXYSeries::pointReplaced, this, invalidate),
+                         connect(series, &QXYSeries::pointAdded, this, invalidate),
+                         connect(series, &QXYSeries::pointRemoved, this, invalidate),
+                         connect(series, &QXYSeries::pointsRemoved, this, invalidate),
+                         connect(series, &QObject::destroyed, this, invalidate)};
+
+    return hoverIndices_.insert(series, std::move(index)).value();
+}
+
+// Find the data point nearest the last cursor position and report it
+void ChartView::updateHover()
+{
+    QXYSeries *nearestSeries = nullptr;
+    QPointF nearestPoint;
+    auto nearestDistanceSq = HoverRadius * HoverRadius;
+
+    for (auto *abstractSeries : chart()->series())
+    {
+        auto *series = qobject_cast<QXYSeries *>(abstractSeries);
+        if (!series || !series->isVisible())
+            continue;
+
+        const auto &index = hoverIndex(series);
+        if (index.x.empty())
+            continue;
+
+        // Axes are linear, so convert between values and pixels with a fixed scale
+        const auto cursor = chart()->mapToValue(hoverPos_, series);
+        const auto offset = chart()->mapToValue(hoverPos_ + QPointF(HoverRadius, HoverRadius), series) - cursor;
+        if (offset.x() == 0.0 || offset.y() == 0.0)
+            continue;
+        const auto xScale = HoverRadius / offset.x(), yScale = HoverRadius / offset.y();
+
+        // Only consider points whose x lies within the hover radius of the cursor
+        const auto xRange = std::abs(offset.x());
+        auto first = std::lower_bound(index.x.begin(), index.x.end(), cursor.x() - xRange) - index.x.begin();
+        auto last = std::upper_bound(index.x.begin() + first, index.x.end(), cursor.x() + xRange) - index.x.begin();
+        for (auto n = first; n < last; ++n)
+        {
+            const auto dx = (index.x[n] - cursor.x()) * xScale, dy = (index.y[n] - cursor.y()) * yScale;
+            const auto distanceSq = dx * dx + dy * dy;
+            if (distanceSq < nearestDistanceSq)
+            {
+                nearestDistanceSq = distanceSq;
+                nearestSeries = series;
+                nearestPoint = {index.x[n], index.y[n]};
+            }
+        }
+    }
+
+    if (nearestSeries)
+    {
+        hovering_ = true;
+        emit showCoordinates(nearestPoint.x(), nearestPoint.y(), nearestSeries->name());
+    }
+    else if (hovering_)
+    {
+        hovering_ = false;
+        emit clearCoordinates();
+    }
+}
 
 void ChartView::mouseMoveEvent(QMouseEvent *event)
 {
@@ -308,12 +452,24 @@ void ChartView::mouseMoveEvent(QMouseEvent *event)
     }
     else
     {
-        if (!hovered_.isEmpty())
-            emit showCoordinates(chart()->mapToValue(event->pos()).x(), chart()->mapToValue(event->pos()).y(), hovered_);
-        else
-            emit clearCoordinates();
+        // Defer the nearest point search until the next display refresh, coalescing intermediate moves
+        hoverPos_ = event->pos();
+        if (!hoverTimer_.isActive())
+            hoverTimer_.start(std::max(1, qRound(1000.0 / screen()->refreshRate())));
     }
     event->accept();
 
     QChartView::mouseMoveEvent(event);
 }
+
+void ChartView::leaveEvent(QEvent *event)
+{
+    hoverTimer_.stop();
+    if (hovering_)
+    {
+        hovering_ = false;
+        emit clearCoordinates();
+    }
+
+    QChartView::leaveEvent(event);
+}
@@ -4,8 +4,14 @@
 #pragma once
 
 #include "httpRequestWorker.h"
+#include <QHash>
+#include <QTimer>
 #include <QtCharts/QChartView>
 #include <QtWidgets/QRubberBand>
+#include <vector>
+
+// Forward Declarations
+class QXYSeries;
 
 class ChartView : public QChartView
 {
@@ -17,9 +23,12 @@ class ChartView : public QChartView
     void assignChart(QChart *chart);
 
     public slots:
-    void setHovered(const QPointF point, bool hovered, QString title);
     void addSeries(HttpRequestWorker *worker);
 
+    public:
+    // Append points to the series, extending its axes to encompass them
+    void appendPoints(QXYSeries *series, const QList<QPointF> &points);
+
     signals:
     void showCoordinates(qreal x, qreal y, QString title);
     void clearCoordinates();
@@ -31,15 +40,37 @@ class ChartView : public QChartView
     void mousePressEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
+    void leaveEvent(QEvent *event) override;
 
     private slots:
     void setGraphics(QChart *chart);
+    // Find the data point nearest the last cursor position and report it
+    void updateHover();
 
     private:
     QPointF lastMousePos_;
-    QString hovered_;
+    // Point data for a series sorted by x, used to find the points near the cursor
+    struct HoverIndex
+    {
+        std::vector<double> x, y;
+        // Connections discarding the index when the series changes
+        std::vector<QMetaObject::Connection> connections;
+    };
+    QHash<QXYSeries *, HoverIndex> hoverIndices_;
+    // Timer limiting hover updates to the display refresh rate
+    QTimer hoverTimer_;
+    // Cursor position for the next hover update
+    QPointF hoverPos_;
+    // Whether a point is currently being reported
+    bool hovering_{false};
     QGraphicsSimpleTextItem *coordLabelX_;
     QGraphicsSimpleTextItem *coordLabelY_;
     QGraphicsSimpleTextItem *coordStartLabelX_;
     QGraphicsSimpleTextItem *coordStartLabelY_;
+
+    private:
+    // Set up hover handling
+    void setUpHover();
+    // Return the hover index for the series, creating it if necessary
+    const HoverIndex &hoverIndex(QXYSeries *series);
 };
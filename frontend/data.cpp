@@ -2,12 +2,16 @@
 // Copyright (c) 2024 Team JournalViewer and contributors
 
 #include "mainWindow.h"
+#include <QDebug>
 #include <QInputDialog>
 #include <QJsonArray>
 #include <QMessageBox>
 #include <QNetworkReply>
+#include <QSet>
 #include <QSettings>
+#include <QTimer>
 #include <QWidgetAction>
+#include <algorithm>
 
 /*
  * Private Functions
@@ -123,6 +127,202 @@ void MainWindow::highlightRunNumber(int runNumber)
     statusBar()->showMessage("Jumped to run " + QString::number(runNumber) + " in " + currentJournal().name(), 5000);
 }
 
+// Start determining detector health for the current journal, if it is being shown
+void MainWindow::startDetectorHealth()
+{
+    ++detectorHealthScan_;
+    if (!ui_.actionShowDetectorHealth->isChecked() || !currentJournalSource_)
+        return;
+
+    auto scan = detectorHealthScan_;
+    backend_.startNexusDetectorHealth(currentJournalSource(),
+                                      [=](HttpRequestWorker *worker) { handleDetectorHealth(worker, scan); });
+}
+
+// Handle detector health results, polling for more until the scan is complete
+void MainWindow::handleDetectorHealth(HttpRequestWorker *worker, int scan)
+{
+    // Ignore results from scans we have since abandoned
+    if (scan != detectorHealthScan_)
+        return;
+
+    // Check network reply
+    if (handleRequestError(worker, "determining detector health") != NoError)
+        return;
+    if (worker->response().startsWith("\"NOT_RUNNING"))
+        return;
+
+    const auto update = worker->jsonResponse().object();
+    const auto results = update["results"].toArray();
+
+    // Format values for display, leaving runs which could not be analysed blank
+    QJsonArray values;
+    for (const auto &item : results)
+    {
+        auto result = item.toObject();
+        QJsonObject value;
+        value["run_number"] = QString::number(result["runNumber"].toInt());
+        if (result.contains("error"))
+            qDebug() << "Couldn't determine detector health for run" << result["runNumber"].toInt() << ":"
+                     << result["error"].toString();
+        else
+        {
+            value["nonZeroSpectra"] =
+                QString("%1/%2").arg(result["nonZeroSpectra"].toInt()).arg(result["spectra"].toInt());
+            value["totalCounts"] = QString::number(result["totalCounts"].toInteger());
+            if (result["countsPerMicroAmpHour"].isDouble())
+                value["countsPerMicroAmpHour"] = QString::number(result["countsPerMicroAmpHour"].toDouble(), 'f', 1);
+        }
+        values.append(value);
+    }
+    runDataModel_.setLazyValues(values);
+
+    auto nReceived = update["first"].toInt() + results.count();
+    if (update["complete"].toBool())
+    {
+        statusBar()->showMessage(QString("Detector health determined for %1 runs.").arg(nReceived), 3000);
+        return;
+    }
+    statusBar()->showMessage(
+        QString("Determining detector health (%1 of %2 runs)...").arg(nReceived).arg(update["numRuns"].toInt()));
+
+    // Ask for the next results after a short wait
+    QTimer::singleShot(1000, this,
+                       [=]()
+                       {
+                           if (scan != detectorHealthScan_)
+                               return;
+                           backend_.getNexusDetectorHealth(currentJournalSource(), nReceived,
+                                                           [=](HttpRequestWorker *worker)
+                                                           { handleDetectorHealth(worker, scan); });
+                       });
+}
+
+// Set the additional columns shown for the run data
+void MainWindow::updateLazyColumns()
+{
+    Instrument::RunDataColumns columns;
+    if (ui_.actionShowDetectorHealth->isChecked())
+        columns.insert(columns.end(), {{"Non-Zero Spectra", "nonZeroSpectra"},
+                                       {"Total Counts", "totalCounts"},
+                                       {"Counts/µAh", "countsPerMicroAmpHour"}});
+
+    // Statistics are keyed by log path so that values for previously-chosen logs are never shown against another
+    if (!logStatisticsPath_.isEmpty())
+    {
+        auto logName = logStatisticsPath_.section('/', -1);
+        for (const auto &statistic : QStringList{"mean", "min", "max", "last"})
+            columns.emplace_back(QString("%1 (%2)").arg(logName, statistic),
+                                 QString("%1:%2").arg(logStatisticsPath_, statistic));
+    }
+
+    runDataModel_.setLazyColumns(columns);
+}
+
+// Start retrieving statistics of the chosen SE log for all runs in the current journal, if they are being shown
+void MainWindow::startLogStatistics()
+{
+    ++logStatisticsRequest_;
+    logStatisticsRequestActive_ = false;
+    pendingLogStatisticsRuns_.clear();
+    if (logStatisticsPath_.isEmpty() || !currentJournalSource_)
+        return;
+
+    // Grouped rows don't correspond to individual runs, so are left blank
+    for (auto row = 0; row < runDataModel_.rowCount(); ++row)
+    {
+        bool valid;
+        auto runNumber = runDataModel_.getData("run_number", row).toInt(&valid);
+        if (valid)
+            pendingLogStatisticsRuns_.append(runNumber);
+    }
+
+    prioritiseVisibleLogStatistics();
+    requestLogStatistics();
+}
+
+// Move pending log statistics requests for the visible rows to the front of the queue
+void MainWindow::prioritiseVisibleLogStatistics()
+{
+    if (pendingLogStatisticsRuns_.isEmpty())
+        return;
+
+    auto *table = ui_.RunDataTable;
+    auto first = table->rowAt(0);
+    if (first == -1)
+        return;
+    auto last = table->rowAt(table->viewport()->height() - 1);
+    if (last == -1)
+        last = runDataFilterProxy_.rowCount() - 1;
+
+    QSet<int> visibleRuns;
+    for (auto row = first; row <= last; ++row)
+        visibleRuns.insert(
+            runDataModel_.getData("run_number", runDataFilterProxy_.mapToSource(runDataFilterProxy_.index(row, 0))).toInt());
+
+    std::stable_partition(pendingLogStatisticsRuns_.begin(), pendingLogStatisticsRuns_.end(),
+                          [&visibleRuns](int runNumber) { return visibleRuns.contains(runNumber); });
+}
+
+// Request log statistics for the next block of pending runs
+void MainWindow::requestLogStatistics()
+{
+    // Runs are requested in small blocks so that those scrolled into view are not kept waiting for long
+    constexpr auto BlockSize = 50;
+
+    if (logStatisticsRequestActive_ || pendingLogStatisticsRuns_.isEmpty())
+        return;
+
+    auto nRuns = std::min(BlockSize, static_cast<int>(pendingLogStatisticsRuns_.size()));
+    std::vector<int> runNumbers(pendingLogStatisticsRuns_.begin(), pendingLogStatisticsRuns_.begin() + nRuns);
+    pendingLogStatisticsRuns_.remove(0, nRuns);
+
+    logStatisticsRequestActive_ = true;
+    auto request = logStatisticsRequest_;
+    backend_.getNexusLogStatistics(currentJournalSource(), runNumbers, logStatisticsPath_,
+                                   [=](HttpRequestWorker *worker) { handleLogStatistics(worker, request); });
+}
+
+// Handle log statistics for a block of runs, then request the next
+void MainWindow::handleLogStatistics(HttpRequestWorker *worker, int request)
+{
+    // Ignore results from requests we have since abandoned
+    if (request != logStatisticsRequest_)
+        return;
+    logStatisticsRequestActive_ = false;
+
+    // Check network reply
+    if (handleRequestError(worker, "retrieving log statistics") != NoError)
+        return;
+
+    // Runs without the log are simply left blank
+    const auto response = worker->jsonResponse().object();
+    const auto errors = response["errors"].toObject();
+    for (auto it = errors.constBegin(); it != errors.constEnd(); ++it)
+        qDebug() << "Couldn't determine log statistics for run" << it.key() << ":" << it.value().toString();
+
+    QJsonArray values;
+    for (const auto &item : response["results"].toArray())
+    {
+        auto result = item.toObject();
+        QJsonObject value;
+        value["run_number"] = QString::number(result["runNumber"].toInt());
+        for (const auto &statistic : QStringList{"mean", "min", "max", "last"})
+            value[QString("%1:%2").arg(logStatisticsPath_, statistic)] = result[statistic];
+        values.append(value);
+    }
+    runDataModel_.setLazyValues(values);
+
+    if (pendingLogStatisticsRuns_.isEmpty())
+        statusBar()->showMessage(QString("Retrieved %1 statistics.").arg(logStatisticsPath_.section('/', -1)), 3000);
+    else
+        statusBar()->showMessage(QString("Retrieving %1 statistics (%2 runs remaining)...")
+                                     .arg(logStatisticsPath_.section('/', -1))
+                                     .arg(pendingLogStatisticsRuns_.size()));
+
+    requestLogStatistics();
+}
+
 /*
  * UI
  */
@@ -147,6 +347,14 @@ void MainWindow::on_actionRefreshJournal_triggered()
     }
 }
 
+// Show or hide detector health columns
+void MainWindow::on_actionShowDetectorHealth_toggled(bool checked)
+{
+    updateLazyColumns();
+
+    startDetectorHealth();
+}
+
 // Jump to run number
 void MainWindow::on_actionJumpTo_triggered()
 {
@@ -174,11 +382,16 @@ void MainWindow::runDataContextMenuRequested(QPoint pos)
 
     // SE log plotting options
     auto *plotSELog = contextMenu.addAction("Plot SE log values...");
+    auto *showLogStatistics = contextMenu.addAction("Show SE log statistics...");
+    QAction *hideLogStatistics = nullptr;
+    if (!logStatisticsPath_.isEmpty())
+        hideLogStatistics = contextMenu.addAction("Hide SE log statistics");
     contextMenu.addSeparator();
 
     // Spectrum plotting
     auto *plotDetector = contextMenu.addAction("Plot detector...");
     auto *plotMonitor = contextMenu.addAction("Plot monitor...");
+    auto *showDetectorMap = contextMenu.addAction("Show detector map");
 
     auto *selectedAction = contextMenu.exec(ui_.RunDataTable->mapToGlobal(pos));
 
@@ -203,6 +416,17 @@ void MainWindow::runDataContextMenuRequested(QPoint pos)
         backend_.getNexusFields(currentJournalSource(), selectedRunNumbers(),
                                 [=](HttpRequestWorker *worker) { handlePlotSELogValue(worker); });
     }
+    else if (selectedAction == showLogStatistics)
+    {
+        backend_.getNexusFields(currentJournalSource(), selectedRunNumbers(),
+                                [=](HttpRequestWorker *worker) { handleChooseLogStatistics(worker); });
+    }
+    else if (selectedAction && selectedAction == hideLogStatistics)
+    {
+        logStatisticsPath_.clear();
+        updateLazyColumns();
+        startLogStatistics();
+    }
     else if (selectedAction == plotDetector)
     {
         backend_.getNexusSpectrumCount(currentJournalSource(), "detector", selectedRunNumbers().front(),
@@ -213,4 +437,10 @@ void MainWindow::runDataContextMenuRequested(QPoint pos)
         backend_.getNexusSpectrumCount(currentJournalSource(), "monitor", selectedRunNumbers().front(),
                                        [=](HttpRequestWorker *worker) { plotMonSpectra(worker); });
     }
+    else if (selectedAction == showDetectorMap)
+    {
+        auto runNo = selectedRunNumbers().front();
+        backend_.getNexusDetectorMapInfo(currentJournalSource(), runNo,
+                                         [=](HttpRequestWorker *worker) { handleCreateDetectorMap(worker, runNo); });
+    }
 }
@@ -0,0 +1,316 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (c) 2024 Team JournalViewer and contributors
+
+#include "detectorMapView.h"
+#include "seriesData.h"
+#include <QJsonArray>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPointer>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+// Colour map running from dark blue (no counts) to yellow (maximum counts)
+const std::array<QRgb, 256> &colourMap()
+{
+    static const auto map = []()
+    {
+        const std::array<QColor, 5> stops = {QColor(68, 1, 84), QColor(59, 82, 139), QColor(33, 145, 140),
+                                             QColor(94, 201, 98), QColor(253, 231, 37)};
+        std::array<QRgb, 256> colours;
+        for (auto n = 0; n < 256; ++n)
+        {
+            auto t = n / 255.0 * (stops.size() - 1);
+            auto i = std::min(static_cast<int>(t), static_cast<int>(stops.size()) - 2);
+            auto f = t - i;
+            colours[n] = qRgb(stops[i].red() + f * (stops[i + 1].red() - stops[i].red()),
+                              stops[i].green() + f * (stops[i + 1].green() - stops[i].green()),
+                              stops[i].blue() + f * (stops[i + 1].blue() - stops[i].blue()));
+        }
+        return colours;
+    }();
+    return map;
+}
+} // namespace
+
+DetectorMapView::DetectorMapView(const QJsonObject &info, TileRequester tileRequester, QWidget *parent)
+    : QWidget(parent), tileRequester_(std::move(tileRequester))
+{
+    nSpectra_ = info["spectra"].toInt();
+    nBins_ = info["bins"].toInt();
+    tileSize_ = info["tileSize"].toInt(256);
+    nLevels_ = info["levels"].toInt(1);
+    maxCount_ = info["maxCount"].toDouble();
+    for (const auto &tof : info["timeOfFlight"].toArray())
+        timeOfFlight_.push_back(tof.toDouble());
+
+    view_ = QRectF(0, 0, nBins_, nSpectra_);
+
+    setMouseTracking(true);
+    setMinimumSize(256, 256);
+}
+
+/*
+ * Tiles
+ */
+
+// Return key for the specified tile
+quint64 DetectorMapView::tileKey(int level, int row, int column)
+{
+    return (quint64(level) << 48) | (quint64(row) << 24) | quint64(column);
+}
+
+// Convert a tile response into binned values and an image
+DetectorMapView::Tile DetectorMapView::createTile(const QJsonObject &tileData, double maxCount)
+{
+    Tile tile;
+    const auto shape = tileData["shape"].toArray();
+    tile.rows = shape[0].toInt();
+    tile.columns = shape[1].toInt();
+    tile.image = QImage(tile.columns, tile.rows, QImage::Format_RGB32);
+
+    // Values are already the mean per bin over each block
+    const auto values = decodeFloat64Array(tileData["data"]);
+    if (values.size() != static_cast<size_t>(tile.rows) * tile.columns)
+        return {};
+    tile.values.assign(values.begin(), values.end());
+
+    const auto logMax = std::log1p(maxCount);
+    const auto &colours = colourMap();
+    for (auto row = 0; row < tile.rows; ++row)
+    {
+        const auto *value = tile.values.data() + row * tile.columns;
+        auto *line = reinterpret_cast<QRgb *>(tile.image.scanLine(row));
+        for (auto column = 0; column < tile.columns; ++column)
+        {
+            auto index = logMax > 0.0 ? static_cast<int>(255 * std::log1p(value[column]) / logMax) : 0;
+            line[column] = colours[std::clamp(index, 0, 255)];
+        }
+    }
+
+    return tile;
+}
+
+// Return the pyramid level appropriate to the current view
+int DetectorMapView::currentLevel() const
+{
+    if (width() == 0 || height() == 0)
+        return nLevels_ - 1;
+
+    // Choose the level whose bins are closest to, but not larger than, a single pixel
+    auto binsPerPixel = std::max(view_.width() / width(), view_.height() / height());
+    auto level = binsPerPixel > 1.0 ? static_cast<int>(std::floor(std::log2(binsPerPixel))) : 0;
+    return std::clamp(level, 0, nLevels_ - 1);
+}
+
+// Return the range of tiles at the specified level which intersect the view
+QRect DetectorMapView::visibleTiles(int level) const
+{
+    const auto span = double(tileSize_ << level);
+    auto firstColumn = static_cast<int>(std::max(0.0, view_.left()) / span);
+    auto lastColumn = static_cast<int>(std::min(double(nBins_ - 1), view_.right()) / span);
+    auto firstRow = static_cast<int>(std::max(0.0, view_.top()) / span);
+    auto lastRow = static_cast<int>(std::min(double(nSpectra_ - 1), view_.bottom()) / span);
+    return {QPoint(firstColumn, firstRow), QPoint(lastColumn, lastRow)};
+}
+
+// Request any visible tiles we don't yet have
+void DetectorMapView::requestVisibleTiles()
+{
+    const auto level = currentLevel();
+    const auto tiles = visibleTiles(level);
+    for (auto row = tiles.top(); row <= tiles.bottom(); ++row)
+    {
+        for (auto column = tiles.left(); column <= tiles.right(); ++column)
+        {
+            const auto key = tileKey(level, row, column);
+            if (requestedTiles_.contains(key))
+                continue;
+            requestedTiles_.insert(key);
+
+            // The view may have been closed by the time the tile arrives
+            QPointer<DetectorMapView> view(this);
+            const auto maxCount = maxCount_;
+            tileRequester_(level, row, column,
+                           [view, key, maxCount](HttpRequestWorker *worker)
+                           {
+                               if (!view)
+                                   return;
+
+                               // Forget failed tiles so that they are requested again
+                               auto tileData = worker->jsonResponse().object();
+                               if (worker->errorType() != QNetworkReply::NoError || !tileData.contains("data"))
+                               {
+                                   view->requestedTiles_.remove(key);
+                                   return;
+                               }
+
+                               // Colour-map the tile on a worker thread
+                               QtConcurrent::run([tileData, maxCount]() { return createTile(tileData, maxCount); })
+                                   .then(view,
+                                         [view, key](Tile tile)
+                                         {
+                                             if (tile.values.empty())
+                                             {
+                                                 view->requestedTiles_.remove(key);
+                                                 return;
+                                             }
+                                             view->tiles_.insert(key, std::move(tile));
+                                             view->update();
+                                         });
+                           });
+        }
+    }
+}
+
+/*
+ * View
+ */
+
+// Keep the view within the map
+void DetectorMapView::constrainView()
+{
+    // Don't zoom in beyond a few bins, or out beyond the whole map
+    auto width = std::clamp(view_.width(), std::min(8.0, double(nBins_)), double(nBins_));
+    auto height = std::clamp(view_.height(), std::min(8.0, double(nSpectra_)), double(nSpectra_));
+    auto left = std::clamp(view_.left(), 0.0, nBins_ - width);
+    auto top = std::clamp(view_.top(), 0.0, nSpectra_ - height);
+    view_ = QRectF(left, top, width, height);
+}
+
+// Map between widget and (bin, spectrum) coordinates
+QPointF DetectorMapView::mapToData(const QPointF &pos) const
+{
+    return {view_.left() + pos.x() / width() * view_.width(), view_.top() + pos.y() / height() * view_.height()};
+}
+
+QRectF DetectorMapView::mapFromData(const QRectF &rect) const
+{
+    const auto xScale = width() / view_.width(), yScale = height() / view_.height();
+    return {(rect.left() - view_.left()) * xScale, (rect.top() - view_.top()) * yScale, rect.width() * xScale,
+            rect.height() * yScale};
+}
+
+// Report the bin under the supplied widget position
+void DetectorMapView::reportCoordinates(const QPointF &pos)
+{
+    const auto data = mapToData(pos);
+    const auto bin = static_cast<int>(data.x()), spectrum = static_cast<int>(data.y());
+    if (bin < 0 || bin >= nBins_ || spectrum < 0 || spectrum >= nSpectra_)
+    {
+        emit clearCoordinates();
+        return;
+    }
+
+    auto message = QString("Spectrum %1, bin %2").arg(spectrum).arg(bin);
+    if (static_cast<size_t>(bin) + 1 < timeOfFlight_.size())
+        message += QString(" (%1-%2 µs)").arg(timeOfFlight_[bin]).arg(timeOfFlight_[bin + 1]);
+
+    // Report the value from the finest tile we have covering the bin
+    for (auto level = currentLevel(); level < nLevels_; ++level)
+    {
+        const auto span = tileSize_ << level;
+        auto it = tiles_.constFind(tileKey(level, spectrum / span, bin / span));
+        if (it == tiles_.constEnd())
+            continue;
+        auto row = (spectrum % span) >> level, column = (bin % span) >> level;
+        if (row >= it->rows || column >= it->columns)
+            break;
+        auto value = it->values[row * it->columns + column];
+        message += level == 0 ? QString(": %1 counts").arg(value)
+                              : QString(": %1 counts (mean over %2x%2 bins)").arg(value).arg(1 << level);
+        break;
+    }
+
+    emit showCoordinates(message);
+}
+
+void DetectorMapView::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(colourMap()[0]));
+
+    // Draw coarser tiles first so that finer ones replace them as they arrive
+    const auto finestLevel = currentLevel();
+    for (auto level = nLevels_ - 1; level >= finestLevel; --level)
+    {
+        const auto span = tileSize_ << level;
+        const auto tiles = visibleTiles(level);
+        for (auto row = tiles.top(); row <= tiles.bottom(); ++row)
+        {
+            for (auto column = tiles.left(); column <= tiles.right(); ++column)
+            {
+                auto it = tiles_.constFind(tileKey(level, row, column));
+                if (it == tiles_.constEnd())
+                    continue;
+                QRectF tileRect(column * span, row * span, it->columns << level, it->rows << level);
+                painter.drawImage(mapFromData(tileRect), it->image);
+            }
+        }
+    }
+}
+
+void DetectorMapView::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    requestVisibleTiles();
+}
+
+void DetectorMapView::wheelEvent(QWheelEvent *event)
+{
+    // Zoom about the data point under the cursor
+    auto factor = event->angleDelta().y() > 0 ? 0.8 : 1.25;
+    auto centre = mapToData(event->position());
+    view_ = QRectF(centre.x() - (centre.x() - view_.left()) * factor, centre.y() - (centre.y() - view_.top()) * factor,
+                   view_.width() * factor, view_.height() * factor);
+    constrainView();
+    requestVisibleTiles();
+    update();
+}
+
+void DetectorMapView::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+    {
+        lastMousePos_ = event->position();
+        setCursor(Qt::SizeAllCursor);
+    }
+    else if (event->button() == Qt::RightButton)
+    {
+        view_ = QRectF(0, 0, nBins_, nSpectra_);
+        requestVisibleTiles();
+        update();
+    }
+}
+
+void DetectorMapView::mouseMoveEvent(QMouseEvent *event)
+{
+    // Pan the map with a left mouse drag
+    if (event->buttons() & Qt::LeftButton)
+    {
+        auto delta = mapToData(lastMousePos_) - mapToData(event->position());
+        view_.translate(delta);
+        constrainView();
+        lastMousePos_ = event->position();
+        requestVisibleTiles();
+        update();
+    }
+
+    reportCoordinates(event->position());
+}
+
+void DetectorMapView::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        unsetCursor();
+}
+
+void DetectorMapView::leaveEvent(QEvent *event)
+{
+    emit clearCoordinates();
+    QWidget::leaveEvent(event);
+}
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (c) 2024 Team JournalViewer and contributors
+
+#pragma once
+
+#include "httpRequestWorker.h"
+#include <QHash>
+#include <QImage>
+#include <QJsonObject>
+#include <QSet>
+#include <QWidget>
+#include <functional>
+#include <vector>
+
+// Intensity map of detector counts against spectrum and time-of-flight bin, assembled from tiles retrieved on demand
+class DetectorMapView : public QWidget
+{
+    Q_OBJECT
+
+    public:
+    // Function requesting a single tile (level, row, column) from the backend
+    using TileRequester =
+        std::function<void(int level, int row, int column, const HttpRequestWorker::HttpRequestHandler &handler)>;
+    DetectorMapView(const QJsonObject &info, TileRequester tileRequester, QWidget *parent = nullptr);
+
+    // Binned counts for a single tile
+    struct Tile
+    {
+        int rows{0}, columns{0};
+        // Mean counts per bin
+        std::vector<float> values;
+        // Colour-mapped values
+        QImage image;
+    };
+
+    private:
+    // Map dimensions and pyramid layout
+    int nSpectra_{0}, nBins_{0}, tileSize_{256}, nLevels_{1};
+    // Maximum count in any single bin
+    double maxCount_{0.0};
+    // Time-of-flight bin edges
+    std::vector<double> timeOfFlight_;
+    // Function used to request tiles
+    TileRequester tileRequester_;
+    // Tiles retrieved so far
+    QHash<quint64, Tile> tiles_;
+    // Tiles which have been requested or retrieved (failed requests are forgotten so they can be retried)
+    QSet<quint64> requestedTiles_;
+    // Visible region in (bin, spectrum) coordinates
+    QRectF view_;
+    // Last mouse position when panning
+    QPointF lastMousePos_;
+
+    private:
+    // Return key for the specified tile
+    static quint64 tileKey(int level, int row, int column);
+    // Convert a tile response into binned values and an image
+    static Tile createTile(const QJsonObject &tileData, double maxCount);
+    // Return the pyramid level appropriate to the current view
+    int currentLevel() const;
+    // Return the range of tiles at the specified level which intersect the view
+    QRect visibleTiles(int level) const;
+    // Request any visible tiles we don't yet have
+    void requestVisibleTiles();
+    // Keep the view within the map
+    void constrainView();
+    // Map between widget and (bin, spectrum) coordinates
+    QPointF mapToData(const QPointF &pos) const;
+    QRectF mapFromData(const QRectF &rect) const;
+    // Report the bin under the supplied widget position
+    void reportCoordinates(const QPointF &pos);
+
+    protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+
+    signals:
+    void showCoordinates(QString message);
+    void clearCoordinates();
+};
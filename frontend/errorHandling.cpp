@@ -2,6 +2,8 @@
 // Copyright (c) 2024 Team JournalViewer and contributors
 
 #include "mainWindow.h"
+#include <QDebug>
+#include <QJsonObject>
 #include <QNetworkReply>
 
 // Perform check for errors on http request, returning the handled error
@@ -43,6 +45,19 @@ QString MainWindow::handleRequestError(HttpRequestWorker *worker, const QString
     return NoError;
 }
 
+// Report runs which the backend could not read while completing a multi-run request
+void MainWindow::reportRunErrors(const QJsonObject &runErrors, const QString &taskDescription)
+{
+    if (runErrors.isEmpty())
+        return;
+
+    for (auto it = runErrors.constBegin(); it != runErrors.constEnd(); ++it)
+        qWarning() << "Failed to read run" << it.key() << "while" << taskDescription << ":" << it.value().toString();
+    statusBar()->showMessage(
+        QString("Skipped %1 run(s) which could not be read: %2").arg(runErrors.count()).arg(runErrors.keys().join(", ")),
+        5000);
+}
+
 // Update the error page
 void MainWindow::setErrorPage(const QString &errorTitle, const QString &errorText)
 {
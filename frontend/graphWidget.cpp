@@ -6,22 +6,43 @@
 #include "mainWindow.h"
 #include "ui_graphWidget.h"
 #include <QChart>
-#include <QDebug>
 #include <QInputDialog>
 #include <QJsonArray>
+#include <QSignalBlocker>
 #include <QXYSeries>
+#include <algorithm>
 
 GraphWidget::GraphWidget(QWidget *parent, QChart *chart, QString type) : QWidget(parent)
 {
     type_ = type;
     ui_.setupUi(this);
     ui_.chartView->assignChart(chart);
-    connect(ui_.divideByRunRadio, &QRadioButton::toggled, [=]() { runDivideSpinHandling(); });
-    connect(ui_.divideByRunSpin, &QSpinBox::editingFinished, [=]() { runDivideSpinHandling(); });
-    connect(ui_.divideByMonitorSpin, &QSpinBox::editingFinished, [=]() { monDivideSpinHandling(); });
-    connect(ui_.divideByMonitorRadio, &QRadioButton::toggled, [=]() { monDivideSpinHandling(); });
 
-    modified_ = "-1";
+    // Radio buttons are exclusive, so only respond to the one being checked
+    for (auto *radio : {ui_.defaultRadio, ui_.divideByRunRadio, ui_.divideByMonitorRadio})
+        connect(radio, &QRadioButton::toggled,
+                [=](bool checked)
+                {
+                    if (checked)
+                        updateNormalisation();
+                });
+    connect(ui_.divideByRunSpin, &QSpinBox::editingFinished, [=]() { updateNormalisation(); });
+    connect(ui_.divideByMonitorSpin, &QSpinBox::editingFinished, [=]() { updateNormalisation(); });
+
+    // Spectra from runs still being written are retrieved periodically while live updates are enabled, waiting for each
+    // set to be displayed before asking for the next
+    liveTimer_.setSingleShot(true);
+    liveTimer_.setInterval(2000);
+    connect(&liveTimer_, &QTimer::timeout, this, &GraphWidget::refreshRequested);
+    connect(ui_.liveCheck, &QCheckBox::toggled,
+            [=](bool checked)
+            {
+                if (checked)
+                    liveTimer_.start();
+                else
+                    liveTimer_.stop();
+            });
+
     ui_.divideByRunSpin->setSpecialValueText(tr(" "));
     ui_.divideByMonitorSpin->setSpecialValueText(tr(" "));
     ui_.divideByRunSpin->setValue(-1);
@@ -32,309 +53,173 @@ GraphWidget::~GraphWidget() {}
 
 QString GraphWidget::getChartRuns() { return chartRuns_; }
 QString GraphWidget::getChartDetector() { return chartDetector_; }
-QJsonArray GraphWidget::getChartData() { return chartData_; }
+QString GraphWidget::getType() { return type_; }
 
 void GraphWidget::setChartRuns(QString chartRuns) { chartRuns_ = chartRuns; }
 void GraphWidget::setChartDetector(QString chartDetector) { chartDetector_ = chartDetector; }
-void GraphWidget::setChartData(QJsonArray chartData)
-{
-    chartData_ = chartData;
-    getBinWidths();
-}
+void GraphWidget::setSpectrumOptions(const QJsonObject &options) { spectrumOptions_ = options; }
+const QJsonObject &GraphWidget::spectrumOptions() const { return spectrumOptions_; }
+const SpectrumNormalisation &GraphWidget::normalisation() const { return normalisation_; }
 void GraphWidget::setLabel(QString label) // Use for presenting spectra information
 {
     return; // ui_.statusLabel->setText(label);
 }
 
-void GraphWidget::getBinWidths()
+// Add a spectrum displayed in the supplied series, retaining its raw data for normalisation
+void GraphWidget::addSpectrum(QXYSeries *series, SpectrumData data, const SeriesData::Bounds &bounds)
 {
-    binWidths_.clear();
-    for (auto run : chartData_)
-    {
-        QVector<double> binWidths;
-        auto runArray = run.toArray();
-        for (auto i = 0; i < runArray.count() - 1; i++)
-        {
-            double binWidth = runArray.at(i + 1)[0].toDouble() - runArray.at(i)[0].toDouble();
-            binWidths.append(binWidth);
-        }
-        binWidths_.append(binWidths);
-    }
+    spectra_.push_back({series, std::move(data), bounds, SpectrumNormalisation()});
 }
 
 ChartView *GraphWidget::getChartView() { return ui_.chartView; }
 
-// Handle normalisation conflicts
-void GraphWidget::runDivideSpinHandling()
-{
-    if (ui_.divideByRunSpin->isEnabled())
-    {
-        ui_.countsPerMicrosecondCheck->setChecked(false);
-        ui_.countsPerMicrosecondCheck->setEnabled(false);
-    }
-    else
-        ui_.countsPerMicrosecondCheck->setEnabled(true);
-    QString value = QString::number(ui_.divideByRunSpin->value());
-    if (!ui_.divideByRunSpin->isEnabled())
-        value = "-1";
-    if (modified_ == value && ui_.divideByRunSpin->isEnabled())
-        return;
+/*
+ * Normalisation
+ */
 
-    if (modified_ != "-1") // if modified
-    {
-        ui_.countsPerMicroAmpCheck->setChecked(false);
-        if (type_ == "Detector")
-            emit runDivide(chartDetector_, modified_, false);
-        else
-            emit monDivide(modified_, chartDetector_, false);
-        modified_ = "-1";
-        if (ui_.divideByRunSpin->isEnabled())
-            ui_.countsPerMicroAmpCheck->setChecked(true);
-    }
+// Return the normalisation selected in the controls
+SpectrumNormalisation GraphWidget::selectedNormalisation() const
+{
+    SpectrumNormalisation normalisation;
+    normalisation.perMicrosecond = ui_.countsPerMicrosecondCheck->isChecked();
+    normalisation.perProtonCharge = ui_.countsPerMicroAmpCheck->isChecked();
+    if (ui_.divideByRunRadio->isChecked() && ui_.divideByRunSpin->value() >= 0)
+        normalisation.referenceRun = ui_.divideByRunSpin->value();
+    if (ui_.divideByMonitorRadio->isChecked() && ui_.divideByMonitorSpin->value() >= 0)
+        normalisation.monitor = ui_.divideByMonitorSpin->value();
+    return normalisation;
+}
 
-    if (value != "-1" && value != modified_) // handles switching conflicts
-    {
-        bool toggle = ui_.countsPerMicroAmpCheck->isChecked();
-        ui_.countsPerMicroAmpCheck->setChecked(false);
-        if (type_ == "Detector")
-            emit runDivide(chartDetector_, value, true);
-        else
-            emit monDivide(value, chartDetector_, true);
-        modified_ = value;
-        if (toggle)
-            ui_.countsPerMicroAmpCheck->setChecked(true);
-    }
+// Return the monitor / reference run whose divisors should be requested along with the spectra
+QJsonObject GraphWidget::divisorRequest() const
+{
+    QJsonObject request;
+    if (normalisation_.monitor)
+        request["monitor"] = *normalisation_.monitor;
+    if (normalisation_.referenceRun)
+        request["referenceRun"] = *normalisation_.referenceRun;
+    return request;
 }
 
-// Handle normalisation conflicts
-void GraphWidget::monDivideSpinHandling()
+// Resolve conflicting normalisation controls and apply the selected normalisation if it has changed, requesting any
+// divisors it needs
+void GraphWidget::updateNormalisation()
 {
-    if (ui_.divideByMonitorSpin->isEnabled())
-    {
-        ui_.countsPerMicrosecondCheck->setChecked(false);
-        ui_.countsPerMicrosecondCheck->setEnabled(false);
-        ui_.countsPerMicroAmpCheck->setChecked(false);
-        ui_.countsPerMicroAmpCheck->setEnabled(false);
-    }
-    else
+    // Bin widths cancel when dividing by another spectrum, as do proton charges when dividing by a monitor of the same run
     {
-        ui_.countsPerMicrosecondCheck->setEnabled(true);
-        ui_.countsPerMicroAmpCheck->setEnabled(true);
+        const QSignalBlocker microsecondBlocker(ui_.countsPerMicrosecondCheck);
+        const QSignalBlocker microAmpBlocker(ui_.countsPerMicroAmpCheck);
+        auto dividing = ui_.divideByRunRadio->isChecked() || ui_.divideByMonitorRadio->isChecked();
+        if (dividing)
+            ui_.countsPerMicrosecondCheck->setChecked(false);
+        ui_.countsPerMicrosecondCheck->setEnabled(!dividing);
+        if (ui_.divideByMonitorRadio->isChecked())
+            ui_.countsPerMicroAmpCheck->setChecked(false);
+        ui_.countsPerMicroAmpCheck->setEnabled(!ui_.divideByMonitorRadio->isChecked());
     }
-    QString value = QString::number(ui_.divideByMonitorSpin->value());
-    if (!ui_.divideByMonitorSpin->isEnabled())
-        value = "-1";
-    if (modified_ == value && ui_.divideByMonitorSpin->isEnabled())
+
+    auto normalisation = selectedNormalisation();
+    if (normalisation == normalisation_)
         return;
+    normalisation_ = normalisation;
+
+    // Monitor and reference spectra are only retrieved when first needed, while the proton charge always comes with the
+    // spectra, so a missing charge can't be remedied by asking again
+    auto dividing = normalisation_.monitor || normalisation_.referenceRun;
+    SpectrumNormalisation divisorsOnly{false, false, normalisation_.monitor, normalisation_.referenceRun};
+    if (dividing && std::any_of(spectra_.begin(), spectra_.end(),
+                                [&divisorsOnly](const auto &spectrum)
+                                { return !spectrum.data.counts().empty() && !spectrum.data.canNormalise(divisorsOnly); }))
+        emit divisorsRequired();
+    else
+        applyNormalisation();
+}
 
-    if (modified_ != "-1") // if modified
-    {
-        emit monDivide(chartRuns_, modified_, false);
-        modified_ = "-1";
-    }
+void GraphWidget::on_countsPerMicrosecondCheck_stateChanged(int state) { updateNormalisation(); }
 
-    if (value != "-1" && value != modified_) // handles switching conflicts
-    {
-        emit monDivide(chartRuns_, value, true);
-        modified_ = value;
-    }
-}
+void GraphWidget::on_countsPerMicroAmpCheck_stateChanged(int state) { updateNormalisation(); }
 
-// normalise against time
-void GraphWidget::on_countsPerMicrosecondCheck_stateChanged(int state)
+// Update the raw spectra and divisors from a response to a request for the supplied normalisation
+void GraphWidget::setSpectra(const QJsonObject &response, const SpectrumNormalisation &requested)
 {
-    qreal max = 0;
-    qreal min = 0;
-    QString modifier = "/microSeconds";
-    auto yAxisTitle = ui_.chartView->chart()->axes(Qt::Vertical)[0]->titleText();
-
-    for (auto i = 0; i < ui_.chartView->chart()->series().count(); i++)
-    {
-        auto xySeries = qobject_cast<QXYSeries *>(ui_.chartView->chart()->series()[i]);
-        auto points = xySeries->points();
-        if (state == Qt::Checked)
+    buildSeriesData(
+        this, [response, requested]() { return SpectrumData::fromSpectrumResponse(response, requested); },
+        [=](std::vector<SpectrumData> spectra)
         {
-            for (auto j = 0; j < points.count(); j++)
+            // Divisors already held remain valid unless the counts have changed
+            for (size_t i = 0; i < std::min(spectra.size(), spectra_.size()); ++i)
             {
-                auto hold = points[j].y() / binWidths_[i][j];
-                if (i == 0 && j == 0)
+                auto &displayed = spectra_[i];
+                if (spectra[i].counts() == displayed.data.counts())
+                    displayed.data.addDivisors(spectra[i]);
+                else
                 {
-                    max = hold;
-                    min = hold;
+                    displayed.data = std::move(spectra[i]);
+                    displayed.applied.reset();
                 }
-                if (hold > max)
-                    max = hold;
-                else if (hold < min)
-                    min = hold;
-                points[j].setY(hold);
             }
-            yAxisTitle.append(modifier);
-        }
-        else
-        {
-            for (auto j = 0; j < points.count(); j++)
-            {
-                auto hold = points[j].y() * binWidths_[i][j];
-                if (i == 0 && j == 0)
-                {
-                    max = hold;
-                    min = hold;
-                }
-                if (hold > max)
-                    max = hold;
-                else if (hold < min)
-                    min = hold;
-                points[j].setY(hold);
-            }
-            yAxisTitle.remove(modifier);
-        }
-        ui_.chartView->chart()->axes(Qt::Vertical)[0]->setTitleText(yAxisTitle);
+            applyNormalisation();
 
-        xySeries->replace(points);
-        if (fabs(max - min) < 2) // handles flat lines w/ library limitations
-        {
-            max++;
-            min--;
-        }
-        ui_.chartView->chart()->axes()[1]->setMax(max);
-        ui_.chartView->chart()->axes()[1]->setMin(min);
-    }
+            if (ui_.liveCheck->isChecked())
+                liveTimer_.start();
+        });
 }
 
-void GraphWidget::on_countsPerMicroAmpCheck_stateChanged(int state)
+// Recalculate series which are out of date from their raw data, and update the vertical axis
+void GraphWidget::applyNormalisation()
 {
-    if (state == Qt::Checked)
-        emit muAmps(chartRuns_, true, modified_);
-    else
-        emit muAmps(chartRuns_, false, modified_);
-}
-
-void GraphWidget::modifyAgainstString(QString values, bool checked)
-{
-    qreal max = 0;
-    qreal min = 0;
-    for (auto i = 0; i < ui_.chartView->chart()->series().count(); i++)
+    QJsonObject runErrors;
+    for (auto &displayed : spectra_)
     {
-        double val;
-        if (values.split(";").count() > 1)
-            val = values.split(";")[i].toDouble();
-        else
-            val = values.toDouble();
-        if (values.split(";").count() > ui_.chartView->chart()->series().count())
-            val = val / values.split(";").last().toDouble();
-        auto xySeries = qobject_cast<QXYSeries *>(ui_.chartView->chart()->series()[i]);
-        auto points = xySeries->points();
-        if (checked)
-        {
-
-            for (auto j = 0; j < points.count(); j++)
-            {
-                auto hold = points[j].y() / val;
-                if (i == 0 && j == 0)
-                {
-                    max = hold;
-                    min = hold;
-                }
-                if (hold > max)
-                    max = hold;
-                else if (hold < min)
-                    min = hold;
-                points[j].setY(hold);
-            }
-        }
-        else
-        {
-            for (auto j = 0; j < points.count(); j++)
-            {
-                auto hold = points[j].y() * val;
-                if (i == 0 && j == 0)
-                {
-                    max = hold;
-                    min = hold;
-                }
-                if (hold > max)
-                    max = hold;
-                else if (hold < min)
-                    min = hold;
-                points[j].setY(hold);
-            }
-        }
-        xySeries->replace(points);
-        if (fabs(max - min) < 2) // handles flat lines w/ library limitations
-        {
-            max++;
-            min--;
-        }
-        ui_.chartView->chart()->axes()[1]->setMax(max);
-        ui_.chartView->chart()->axes()[1]->setMin(min);
+        if (displayed.applied == normalisation_)
+            continue;
+
+        if (!displayed.data.canNormalise(normalisation_))
+            runErrors[displayed.data.name()] = normalisation_.perProtonCharge ? "No proton charge is recorded"
+                                                                              : "The divisor could not be retrieved";
+
+        // Series which can't be normalised are emptied rather than showing their raw counts
+        auto seriesData = displayed.data.seriesData(normalisation_);
+        seriesData.applyTo(displayed.series);
+        displayed.bounds = seriesData.bounds();
+        displayed.applied = normalisation_;
     }
+    updateVerticalAxis();
+
+    if (!runErrors.isEmpty())
+        emit normalisationErrors(runErrors);
 }
 
-void GraphWidget::modifyAgainstWorker(HttpRequestWorker *worker, bool checked)
+// Stop retrieving the spectra periodically
+void GraphWidget::stopLiveUpdates() { ui_.liveCheck->setChecked(false); }
+
+// Update the vertical axis range and title
+void GraphWidget::updateVerticalAxis()
 {
-    QJsonArray valueArray;
-    qreal max = 0;
-    qreal min = 0;
-    auto jsonArray = worker->jsonResponse().array();
-    auto dataType = jsonArray[0].toArray()[2].toString(0);
-    jsonArray.removeFirst();
-    for (auto i = 0; i < ui_.chartView->chart()->series().count(); i++)
+    auto *yAxis = ui_.chartView->chart()->axes(Qt::Vertical)[0];
+
+    QString title = "Counts";
+    if (normalisation_.perMicrosecond)
+        title += "/microSeconds";
+    if (normalisation_.perProtonCharge)
+        title += "/muAmps";
+    if (normalisation_.referenceRun)
+        title += "/run " + QString::number(*normalisation_.referenceRun);
+    if (normalisation_.monitor)
+        title += "/mon " + QString::number(*normalisation_.monitor);
+    yAxis->setTitleText(title);
+
+    SeriesData::Bounds bounds;
+    for (const auto &displayed : spectra_)
+        bounds.expand(displayed.bounds);
+    if (!bounds.valid)
+        return;
+
+    auto min = bounds.yMin, max = bounds.yMax;
+    if (fabs(max - min) < 2) // handles flat lines w/ library limitations
     {
-        if (jsonArray.count() > 1)
-            valueArray = jsonArray[i].toArray();
-        else
-            valueArray = jsonArray[0].toArray();
-        auto xySeries = qobject_cast<QXYSeries *>(ui_.chartView->chart()->series()[i]);
-        auto points = xySeries->points();
-        if (checked)
-        {
-            for (auto j = 0; j < points.count(); j++)
-            {
-                auto val = valueArray.at(j)[1].toDouble();
-                if (val != 0)
-                {
-                    auto hold = points[j].y() / val;
-                    if (i == 0 && j == 0)
-                    {
-                        max = hold;
-                        min = hold;
-                    }
-                    if (hold > max)
-                        max = hold;
-                    else if (hold < min)
-                        min = hold;
-                    points[j].setY(hold);
-                }
-            }
-        }
-        else
-        {
-            for (auto j = 0; j < points.count(); j++)
-            {
-                auto val = valueArray.at(j)[1].toDouble();
-                if (val != 0)
-                {
-                    auto hold = points[j].y() * val;
-                    if (i == 0 && j == 0)
-                    {
-                        max = hold;
-                        min = hold;
-                    }
-                    if (hold > max)
-                        max = hold;
-                    else if (hold < min)
-                        min = hold;
-                    points[j].setY(hold);
-                }
-            }
-        }
-        xySeries->replace(points);
-        if (fabs(max - min) < 2) // handles flat lines w/ library limitations
-        {
-            max++;
-            min--;
-        }
-        ui_.chartView->chart()->axes()[1]->setMax(max);
-        ui_.chartView->chart()->axes()[1]->setMin(min);
+        max++;
+        min--;
     }
+    yAxis->setRange(min, max);
 }
@@ -5,10 +5,17 @@
 
 #include "chartView.h"
 #include "httpRequestWorker.h"
+#include "seriesData.h"
 #include "ui_graphWidget.h"
 #include <QChart>
 #include <QChartView>
+#include <QTimer>
 #include <QWidget>
+#include <optional>
+#include <vector>
+
+// Forward Declarations
+class QXYSeries;
 
 class GraphWidget : public QWidget
 {
@@ -23,38 +30,68 @@ class GraphWidget : public QWidget
     QString run_;
     QString chartRuns_;
     QString chartDetector_;
-    QJsonArray chartData_;
-    QVector<QVector<double>> binWidths_;
     QString type_;
-    QString modified_;
+    // Summation / rebinning options used when requesting the spectra
+    QJsonObject spectrumOptions_;
+    // Normalisation selected in the controls
+    SpectrumNormalisation normalisation_;
+    // Displayed series with the raw spectrum it shows
+    struct DisplayedSpectrum
+    {
+        QXYSeries *series;
+        SpectrumData data;
+        SeriesData::Bounds bounds;
+        // Normalisation last applied to the series, if it is up to date
+        std::optional<SpectrumNormalisation> applied;
+    };
+    std::vector<DisplayedSpectrum> spectra_;
+    // Timer triggering retrieval of the spectra while live updates are enabled
+    QTimer liveTimer_;
 
     public:
     ChartView *getChartView();
 
     QString getChartRuns();
     QString getChartDetector();
-    QJsonArray getChartData();
+    QString getType();
 
     void setChartRuns(QString chartRuns);
     void setChartDetector(QString chartDetector);
-    void setChartData(QJsonArray chartData);
+    // Set / return summation / rebinning options used when requesting the spectra
+    void setSpectrumOptions(const QJsonObject &options);
+    const QJsonObject &spectrumOptions() const;
+    // Return the normalisation selected in the controls
+    const SpectrumNormalisation &normalisation() const;
+    // Return the monitor / reference run whose divisors should be requested along with the spectra
+    QJsonObject divisorRequest() const;
     void setLabel(QString label);
-
-    public slots:
-    void modifyAgainstString(QString values, bool checked);
-    void modifyAgainstWorker(HttpRequestWorker *worker, bool checked);
+    // Add a spectrum displayed in the supplied series, retaining its raw data for normalisation
+    void addSpectrum(QXYSeries *series, SpectrumData data, const SeriesData::Bounds &bounds);
+    // Update the raw spectra and divisors from a response to a request for the supplied normalisation
+    void setSpectra(const QJsonObject &response, const SpectrumNormalisation &requested);
+    // Stop retrieving the spectra periodically
+    void stopLiveUpdates();
 
     private:
-    void getBinWidths();
+    // Return the normalisation selected in the controls
+    SpectrumNormalisation selectedNormalisation() const;
+    // Recalculate series which are out of date from their raw data, and update the vertical axis
+    void applyNormalisation();
+    // Update the vertical axis range and title
+    void updateVerticalAxis();
 
     private slots:
-    void runDivideSpinHandling(); // Handle normalisation conflicts
-    void monDivideSpinHandling(); // Handle normalisation conflicts
+    // Resolve conflicting normalisation controls and apply the selected normalisation if it has changed, requesting any
+    // divisors it needs
+    void updateNormalisation();
     void on_countsPerMicrosecondCheck_stateChanged(int state);
     void on_countsPerMicroAmpCheck_stateChanged(int state);
 
     signals:
-    void muAmps(QString runs, bool checked, QString modified);
-    void runDivide(QString currentDetector, QString run, bool checked);
-    void monDivide(QString currentRun, QString mon, bool checked);
+    // The selected normalisation needs divisors we don't have, so the spectra should be requested again with them
+    void divisorsRequired();
+    // Some runs could not be normalised
+    void normalisationErrors(const QJsonObject &runErrors);
+    // The spectra should be requested again to show counts recorded since they were retrieved
+    void refreshRequested();
 };
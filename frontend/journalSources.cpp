@@ -256,6 +256,10 @@ void MainWindow::handleCompleteJournalRunData(HttpRequestWorker *worker, std::op
 
     updateForCurrentSource(JournalSource::JournalSourceState::OK);
 
+    // Analyse the new journal's runs if detector health or log statistics are being shown
+    startDetectorHealth();
+    startLogStatistics();
+
     // Highlight / go to specific run number if requested
     if (runNumberToHighlight)
         highlightRunNumber(*runNumberToHighlight);
@@ -287,6 +291,10 @@ void MainWindow::handleGetJournalUpdates(HttpRequestWorker *worker)
         // Update via the model
         runDataModel_.appendData(worker->jsonResponse().array());
     }
+
+    // Include the new runs in any detector health scan or log statistics
+    startDetectorHealth();
+    startLogStatistics();
 }
 
 // Handle jump to journal
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (c) 2024 Team JournalViewer and contributors
+
+#include "liveLogMonitor.h"
+#include "chartView.h"
+#include "seriesData.h"
+#include <QJsonObject>
+#include <algorithm>
+
+namespace
+{
+// Interval between requests for new samples (ms)
+constexpr auto PollInterval = 2000;
+} // namespace
+
+LiveLogMonitor::LiveLogMonitor(SampleRequester sampleRequester, ChartView *dateTimeChartView, ChartView *relTimeChartView,
+                               QObject *parent)
+    : QObject(parent), sampleRequester_(std::move(sampleRequester)), dateTimeChartView_(dateTimeChartView),
+      relTimeChartView_(relTimeChartView)
+{
+    pollTimer_.setInterval(PollInterval);
+    connect(&pollTimer_, &QTimer::timeout, this, &LiveLogMonitor::poll);
+}
+
+// Monitor the run whose samples (of which there are currently nSamples) are displayed in the supplied series
+void LiveLogMonitor::addRun(int runNumber, const QDateTime &startTime, int nSamples, QXYSeries *dateSeries,
+                            QXYSeries *relSeries)
+{
+    runs_[runNumber] = {startTime, nSamples, dateSeries, relSeries};
+}
+
+// Set whether new samples are requested
+void LiveLogMonitor::setActive(bool active)
+{
+    if (active)
+    {
+        poll();
+        pollTimer_.start();
+    }
+    else
+        pollTimer_.stop();
+}
+
+// Request new samples for all runs
+void LiveLogMonitor::poll()
+{
+    for (auto &[runNumber, run] : runs_)
+    {
+        // Don't ask again until the last request has been answered
+        if (run.pending)
+            continue;
+        run.pending = true;
+
+        // The monitor may have been destroyed by the time the samples arrive
+        QPointer<LiveLogMonitor> monitor(this);
+        sampleRequester_(runNumber, run.nSamples,
+                         [monitor, runNumber = runNumber](HttpRequestWorker *worker)
+                         {
+                             if (monitor)
+                                 monitor->handleSamples(runNumber, worker);
+                         });
+    }
+}
+
+// Append new samples for the run to its series
+void LiveLogMonitor::handleSamples(int runNumber, HttpRequestWorker *worker)
+{
+    auto it = runs_.find(runNumber);
+    if (it == runs_.end())
+        return;
+    auto &run = it->second;
+    run.pending = false;
+
+    // Errors are transient while a file is being written, so just try again next time
+    if (worker->errorType() != QNetworkReply::NoError)
+        return;
+    const auto response = worker->jsonResponse().object();
+    if (!response.contains("total") || response.contains("categories"))
+        return;
+
+    const auto first = response["first"].toInt();
+    if (first != run.nSamples)
+        return;
+    const auto times = decodeFloat64Array(response["time"]);
+    const auto values = decodeFloat64Array(response["value"]);
+    if (times.empty())
+        return;
+    run.nSamples = first + static_cast<int>(std::min(times.size(), values.size()));
+
+    auto [absolute, relative] = SeriesData::fromLogValues(QString::number(runNumber), run.startTime, times, values);
+    if (dateTimeChartView_ && run.dateSeries)
+        dateTimeChartView_->appendPoints(run.dateSeries, absolute.points());
+    if (relTimeChartView_ && run.relSeries)
+        relTimeChartView_->appendPoints(run.relSeries, relative.points());
+}
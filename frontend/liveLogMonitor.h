@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (c) 2024 Team JournalViewer and contributors
+
+#pragma once
+
+#include "httpRequestWorker.h"
+#include <QDateTime>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QXYSeries>
+#include <functional>
+#include <map>
+
+// Forward Declarations
+class ChartView;
+
+// Polls the backend for log samples recorded since those displayed, appending them to the existing series
+class LiveLogMonitor : public QObject
+{
+    Q_OBJECT
+
+    public:
+    // Function requesting samples for a run (number) from the index of the first new sample onwards
+    using SampleRequester = std::function<void(int runNumber, int first, const HttpRequestWorker::HttpRequestHandler &handler)>;
+    LiveLogMonitor(SampleRequester sampleRequester, ChartView *dateTimeChartView, ChartView *relTimeChartView,
+                   QObject *parent = nullptr);
+
+    private:
+    // Displayed series and sample count for a single run
+    struct Run
+    {
+        QDateTime startTime;
+        int nSamples{0};
+        QPointer<QXYSeries> dateSeries, relSeries;
+        // Whether a request for new samples is outstanding
+        bool pending{false};
+    };
+    // Function used to request samples
+    SampleRequester sampleRequester_;
+    // Charts displaying the series
+    QPointer<ChartView> dateTimeChartView_, relTimeChartView_;
+    // Monitored runs
+    std::map<int, Run> runs_;
+    // Timer triggering requests for new samples
+    QTimer pollTimer_;
+
+    public:
+    // Monitor the run whose samples (of which there are currently nSamples) are displayed in the supplied series
+    void addRun(int runNumber, const QDateTime &startTime, int nSamples, QXYSeries *dateSeries, QXYSeries *relSeries);
+    // Set whether new samples are requested
+    void setActive(bool active);
+
+    private slots:
+    // Request new samples for all runs
+    void poll();
+
+    private:
+    // Append new samples for the run to its series
+    void handleSamples(int runNumber, HttpRequestWorker *worker);
+};
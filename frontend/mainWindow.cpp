@@ -5,6 +5,7 @@
 #include "ui_mainWindow.h"
 #include "version.h"
 #include <QMessageBox>
+#include <QScrollBar>
 #include <QSettings>
 #include <QTimer>
 
@@ -54,6 +55,15 @@ MainWindow::MainWindow(QCommandLineParser &cliParser)
     // -- Context menu
     ui_.RunDataTable->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui_.RunDataTable, SIGNAL(customContextMenuRequested(QPoint)), SLOT(runDataContextMenuRequested(QPoint)));
+    // -- Rows scrolled into view are the first to have their log statistics retrieved
+    connect(ui_.RunDataTable->verticalScrollBar(), &QScrollBar::valueChanged, this,
+            &MainWindow::prioritiseVisibleLogStatistics);
+
+    // Search progress is shown in the status bar while matches are received
+    searchProgressBar_ = new QProgressBar(this);
+    searchProgressBar_->setMaximumWidth(200);
+    searchProgressBar_->hide();
+    statusBar()->addPermanentWidget(searchProgressBar_);
 
     // Disables closing data tab + handles tab closing
     ui_.MainTabs->tabBar()->setTabButton(0, QTabBar::RightSide, 0);
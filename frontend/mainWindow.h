@@ -19,6 +19,7 @@
 #include <QCheckBox>
 #include <QDomDocument>
 #include <QMainWindow>
+#include <QProgressBar>
 #include <QSortFilterProxyModel>
 #include <QTimer>
 
@@ -140,6 +141,16 @@ class MainWindow : public QMainWindow
     RunDataModel runDataModel_;
     RunDataFilterProxy runDataFilterProxy_;
     Instrument::RunDataColumns runDataColumns_, groupedRunDataColumns_;
+    // Counter identifying the current detector health scan
+    int detectorHealthScan_{0};
+    // Path of the SE log whose per-run statistics are shown as additional columns (if any)
+    QString logStatisticsPath_;
+    // Runs whose log statistics have yet to be requested, visible rows first
+    QList<int> pendingLogStatisticsRuns_;
+    // Counter identifying the current set of log statistics requests
+    int logStatisticsRequest_{0};
+    // Whether a request for log statistics is outstanding
+    bool logStatisticsRequestActive_{false};
 
     private:
     // Clear all run data
@@ -154,9 +165,24 @@ class MainWindow : public QMainWindow
     std::vector<int> selectedRunNumbers() const;
     // Select and show specified run number in table (if it exists)
     void highlightRunNumber(int runNumber);
+    // Start determining detector health for the current journal, if it is being shown
+    void startDetectorHealth();
+    // Handle detector health results, polling for more until the scan is complete
+    void handleDetectorHealth(HttpRequestWorker *worker, int scan);
+    // Set the additional columns shown for the run data
+    void updateLazyColumns();
+    // Start retrieving statistics of the chosen SE log for all runs in the current journal, if they are being shown
+    void startLogStatistics();
+    // Request log statistics for the next block of pending runs
+    void requestLogStatistics();
+    // Handle log statistics for a block of runs, then request the next
+    void handleLogStatistics(HttpRequestWorker *worker, int request);
 
     private slots:
     void on_actionRefreshJournal_triggered();
+    void on_actionShowDetectorHealth_toggled(bool checked);
+    // Move pending log statistics requests for the visible rows to the front of the queue
+    void prioritiseVisibleLogStatistics();
     void on_actionJumpTo_triggered();
     // Run data context menu requested
     void runDataContextMenuRequested(QPoint pos);
@@ -206,6 +232,8 @@ class MainWindow : public QMainWindow
     private:
     // Perform check for errors on http request, returning the handled error
     QString handleRequestError(HttpRequestWorker *worker, const QString &taskDescription);
+    // Report runs which the backend could not read while completing a multi-run request
+    void reportRunErrors(const QJsonObject &runErrors, const QString &taskDescription);
     // Update the error page
     void setErrorPage(const QString &errorTitle, const QString &errorText);
 
@@ -263,9 +291,20 @@ class MainWindow : public QMainWindow
     private:
     // Current source being acquired (if any)
     JournalSource *sourceBeingAcquired_{nullptr};
+    // Backend identifier of the search whose matches are displayed, or zero if none
+    int searchId_{0};
+    // Whether the displayed search is still running
+    bool searchRunning_{false};
+    // Number of matches of the displayed search wanted in the table, increased a page at a time as it is scrolled
+    int searchRowsWanted_{0};
+    // Whether matches of the displayed search have been requested but not yet received
+    bool searchPageRequested_{false};
+    // Progress of the current search, shown in the status bar
+    QProgressBar *searchProgressBar_{nullptr};
 
     private slots:
     void on_actionSearchEverywhere_triggered();
+    void on_actionStopSearch_triggered();
     void on_AcquisitionCancelButton_clicked(bool checked);
 
     private:
@@ -277,8 +316,14 @@ class MainWindow : public QMainWindow
     void handlePreSearchResult(HttpRequestWorker *worker);
     // Handle acquire all journal data for search
     void handleAcquireAllJournalsForSearch();
-    // Handle search result
-    void handleSearchResult(HttpRequestWorker *worker);
+    // Handle the start of a search, preparing to display matches as they arrive
+    void handleSearchStarted(HttpRequestWorker *worker);
+    // Request progress of the specified search, along with any wanted matches not yet received
+    void requestSearchUpdate(int searchId);
+    // Handle search progress, appending new matches and polling for more until the search is complete
+    void handleSearchUpdate(HttpRequestWorker *worker, int searchId);
+    // Finish the running search, showing the supplied message - matches remain available for paging
+    void finishSearch(const QString &message);
 
     /*
      * Visualisation
@@ -286,6 +331,8 @@ class MainWindow : public QMainWindow
     private:
     // Handle extracted SE log values for plotting
     void handlePlotSELogValue(HttpRequestWorker *worker);
+    // Handle extracted SE log values for display of per-run statistics
+    void handleChooseLogStatistics(HttpRequestWorker *worker);
     // Handle plotting of SE log data
     void handleCreateSELogPlot(HttpRequestWorker *worker);
 
@@ -297,13 +344,15 @@ class MainWindow : public QMainWindow
     void getField();
     void showStatus(qreal x, qreal y, QString title);
 
-    void handleSpectraCharting(HttpRequestWorker *worker);
+    void handleSpectraCharting(HttpRequestWorker *worker, const QJsonObject &options = {});
     void handleMonSpectraCharting(HttpRequestWorker *worker);
+    // Create a new graph tab for the supplied spectra, retrieved with the given options
+    void createSpectrumGraph(const QJsonObject &response, const QString &type, const QJsonObject &options = {});
     void plotSpectra(HttpRequestWorker *count);
     void plotMonSpectra(HttpRequestWorker *count);
+    // Create a new detector map tab for the specified run
+    void handleCreateDetectorMap(HttpRequestWorker *worker, int runNo);
 
-    // Normalisation options
-    void muAmps(QString runs, bool checked, QString);
-    void runDivide(QString currentDetector, QString run, bool checked);
-    void monDivide(QString currentRun, QString mon, bool checked);
+    // Request the displayed spectra again, with the divisors needed by the normalisation selected in the sending graph
+    void refreshSpectra();
 };
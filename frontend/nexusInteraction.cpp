@@ -2,8 +2,10 @@
 // Copyright (c) 2024 Team JournalViewer and contributors
 
 #include "chartView.h"
+#include "detectorMapView.h"
 #include "graphWidget.h"
 #include "mainWindow.h"
+#include "seriesData.h"
 #include <QAction>
 #include <QCategoryAxis>
 #include <QChartView>
@@ -13,6 +15,8 @@
 #include <QLineSeries>
 #include <QMessageBox>
 #include <QNetworkReply>
+#include <QPointer>
+#include <QRegularExpression>
 #include <QSettings>
 #include <QValueAxis>
 #include <algorithm>
@@ -55,11 +59,19 @@ void MainWindow::showStatus(qreal x, qreal y, QString title)
     QString message;
     auto *chartView = qobject_cast<ChartView *>(sender());
     auto yVal = QString::number(y);
-    if (QString(chartView->chart()->axes(Qt::Vertical)[0]->metaObject()->className()) == QString("QCategoryAxis"))
-    {
-        auto *yAxis = qobject_cast<QCategoryAxis *>(chartView->chart()->axes(Qt::Vertical)[0]);
+
+    // Logs plotted together each have their own vertical axis, so use the one attached to the hovered series
+    auto *verticalAxis = chartView->chart()->axes(Qt::Vertical)[0];
+    for (auto *series : chartView->chart()->series())
+        if (series->name() == title)
+        {
+            for (auto *axis : series->attachedAxes())
+                if (axis->orientation() == Qt::Vertical)
+                    verticalAxis = axis;
+            break;
+        }
+    if (auto *yAxis = qobject_cast<QCategoryAxis *>(verticalAxis))
         yVal = yAxis->categoriesLabels()[(int)y];
-    }
     if (QString(chartView->chart()->axes(Qt::Horizontal)[0]->metaObject()->className()) == QString("QDateTimeAxis"))
         message = QDateTime::fromMSecsSinceEpoch(x).toString("yyyy-MM-dd HH:mm:ss") + ", " + yVal;
     else
@@ -67,65 +79,13 @@ void MainWindow::showStatus(qreal x, qreal y, QString title)
     statusBar()->showMessage("Run " + title + ": " + message);
 }
 
-void MainWindow::handleSpectraCharting(HttpRequestWorker *worker)
+void MainWindow::handleSpectraCharting(HttpRequestWorker *worker, const QJsonObject &options)
 {
     // Check network reply
     if (handleRequestError(worker, "trying to plot a spectrum") != NoError)
         return;
 
-    auto *chart = new QChart();
-    auto *window = new GraphWidget(this, chart, "Detector");
-    connect(window, SIGNAL(muAmps(QString, bool, QString)), this, SLOT(muAmps(QString, bool, QString)));
-    connect(window, SIGNAL(runDivide(QString, QString, bool)), this, SLOT(runDivide(QString, QString, bool)));
-    connect(window, SIGNAL(monDivide(QString, QString, bool)), this, SLOT(monDivide(QString, QString, bool)));
-    ChartView *chartView = window->getChartView();
-
-    auto workerArray = worker->jsonResponse().array();
-    QString field = "Detector ";
-    auto metaData = workerArray[0].toArray();
-    QString runs = metaData[0].toString();
-    window->setChartRuns(metaData[0].toString());
-    window->setChartDetector(metaData[1].toString());
-    field += metaData[1].toString();
-    workerArray.removeFirst();
-    window->setChartData(workerArray);
-
-    foreach (const auto &run, workerArray)
-    {
-        auto runArray = run.toArray();
-        // For each plot point
-        auto *series = new QLineSeries();
-
-        connect(series, &QLineSeries::hovered,
-                [=](const QPointF point, bool hovered) { chartView->setHovered(point, hovered, series->name()); });
-        connect(chartView, SIGNAL(showCoordinates(qreal, qreal, QString)), this, SLOT(showStatus(qreal, qreal, QString)));
-        connect(chartView, SIGNAL(clearCoordinates()), statusBar(), SLOT(clearMessage()));
-
-        for (auto i = 0; i < runArray.count() - 1; i++)
-        {
-            auto centreBin =
-                runArray.at(i)[0].toDouble() + (runArray.at(i + 1)[0].toDouble() - runArray.at(i)[0].toDouble()) / 2;
-            series->append(centreBin, runArray.at(i)[1].toDouble());
-        }
-        chart->addSeries(series);
-    }
-    for (auto i = 0; i < chart->series().count(); i++)
-    {
-        auto *series = chart->series()[i];
-        series->setName(runs.split(";")[i]);
-    }
-    chart->createDefaultAxes();
-    chart->axes(Qt::Horizontal)[0]->setTitleText("Time of flight, &#181;s");
-    chart->axes(Qt::Vertical)[0]->setTitleText("Counts");
-    QString tabName = field;
-    ui_.MainTabs->addTab(window, tabName);
-    ui_.MainTabs->setCurrentIndex(ui_.MainTabs->count() - 1);
-    QString toolTip = field + "\n" + runs;
-    ui_.MainTabs->setTabToolTip(ui_.MainTabs->count() - 1, toolTip);
-    chartView->setFocus();
-
-    QString cycle = currentJournal().filename();
-    cycle.replace(0, 7, "cycle").replace(".xml", "");
+    createSpectrumGraph(worker->jsonResponse().object(), "Detector", options);
 }
 
 void MainWindow::handleMonSpectraCharting(HttpRequestWorker *worker)
@@ -134,70 +94,110 @@ void MainWindow::handleMonSpectraCharting(HttpRequestWorker *worker)
     if (handleRequestError(worker, "trying to plot a monitor spectrum") != NoError)
         return;
 
-    auto *chart = new QChart();
-    auto *window = new GraphWidget(this, chart, "Monitor");
-    connect(window, SIGNAL(muAmps(QString, bool, QString)), this, SLOT(muAmps(QString, bool, QString)));
-    connect(window, SIGNAL(runDivide(QString, QString, bool)), this, SLOT(runDivide(QString, QString, bool)));
-    connect(window, SIGNAL(monDivide(QString, QString, bool)), this, SLOT(monDivide(QString, QString, bool)));
-    ChartView *chartView = window->getChartView();
-
-    auto workerArray = worker->jsonResponse().array();
-    QString field = "Monitor ";
-    auto metaData = workerArray[0].toArray();
-    QString runs = metaData[0].toString();
-    window->setChartRuns(metaData[0].toString());
-    window->setChartDetector(metaData[1].toString());
-    field += metaData[1].toString();
-    workerArray.removeFirst();
-    window->setChartData(workerArray);
-
-    foreach (const auto &run, workerArray)
-    {
-        auto runArray = run.toArray();
-        // For each plot point
-        auto *series = new QLineSeries();
-
-        connect(series, &QLineSeries::hovered,
-                [=](const QPointF point, bool hovered) { chartView->setHovered(point, hovered, series->name()); });
-        connect(chartView, SIGNAL(showCoordinates(qreal, qreal, QString)), this, SLOT(showStatus(qreal, qreal, QString)));
-        connect(chartView, SIGNAL(clearCoordinates()), statusBar(), SLOT(clearMessage()));
+    createSpectrumGraph(worker->jsonResponse().object(), "Monitor");
+}
 
-        for (auto i = 0; i < runArray.count() - 1; i++)
+// Create a new graph tab for the supplied spectra, retrieved with the given options
+void MainWindow::createSpectrumGraph(const QJsonObject &response, const QString &type, const QJsonObject &options)
+{
+    QStringList runs;
+    for (const auto &runNumber : response["runNumbers"].toArray())
+        runs << QString::number(runNumber.toInt());
+    const auto spectrum = response["spectrum"];
+    auto spectrumId = spectrum.isString() ? spectrum.toString() : QString::number(spectrum.toInt());
+    reportRunErrors(response["errors"].toObject(), "plotting " + type.toLower() + " " + spectrumId);
+
+    // Convert the spectra into series data on a worker thread, then assemble the chart once complete
+    buildSeriesData(
+        this,
+        [response]()
         {
-            auto centreBin =
-                runArray.at(i)[0].toDouble() + (runArray.at(i + 1)[0].toDouble() - runArray.at(i)[0].toDouble()) / 2;
-            series->append(centreBin, runArray.at(i)[1].toDouble());
-        }
-        chart->addSeries(series);
-    }
-    for (auto i = 0; i < chart->series().count(); i++)
-    {
-        auto *series = chart->series()[i];
-        series->setName(runs.split(";")[i]);
-    }
-    chart->createDefaultAxes();
-    chart->axes(Qt::Horizontal)[0]->setTitleText("Time of flight, &#181;s");
-    chart->axes(Qt::Vertical)[0]->setTitleText("Counts");
-    QString tabName = field;
-    ui_.MainTabs->addTab(window, tabName);
-    ui_.MainTabs->setCurrentIndex(ui_.MainTabs->count() - 1);
-    QString toolTip = field + "\n" + runs;
-    ui_.MainTabs->setTabToolTip(ui_.MainTabs->count() - 1, toolTip);
-    chartView->setFocus();
+            std::pair<std::vector<SpectrumData>, std::vector<SeriesData>> data;
+            data.first = SpectrumData::fromSpectrumResponse(response);
+            for (const auto &spectrum : data.first)
+                data.second.emplace_back(spectrum.seriesData());
+            return data;
+        },
+        [=](std::pair<std::vector<SpectrumData>, std::vector<SeriesData>> data)
+        {
+            auto &[spectra, seriesData] = data;
+            auto *chart = new QChart();
+            auto *window = new GraphWidget(this, chart, type);
+            connect(window, SIGNAL(divisorsRequired()), this, SLOT(refreshSpectra()));
+            connect(window, SIGNAL(refreshRequested()), this, SLOT(refreshSpectra()));
+            connect(window, &GraphWidget::normalisationErrors, this,
+                    [=](const QJsonObject &runErrors) { reportRunErrors(runErrors, "normalising spectra"); });
+            ChartView *chartView = window->getChartView();
+            connect(chartView, SIGNAL(showCoordinates(qreal, qreal, QString)), this, SLOT(showStatus(qreal, qreal, QString)));
+            connect(chartView, SIGNAL(clearCoordinates()), statusBar(), SLOT(clearMessage()));
+
+            window->setChartRuns(runs.join(";"));
+            window->setChartDetector(spectrumId);
+            window->setSpectrumOptions(options);
+
+            // Set up axes using the precalculated bounds
+            auto bounds = SeriesData::combinedBounds(seriesData);
+            auto *xAxis = new QValueAxis();
+            xAxis->setRange(bounds.xMin, bounds.xMax);
+            xAxis->setTitleText("Time of flight, &#181;s");
+            chart->addAxis(xAxis, Qt::AlignBottom);
+            auto *yAxis = new QValueAxis();
+            yAxis->setRange(bounds.yMin, bounds.yMax);
+            yAxis->setTitleText("Counts");
+            chart->addAxis(yAxis, Qt::AlignLeft);
+
+            for (size_t i = 0; i < seriesData.size(); ++i)
+            {
+                auto *series = new QLineSeries();
+                seriesData[i].applyTo(series);
+                window->addSpectrum(series, std::move(spectra[i]), seriesData[i].bounds());
+
+                chart->addSeries(series);
+                series->attachAxis(xAxis);
+                series->attachAxis(yAxis);
+            }
+
+            QString field = type + " " + spectrumId;
+            ui_.MainTabs->addTab(window, field);
+            ui_.MainTabs->setCurrentIndex(ui_.MainTabs->count() - 1);
+            QString toolTip = field + "\n" + runs.join(";");
+            ui_.MainTabs->setTabToolTip(ui_.MainTabs->count() - 1, toolTip);
+            chartView->setFocus();
+        });
 }
 
 void MainWindow::plotSpectra(HttpRequestWorker *count)
 {
-    auto spectraCount = count->response().toUtf8();
+    auto spectraCount = count->response().toInt();
     bool valid;
-    auto spectrumNumber = QInputDialog::getInt(this, tr("Plot Detector Spectrum"),
-                                               tr("Enter detector spectrum to plot (0-" + spectraCount + "):"), 0, 0,
-                                               count->response().toInt() - 1, 1, &valid);
+    auto text = QInputDialog::getText(
+        this, tr("Plot Detector Spectrum"),
+        tr("Enter detector spectrum to plot, or spectra to sum (e.g. 10-20,25), from 0-%1:").arg(spectraCount - 1),
+        QLineEdit::Normal, "0", &valid);
+    if (!valid || text.trimmed().isEmpty())
+        return;
+
+    // A single index is requested as-is, anything else is passed to the backend as a list of spectra to sum
+    QJsonObject options;
+    auto spectrumNumber = text.trimmed().toInt(&valid);
     if (!valid)
+    {
+        if (text.contains(QRegularExpression("[^0-9,\\-\\s]")))
+        {
+            statusBar()->showMessage(QString("Invalid spectrum specification '%1'.").arg(text), 3000);
+            return;
+        }
+        options["spectra"] = text.simplified().remove(' ');
+        spectrumNumber = 0;
+    }
+    else if (spectrumNumber < 0 || spectrumNumber >= spectraCount)
+    {
+        statusBar()->showMessage(QString("Spectrum %1 is out of range.").arg(spectrumNumber), 3000);
         return;
+    }
 
-    backend_.getNexusSpectrum(currentJournalSource(), "detector", spectrumNumber, selectedRunNumbers(),
-                              [=](HttpRequestWorker *worker) { handleSpectraCharting(worker); });
+    backend_.getNexusSpectrum(currentJournalSource(), "detector", spectrumNumber, selectedRunNumbers(), options,
+                              [=](HttpRequestWorker *worker) { handleSpectraCharting(worker, options); });
 }
 
 void MainWindow::plotMonSpectra(HttpRequestWorker *count)
@@ -210,72 +210,63 @@ void MainWindow::plotMonSpectra(HttpRequestWorker *count)
     if (!valid)
         return;
 
-    backend_.getNexusSpectrum(currentJournalSource(), "monitor", monNumber, selectedRunNumbers(),
+    backend_.getNexusSpectrum(currentJournalSource(), "monitor", monNumber, selectedRunNumbers(), {},
                               [=](HttpRequestWorker *worker) { handleMonSpectraCharting(worker); });
 }
 
-void MainWindow::muAmps(QString runs, bool checked, QString modified)
-{
-    auto *window = qobject_cast<GraphWidget *>(sender());
-    QString modifier = "/muAmps";
-    auto yAxisTitle = window->getChartView()->chart()->axes(Qt::Vertical)[0]->titleText();
-
-    // if (modified != "-1")
-    // url_str += ";" + modified;
-
-    if (checked)
-        yAxisTitle.append(modifier);
-    else
-        yAxisTitle.remove(modifier);
-    window->getChartView()->chart()->axes(Qt::Vertical)[0]->setTitleText(yAxisTitle);
-
-    // For each run number extract the proton_charge data from the run data
-    QString result;
-    QStringList muAmps;
-    auto runNumbers = runs.split(";");
-    foreach (auto run, runNumbers)
-    {
-        auto runData = dataForRunNumber(run.toInt());
-        muAmps.append(runData ? (*runData)["proton_charge"].toString() : "1.0");
-    }
-
-    window->modifyAgainstString(muAmps.join(";"), checked);
-}
-
-void MainWindow::runDivide(QString currentDetector, QString run, bool checked)
+// Create a new detector map tab for the specified run
+void MainWindow::handleCreateDetectorMap(HttpRequestWorker *worker, int runNo)
 {
-    auto *window = qobject_cast<GraphWidget *>(sender());
-    QString modifier = "/run " + run;
-
-    auto yAxisTitle = window->getChartView()->chart()->axes(Qt::Vertical)[0]->titleText();
-    if (checked)
-        yAxisTitle.append(modifier);
-    else
-        yAxisTitle.remove(modifier);
-    window->getChartView()->chart()->axes(Qt::Vertical)[0]->setTitleText(yAxisTitle);
+    // Check network reply
+    if (handleRequestError(worker, "trying to show a detector map") != NoError)
+        return;
 
-    QString cycle = currentJournal().filename();
-    cycle.replace(0, 7, "cycle").replace(".xml", "");
+    // Tiles are requested by the view as they become visible
+    const auto *source = currentJournalSource();
+    auto tileRequester = [=](int level, int row, int column, const HttpRequestWorker::HttpRequestHandler &handler)
+    { backend_.getNexusDetectorMapTile(source, runNo, level, row, column, handler); };
+    auto *window = new DetectorMapView(worker->jsonResponse().object(), tileRequester);
+    connect(window, SIGNAL(showCoordinates(QString)), statusBar(), SLOT(showMessage(QString)));
+    connect(window, SIGNAL(clearCoordinates()), statusBar(), SLOT(clearMessage()));
 
-    backend_.getNexusSpectrum(currentJournalSource(), "detector", currentDetector.toInt(), {run.toInt()},
-                              [=](HttpRequestWorker *worker) { window->modifyAgainstWorker(worker, checked); });
+    ui_.MainTabs->addTab(window, "Detector map");
+    ui_.MainTabs->setCurrentIndex(ui_.MainTabs->count() - 1);
+    ui_.MainTabs->setTabToolTip(ui_.MainTabs->count() - 1, QString("Detector map\n%1").arg(runNo));
+    window->setFocus();
 }
 
-void MainWindow::monDivide(QString currentRun, QString mon, bool checked)
+// Request the displayed spectra again, with the divisors needed by the normalisation selected in the sending graph
+void MainWindow::refreshSpectra()
 {
-    auto *window = qobject_cast<GraphWidget *>(sender());
-    QString modifier = "/mon " + mon;
-
-    auto yAxisTitle = window->getChartView()->chart()->axes(Qt::Vertical)[0]->titleText();
-    if (checked)
-        yAxisTitle.append(modifier);
-    else
-        yAxisTitle.remove(modifier);
-    window->getChartView()->chart()->axes(Qt::Vertical)[0]->setTitleText(yAxisTitle);
-
-    QString cycle = currentJournal().filename();
-    cycle.replace(0, 7, "cycle").replace(".xml", "");
+    QPointer<GraphWidget> window = qobject_cast<GraphWidget *>(sender());
+    if (!window)
+        return;
 
-    backend_.getNexusSpectrum(currentJournalSource(), "monitor", mon.toInt(), {currentRun.toInt()},
-                              [=](HttpRequestWorker *worker) { window->modifyAgainstWorker(worker, checked); });
+    std::vector<int> runNumbers;
+    for (const auto &run : window->getChartRuns().split(";"))
+        runNumbers.push_back(run.toInt());
+
+    // The (possibly updated) spectra are retrieved with the same summation / rebinning as before, along with any monitor
+    // or reference spectrum the graph needs to normalise them
+    auto options = window->spectrumOptions();
+    const auto normalisation = window->normalisation();
+    const auto divisorRequest = window->divisorRequest();
+    if (!divisorRequest.isEmpty())
+        options["normalisation"] = divisorRequest;
+
+    backend_.getNexusSpectrum(currentJournalSource(), window->getType().toLower(), window->getChartDetector().toInt(),
+                              runNumbers, options,
+                              [=](HttpRequestWorker *worker)
+                              {
+                                  if (!window)
+                                      return;
+                                  if (handleRequestError(worker, "retrieving spectra") != NoError)
+                                  {
+                                      window->stopLiveUpdates();
+                                      return;
+                                  }
+                                  const auto response = worker->jsonResponse().object();
+                                  reportRunErrors(response["errors"].toObject(), "retrieving spectra");
+                                  window->setSpectra(response, normalisation);
+                              });
 }
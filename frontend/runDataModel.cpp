@@ -25,6 +25,16 @@ QJsonObject RunDataModel::getData(int row) const
 // Get Json data at index specified
 QJsonObject RunDataModel::getData(const QModelIndex &index) const { return getData(index.row()); }
 
+// Return the number of header columns
+int RunDataModel::headerColumnCount() const { return horizontalHeaders_ ? horizontalHeaders_->get().size() : 0; }
+
+// Return the column definition for the specified section
+const Instrument::RunDataColumn &RunDataModel::column(int section) const
+{
+    auto nHeaders = headerColumnCount();
+    return section < nHeaders ? horizontalHeaders_->get()[section] : lazyColumns_[section - nHeaders];
+}
+
 /*
  * Public Functions
  */
@@ -34,6 +44,8 @@ void RunDataModel::setData(QJsonArray &array)
 {
     beginResetModel();
     runData_ = array;
+    totalRows_ = 0;
+    fetchMoreHandler_ = nullptr;
     endResetModel();
 }
 
@@ -86,6 +98,48 @@ const QModelIndex RunDataModel::indexOfData(const QString &targetData, const QSt
     return {};
 }
 
+// Set additional columns whose values are supplied separately from the run data
+void RunDataModel::setLazyColumns(const Instrument::RunDataColumns &columns)
+{
+    beginResetModel();
+    lazyColumns_ = columns;
+    endResetModel();
+}
+
+// Set values for the lazy columns from objects identified by their run number, merging with any existing values
+void RunDataModel::setLazyValues(const QJsonArray &values)
+{
+    if (values.isEmpty())
+        return;
+
+    // Different sets of lazy columns are supplied independently, so only replace the values given
+    for (const auto &value : values)
+    {
+        auto object = value.toObject();
+        auto &runValues = lazyValues_[object["run_number"].toString()];
+        for (auto it = object.constBegin(); it != object.constEnd(); ++it)
+            runValues[it.key()] = it.value();
+    }
+
+    // Values may arrive for any row, so signal a change over all lazy columns at once
+    if (!lazyColumns_.empty() && rowCount() > 0)
+        emit dataChanged(index(0, headerColumnCount()), index(rowCount() - 1, columnCount() - 1), {Qt::DisplayRole});
+}
+
+// Clear all values for the lazy columns
+void RunDataModel::clearLazyValues()
+{
+    lazyValues_.clear();
+    if (!lazyColumns_.empty() && rowCount() > 0)
+        emit dataChanged(index(0, headerColumnCount()), index(rowCount() - 1, columnCount() - 1), {Qt::DisplayRole});
+}
+
+// Set the total number of rows available, beyond those currently held
+void RunDataModel::setTotalRows(int totalRows) { totalRows_ = totalRows; }
+
+// Set function to call to request more rows, which should then be appended
+void RunDataModel::setFetchMoreHandler(std::function<void()> handler) { fetchMoreHandler_ = std::move(handler); }
+
 /*
  * QAbstractTableModel Overrides
  */
@@ -94,7 +148,7 @@ int RunDataModel::rowCount(const QModelIndex &parent) const { return runData_ ?
 
 int RunDataModel::columnCount(const QModelIndex &parent) const
 {
-    return horizontalHeaders_ ? horizontalHeaders_->get().size() : 0;
+    return horizontalHeaders_ ? headerColumnCount() + static_cast<int>(lazyColumns_.size()) : 0;
 }
 
 QVariant RunDataModel::data(const QModelIndex &index, int role) const
@@ -105,11 +159,12 @@ QVariant RunDataModel::data(const QModelIndex &index, int role) const
     if (role != Qt::DisplayRole)
         return {};
 
-    const auto &headers = horizontalHeaders_->get();
-    auto &[columnTitle, targetData] = headers[index.column()];
+    auto &[columnTitle, targetData] = column(index.column());
 
-    // Get target data object
+    // Get target data object - values for lazy columns are held separately, keyed by run number
     QJsonObject obj = getData(index);
+    if (index.column() >= headerColumnCount())
+        obj = lazyValues_.value(obj["run_number"].toString());
 
     // Search to see if the target data specified by the column exists in the object
     if (!obj.contains(targetData))
@@ -157,15 +212,24 @@ QVariant RunDataModel::headerData(int section, Qt::Orientation orientation, int
     if (orientation != Qt::Horizontal)
         return {};
 
-    const auto &headers = horizontalHeaders_->get();
-
     switch (role)
     {
         case (Qt::UserRole):
-            return headers[section].second;
+            return column(section).second;
         case (Qt::DisplayRole):
-            return headers[section].first;
+            return column(section).first;
         default:
             return {};
     }
 }
+
+bool RunDataModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && fetchMoreHandler_ && rowCount() < totalRows_;
+}
+
+void RunDataModel::fetchMore(const QModelIndex &parent)
+{
+    if (canFetchMore(parent))
+        fetchMoreHandler_();
+}
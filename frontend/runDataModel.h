@@ -6,11 +6,13 @@
 #include "instrument.h"
 #include "optionalRef.h"
 #include <QAbstractTableModel>
+#include <QHash>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QMap>
 #include <QObject>
 #include <QVector>
+#include <functional>
 
 // JSON Run Data Model
 class RunDataModel : public QAbstractTableModel
@@ -22,12 +24,24 @@ class RunDataModel : public QAbstractTableModel
     // journal source for the model
     OptionalReferenceWrapper<QJsonArray> runData_;
     OptionalReferenceWrapper<const Instrument::RunDataColumns> horizontalHeaders_;
+    // Additional columns following the headers, whose values are supplied separately as they become available
+    Instrument::RunDataColumns lazyColumns_;
+    // Values for the lazy columns, keyed by run number
+    QHash<QString, QJsonObject> lazyValues_;
+    // Total number of rows available, of which only those in the current data are held (zero if all are held)
+    int totalRows_{0};
+    // Function called to request more rows when the view needs them
+    std::function<void()> fetchMoreHandler_;
 
     private:
     // Get Json data at row specified
     QJsonObject getData(int row) const;
     // Get Json data at index specified
     QJsonObject getData(const QModelIndex &index) const;
+    // Return the number of header columns
+    int headerColumnCount() const;
+    // Return the column definition for the specified section
+    const Instrument::RunDataColumn &column(int section) const;
 
     public:
     // Set the source data for the model
@@ -42,6 +56,16 @@ class RunDataModel : public QAbstractTableModel
     QString getData(const QString &targetData, const QModelIndex &index) const;
     // Get index of specified run number (if it exists)
     const QModelIndex indexOfData(const QString &targetData, const QString &value) const;
+    // Set additional columns whose values are supplied separately from the run data
+    void setLazyColumns(const Instrument::RunDataColumns &columns);
+    // Set values for the lazy columns from objects identified by their run number, merging with any existing values
+    void setLazyValues(const QJsonArray &values);
+    // Clear all values for the lazy columns
+    void clearLazyValues();
+    // Set the total number of rows available, beyond those currently held
+    void setTotalRows(int totalRows);
+    // Set function to call to request more rows, which should then be appended
+    void setFetchMoreHandler(std::function<void()> handler);
 
     /*
      * QAbstractTableModel Overrides
@@ -51,4 +75,6 @@ class RunDataModel : public QAbstractTableModel
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
 };
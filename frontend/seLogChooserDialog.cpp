@@ -22,7 +22,7 @@ SELogChooserDialog::SELogChooserDialog(QWidget *parent, GenericTreeItem *rootIte
 
 void SELogChooserDialog::onTreeSelectionChanged(const QItemSelection &selected, const QItemSelection &previous)
 {
-    ui_.SelectButton->setDisabled(selected.isEmpty());
+    ui_.SelectButton->setDisabled(!ui_.SELogTree->selectionModel()->hasSelection());
 }
 
 void SELogChooserDialog::on_CancelButton_clicked(bool checked) { reject(); }
@@ -46,6 +46,7 @@ QString SELogChooserDialog::getValue()
     return {};
 }
 
+// Perform selection of one or more log values
 QStringList SELogChooserDialog::getValues()
 {
     ui_.SELogTree->setSelectionMode(QAbstractItemView::ExtendedSelection);
@@ -56,8 +57,12 @@ QStringList SELogChooserDialog::getValues()
     {
         auto selection = ui_.SELogTree->selectionModel()->selectedIndexes();
         for (const auto &index : selection)
-            if (index.column() == 1)
-                result << treeModel_.data(index, Qt::DisplayRole).toString();
+        {
+            // Section items have no path
+            auto path = treeModel_.data(index, Qt::DisplayRole).toString();
+            if (index.column() == 1 && !path.isEmpty() && !result.contains(path))
+                result << path;
+        }
     }
 
     return result;
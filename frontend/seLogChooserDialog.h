@@ -30,5 +30,6 @@ class SELogChooserDialog : public QDialog
     public:
     // Perform selection
     QString getValue();
+    // Perform selection of one or more log values
     QStringList getValues();
 };
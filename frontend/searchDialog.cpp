@@ -9,6 +9,11 @@ SearchDialog::SearchDialog(QWidget *parent) : QDialog(parent)
     ui_.setupUi(this);
     ui_.ExperimentIdentifierEdit->setValidator(new QIntValidator(0, 9999999, this));
 
+    // Sort orders, performed by the backend
+    ui_.SortByCombo->addItem("Journal order", "");
+    ui_.SortByCombo->addItem("Run number", "run_number");
+    ui_.SortByCombo->addItem("Most recent first", "-start_time");
+
     // Connect check boxes to button update function
     connect(ui_.RunTitleCheckBox, SIGNAL(clicked(bool)), this, SLOT(updateButtonStates(bool)));
     connect(ui_.RunNumberCheckBox, SIGNAL(clicked(bool)), this, SLOT(updateButtonStates(bool)));
@@ -37,9 +42,9 @@ std::map<QString, QString> SearchDialog::getQuery()
     // Assemble the search query parameters
     std::map<QString, QString> parameters;
 
-    // Run title
+    // Run title, optionally matching similar titles rather than those containing the text
     if (ui_.RunTitleCheckBox->isChecked() && !ui_.RunTitleEdit->text().isEmpty())
-        parameters["title"] = ui_.RunTitleEdit->text();
+        parameters[ui_.RunTitleSimilarCheckBox->isChecked() ? "title~" : "title"] = ui_.RunTitleEdit->text();
 
     // Run Number
     if (ui_.RunNumberCheckBox->isChecked())
@@ -63,3 +68,6 @@ std::map<QString, QString> SearchDialog::getQuery()
 
     return parameters;
 }
+
+// Return field by which matches should be sorted (prefixed with '-' for descending order), or an empty string
+QString SearchDialog::sortBy() const { return ui_.SortByCombo->currentData().toString(); }
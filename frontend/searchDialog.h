@@ -31,4 +31,6 @@ class SearchDialog : public QDialog
     public:
     // Get search query
     std::map<QString, QString> getQuery();
+    // Return field by which matches should be sorted (prefixed with '-' for descending order), or an empty string
+    QString sortBy() const;
 };
@@ -4,6 +4,13 @@
 #include "mainWindow.h"
 #include "searchDialog.h"
 #include <QMessageBox>
+#include <algorithm>
+
+namespace
+{
+// Number of matches retrieved at once, and by which the table is extended as it is scrolled
+constexpr auto SearchPageSize = 500;
+} // namespace
 
 /*
  * UI
@@ -26,6 +33,16 @@ void MainWindow::on_AcquisitionCancelButton_clicked(bool checked)
         backend_.generateScanStop([&](HttpRequestWorker *worker) { handleGenerateScanStop(worker); });
 }
 
+void MainWindow::on_actionStopSearch_triggered()
+{
+    if (!searchRunning_)
+        return;
+
+    // Matches found so far remain displayed, and the final update reports how far the search got
+    backend_.stopSearch(currentJournalSource(), searchId_);
+    ui_.actionStopSearch->setEnabled(false);
+}
+
 // Update journal acquisition page for specified source
 void MainWindow::updateAcquisitionPage(int nCompleted, const QString &lastJournalProcessed)
 {
@@ -71,8 +88,8 @@ void MainWindow::handlePreSearchResult(HttpRequestWorker *worker)
         auto queryParameters = searchDialog.getQuery();
         if (queryParameters.empty())
             return;
-        backend_.search(currentJournalSource(), queryParameters,
-                        [=](HttpRequestWorker *worker) { handleSearchResult(worker); });
+        backend_.startSearch(currentJournalSource(), queryParameters, searchDialog.sortBy(),
+                             [=](HttpRequestWorker *worker) { handleSearchStarted(worker); });
     }
 }
 
@@ -126,8 +143,8 @@ void MainWindow::handleAcquireAllJournalsForSearch()
     pingTimer->start();
 }
 
-// Handle search result
-void MainWindow::handleSearchResult(HttpRequestWorker *worker)
+// Handle the start of a search, preparing to display matches as they arrive
+void MainWindow::handleSearchStarted(HttpRequestWorker *worker)
 {
     runData_ = QJsonArray();
     runDataModel_.setData(runData_);
@@ -143,18 +160,145 @@ void MainWindow::handleSearchResult(HttpRequestWorker *worker)
     // Get desired fields and titles from config files
     runDataColumns_ = currentInstrument() ? currentInstrument()->get().runDataColumns()
                                           : Instrument::runDataColumns(Instrument::InstrumentType::Neutron);
-    runData_ = worker->jsonResponse().array();
 
-    // Set table data
+    // Set table data, to which matches are appended as they arrive
     runDataModel_.setHorizontalHeaders(runDataColumns_);
     runDataModel_.setData(runData_);
-
-    ui_.RunDataTable->resizeColumnsToContents();
-    updateSearch(searchString_);
     ui_.RunFilterEdit->clear();
 
     // Set the journal state
     currentJournalSource()->setShowingSearchedData();
 
     updateForCurrentSource(JournalSource::JournalSourceState::OK);
+
+    const auto update = worker->jsonResponse().object();
+    const auto searchId = update["searchId"].toInt();
+    searchId_ = searchId;
+    searchRunning_ = true;
+    searchRowsWanted_ = SearchPageSize;
+    searchPageRequested_ = false;
+    searchProgressBar_->setRange(0, update["numJournals"].toInt());
+    searchProgressBar_->setValue(0);
+    searchProgressBar_->show();
+    ui_.actionStopSearch->setEnabled(true);
+
+    // Retrieve further pages of matches as the table is scrolled to the end of those held
+    runDataModel_.setFetchMoreHandler(
+        [this, searchId]()
+        {
+            if (searchId != searchId_)
+                return;
+            searchRowsWanted_ = runData_.count() + SearchPageSize;
+
+            // Pages are retrieved by the next poll while the search is running
+            if (!searchRunning_ && !searchPageRequested_)
+                requestSearchUpdate(searchId);
+        });
+
+    requestSearchUpdate(searchId);
+}
+
+// Request progress of the specified search, along with any wanted matches not yet received
+void MainWindow::requestSearchUpdate(int searchId)
+{
+    searchPageRequested_ = true;
+    auto nReceived = runData_.count();
+    backend_.getSearchUpdate(currentJournalSource(), searchId, nReceived, std::max(0, searchRowsWanted_ - nReceived),
+                             [=](HttpRequestWorker *worker) { handleSearchUpdate(worker, searchId); });
+}
+
+// Handle search progress, appending new matches and polling for more until the search is complete
+void MainWindow::handleSearchUpdate(HttpRequestWorker *worker, int searchId)
+{
+    // Ignore updates from searches we have since abandoned
+    if (searchId != searchId_)
+        return;
+    searchPageRequested_ = false;
+
+    // Abandon the search if its results are no longer displayed
+    if (!currentJournalSource() || !currentJournalSource()->showingSearchedData())
+    {
+        if (searchRunning_)
+        {
+            if (currentJournalSource())
+                backend_.stopSearch(currentJournalSource(), searchId);
+            finishSearch("Search abandoned.");
+        }
+        searchId_ = 0;
+        return;
+    }
+
+    // Check network reply
+    if (handleRequestError(worker, "retrieving search results") != NoError ||
+        worker->response().startsWith("\"NOT_RUNNING"))
+    {
+        if (searchRunning_)
+            finishSearch(QString("Search ended with %1 matching runs.").arg(runData_.count()));
+        searchId_ = 0;
+        return;
+    }
+
+    const auto update = worker->jsonResponse().object();
+    const auto results = update["results"].toArray();
+    const auto nMatches = update["numMatches"].toInt();
+    // Only the leading matches are retained by the backend for paging
+    const auto nRetained = update["numRetained"].toInt();
+    if (!results.isEmpty())
+    {
+        runDataModel_.appendData(results);
+        if (runData_.count() == results.count())
+            ui_.RunDataTable->resizeColumnsToContents();
+        updateSearch(searchString_);
+    }
+    runDataModel_.setTotalRows(nRetained);
+
+    // Pages retrieved after the search completed need no further handling
+    if (!searchRunning_)
+        return;
+
+    searchProgressBar_->setValue(update["numCompleted"].toInt());
+
+    if (update["complete"].toBool())
+    {
+        const auto errors = update["errors"].toObject();
+        for (auto it = errors.begin(); it != errors.end(); ++it)
+            qDebug() << "Search failed for" << it.key() << ":" << it.value().toString();
+        if (errors.contains("searchTerms"))
+            QMessageBox::warning(this, "Invalid Search",
+                                 QString("The search could not be run:\n%1").arg(errors["searchTerms"].toString()));
+
+        auto message = QString("Search %1 with %2 matching runs")
+                           .arg(update["stopped"].toBool() ? "stopped" : "complete")
+                           .arg(nMatches);
+        if (nRetained < nMatches)
+            message += QString(", showing the first %1").arg(nRetained);
+        if (!errors.isEmpty() && !errors.contains("searchTerms"))
+            message += QString(" (%1 journals could not be searched)").arg(errors.count());
+        finishSearch(message + ".");
+        return;
+    }
+    auto message = QString("Searching (%1 of %2 journals, %3 matching runs")
+                       .arg(update["numCompleted"].toInt())
+                       .arg(update["numJournals"].toInt())
+                       .arg(nMatches);
+    if (!update["totalEstimate"].isNull())
+        message += QString(", about %1 expected").arg(update["totalEstimate"].toInt());
+    statusBar()->showMessage(message + ")...");
+
+    // Ask for progress and the next matches after a short wait
+    QTimer::singleShot(500, this,
+                       [=]()
+                       {
+                           if (searchId == searchId_)
+                               requestSearchUpdate(searchId);
+                       });
+}
+
+// Finish the running search, showing the supplied message - matches remain available for paging
+void MainWindow::finishSearch(const QString &message)
+{
+    searchRunning_ = false;
+    searchProgressBar_->hide();
+    ui_.actionStopSearch->setEnabled(false);
+    statusBar()->showMessage(message, 5000);
 }
@@ -0,0 +1,324 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (c) 2024 Team JournalViewer and contributors
+
+#include "seriesData.h"
+#include <QXYSeries>
+#include <QtEndian>
+#include <algorithm>
+
+// Decode a base64 string of little-endian float64 values, as sent by the backend for large arrays
+std::vector<double> decodeFloat64Array(const QJsonValue &value)
+{
+    const auto bytes = QByteArray::fromBase64(value.toString().toLatin1());
+    std::vector<double> result(bytes.size() / sizeof(double));
+    qFromLittleEndian<double>(bytes.constData(), result.size(), result.data());
+    return result;
+}
+
+SeriesData::SeriesData(const QString &name, QList<QPointF> points) : name_(name), points_(std::move(points))
+{
+    updateBounds();
+}
+
+SeriesData::SeriesData(const QString &name, QList<QPointF> points, const Bounds &bounds)
+    : name_(name), points_(std::move(points)), bounds_(bounds)
+{
+}
+
+/*
+ * Bounds
+ */
+
+// Expand to encompass the supplied bounds
+void SeriesData::Bounds::expand(const Bounds &other)
+{
+    if (!other.valid)
+        return;
+
+    if (!valid)
+    {
+        *this = other;
+        return;
+    }
+
+    xMin = std::min(xMin, other.xMin);
+    xMax = std::max(xMax, other.xMax);
+    yMin = std::min(yMin, other.yMin);
+    yMax = std::max(yMax, other.yMax);
+}
+
+/*
+ * Data
+ */
+
+// Return series name
+const QString &SeriesData::name() const { return name_; }
+
+// Return point data
+const QList<QPointF> &SeriesData::points() const { return points_; }
+
+// Return bounds of the point data
+const SeriesData::Bounds &SeriesData::bounds() const { return bounds_; }
+
+// Recalculate bounds from the current point data
+void SeriesData::updateBounds()
+{
+    bounds_ = Bounds();
+    if (points_.isEmpty())
+        return;
+
+    // Single pass over the contiguous buffer for both axes
+    const auto *p = points_.constData();
+    auto xMin = p[0].x(), xMax = p[0].x(), yMin = p[0].y(), yMax = p[0].y();
+    for (auto n = 1; n < points_.size(); ++n)
+    {
+        const auto x = p[n].x(), y = p[n].y();
+        xMin = std::min(xMin, x);
+        xMax = std::max(xMax, x);
+        yMin = std::min(yMin, y);
+        yMax = std::max(yMax, y);
+    }
+
+    bounds_ = {xMin, xMax, yMin, yMax, true};
+}
+
+// Replace the points in the target series with our data
+void SeriesData::applyTo(QXYSeries *series) const
+{
+    series->setName(name_);
+    series->replace(points_);
+}
+
+/*
+ * Creation
+ */
+
+// Create series data from log times and values, against both absolute and relative time
+std::pair<SeriesData, SeriesData> SeriesData::fromLogValues(const QString &name, const QDateTime &startTime,
+                                                            const std::vector<double> &times,
+                                                            const std::vector<double> &values)
+{
+    const auto nPoints = std::min(times.size(), values.size());
+    QList<QPointF> datePoints, relativePoints;
+    datePoints.reserve(nPoints);
+    relativePoints.reserve(nPoints);
+
+    const auto startMSecs = startTime.toMSecsSinceEpoch();
+    for (size_t n = 0; n < nPoints; ++n)
+    {
+        datePoints.emplaceBack(startMSecs + times[n] * 1000.0, values[n]);
+        relativePoints.emplaceBack(times[n], values[n]);
+    }
+
+    return {SeriesData(name, std::move(datePoints)), SeriesData(name, std::move(relativePoints))};
+}
+
+// Return the combined bounds of the supplied series
+SeriesData::Bounds SeriesData::combinedBounds(const std::vector<SeriesData> &series)
+{
+    Bounds bounds;
+    for (const auto &data : series)
+        bounds.expand(data.bounds());
+    return bounds;
+}
+
+/*
+ * RunLogSeriesData
+ */
+
+// Return the sorted union of categories over all runs in a log value data response (empty for numeric logs)
+QStringList RunLogSeriesData::categories(const QJsonObject &logValueData)
+{
+    QStringList result;
+    for (const auto &run : logValueData)
+        for (const auto &category : run.toObject()["categories"].toArray())
+            result.append(category.toString());
+    result.removeDuplicates();
+    result.sort();
+    return result;
+}
+
+// Create from the per-run data object in a log value data response, mapping string values onto the categories
+std::vector<RunLogSeriesData> RunLogSeriesData::fromLogValueData(const QJsonObject &logValueData,
+                                                                 const QStringList &categories)
+{
+    std::vector<RunLogSeriesData> result;
+    result.reserve(logValueData.count());
+
+    for (const auto &run : logValueData)
+    {
+        const auto runObject = run.toObject();
+        const auto timeRange = runObject["timeRange"].toArray().first().toArray();
+        auto startTime = QDateTime::fromString(timeRange[0].toString(), "yyyy-MM-dd'T'HH:mm:ss");
+        auto endTime = QDateTime::fromString(timeRange[1].toString(), "yyyy-MM-dd'T'HH:mm:ss");
+
+        const auto times = decodeFloat64Array(runObject["time"]);
+        auto values = decodeFloat64Array(runObject["value"]);
+
+        // String values are indices into the run's own categories, so remap them onto the combined list
+        const auto runCategories = runObject["categories"].toArray();
+        if (!runCategories.isEmpty())
+        {
+            std::vector<double> indices;
+            indices.reserve(runCategories.count());
+            for (const auto &category : runCategories)
+                indices.push_back(categories.indexOf(category.toString()));
+            for (auto &value : values)
+            {
+                auto index = static_cast<qsizetype>(value);
+                value = index >= 0 && index < runCategories.count() ? indices[index] : -1.0;
+            }
+        }
+
+        auto [absolute, relative] =
+            SeriesData::fromLogValues(runObject["runNumber"].toString(), startTime, times, values);
+        result.push_back({startTime, endTime, std::move(absolute), std::move(relative)});
+    }
+
+    return result;
+}
+
+/*
+ * TofAxis
+ */
+
+// Create from bin edges
+std::shared_ptr<const TofAxis> TofAxis::fromEdges(const std::vector<double> &edges)
+{
+    auto axis = std::make_shared<TofAxis>();
+    if (edges.size() < 2)
+        return axis;
+
+    const auto nBins = edges.size() - 1;
+    axis->centres.resize(nBins);
+    axis->widths.resize(nBins);
+    for (size_t n = 0; n < nBins; ++n)
+    {
+        axis->centres[n] = 0.5 * (edges[n] + edges[n + 1]);
+        axis->widths[n] = edges[n + 1] - edges[n];
+    }
+
+    return axis;
+}
+
+/*
+ * SpectrumNormalisation
+ */
+
+bool SpectrumNormalisation::operator==(const SpectrumNormalisation &other) const
+{
+    return perMicrosecond == other.perMicrosecond && perProtonCharge == other.perProtonCharge &&
+           monitor == other.monitor && referenceRun == other.referenceRun;
+}
+
+bool SpectrumNormalisation::operator!=(const SpectrumNormalisation &other) const { return !(*this == other); }
+
+/*
+ * SpectrumData
+ */
+
+// Return series name
+const QString &SpectrumData::name() const { return name_; }
+
+// Return raw counts
+const std::vector<double> &SpectrumData::counts() const { return counts_; }
+
+// Return whether the divisors required by the normalisation are available
+bool SpectrumData::canNormalise(const SpectrumNormalisation &normalisation) const
+{
+    if (normalisation.perProtonCharge && protonCharge_ <= 0.0)
+        return false;
+    if (normalisation.monitor && monitors_.find(*normalisation.monitor) == monitors_.end())
+        return false;
+    if (normalisation.referenceRun && references_.find(*normalisation.referenceRun) == references_.end())
+        return false;
+    return true;
+}
+
+// Return series data of the normalised counts against bin centres (empty if the normalisation can't be applied)
+SeriesData SpectrumData::seriesData(const SpectrumNormalisation &normalisation) const
+{
+    const auto nPoints = axis_ ? std::min(counts_.size(), axis_->centres.size()) : 0;
+    if (nPoints == 0 || !canNormalise(normalisation))
+        return {name_};
+    const auto &x = axis_->centres;
+
+    // Combine the divisors with one simple pass over contiguous data for each, so that the loops can be vectorised
+    std::vector<double> divisor(nPoints, normalisation.perProtonCharge ? protonCharge_ : 1.0);
+    auto divideBy = [&divisor, nPoints](const std::vector<double> &values)
+    {
+        const auto n = std::min(nPoints, values.size());
+        for (size_t i = 0; i < n; ++i)
+            divisor[i] *= values[i];
+    };
+    if (normalisation.perMicrosecond)
+        divideBy(axis_->widths);
+    if (normalisation.monitor)
+        divideBy(monitors_.at(*normalisation.monitor));
+    if (normalisation.referenceRun)
+        divideBy(references_.at(*normalisation.referenceRun));
+
+    // Bins whose divisor is zero keep their raw counts
+    std::vector<double> y(nPoints);
+    for (size_t n = 0; n < nPoints; ++n)
+        y[n] = divisor[n] != 0.0 ? counts_[n] / divisor[n] : counts_[n];
+
+    // Assemble points and determine bounds in the same pass
+    QList<QPointF> points;
+    points.reserve(nPoints);
+    SeriesData::Bounds bounds{x[0], x[0], y[0], y[0], true};
+    for (size_t n = 0; n < nPoints; ++n)
+    {
+        points.emplaceBack(x[n], y[n]);
+        bounds.xMin = std::min(bounds.xMin, x[n]);
+        bounds.xMax = std::max(bounds.xMax, x[n]);
+        bounds.yMin = std::min(bounds.yMin, y[n]);
+        bounds.yMax = std::max(bounds.yMax, y[n]);
+    }
+
+    return {name_, std::move(points), bounds};
+}
+
+// Add any divisors from the supplied data which we don't already have
+void SpectrumData::addDivisors(const SpectrumData &other)
+{
+    if (protonCharge_ <= 0.0)
+        protonCharge_ = other.protonCharge_;
+    monitors_.insert(other.monitors_.begin(), other.monitors_.end());
+    references_.insert(other.references_.begin(), other.references_.end());
+}
+
+// Create from a spectrum response, in run order, decoding each distinct time-of-flight axis only once, and recording any
+// divisors under the monitor and reference run of the normalisation they were requested for
+std::vector<SpectrumData> SpectrumData::fromSpectrumResponse(const QJsonObject &response,
+                                                             const SpectrumNormalisation &requested)
+{
+    std::vector<std::shared_ptr<const TofAxis>> axes;
+    for (const auto &edges : response["axes"].toArray())
+        axes.push_back(TofAxis::fromEdges(decodeFloat64Array(edges)));
+
+    const auto spectra = response["spectra"].toArray();
+    std::vector<SpectrumData> result(spectra.count());
+    for (auto i = 0; i < spectra.count(); ++i)
+    {
+        const auto spectrum = spectra[i].toObject();
+        auto &data = result[i];
+        data.name_ = QString::number(spectrum["runNumber"].toInt());
+
+        // Runs which could not be read have no axis or counts
+        auto axisIndex = spectrum["axis"].toInt(-1);
+        if (axisIndex < 0 || axisIndex >= static_cast<int>(axes.size()))
+            continue;
+        data.axis_ = axes[axisIndex];
+        data.counts_ = decodeFloat64Array(spectrum["counts"]);
+
+        const auto divisors = spectrum["divisors"].toObject();
+        data.protonCharge_ = divisors["protonCharge"].toDouble();
+        if (requested.monitor && divisors.contains("monitor"))
+            data.monitors_[*requested.monitor] = decodeFloat64Array(divisors["monitor"]);
+        if (requested.referenceRun && divisors.contains("reference"))
+            data.references_[*requested.referenceRun] = decodeFloat64Array(divisors["reference"]);
+    }
+
+    return result;
+}
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Copyright (c) 2024 Team JournalViewer and contributors
+
+#pragma once
+
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QPointF>
+#include <QString>
+#include <QtConcurrent/QtConcurrent>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Forward Declarations
+class QXYSeries;
+
+// Decode a base64 string of little-endian float64 values, as sent by the backend for large arrays
+std::vector<double> decodeFloat64Array(const QJsonValue &value);
+
+// Contiguous point data and bounds for a single chart series
+class SeriesData
+{
+    public:
+    SeriesData(const QString &name = {}, QList<QPointF> points = {});
+
+    // Axis-aligned bounds of one or more series
+    struct Bounds
+    {
+        double xMin{0.0}, xMax{0.0}, yMin{0.0}, yMax{0.0};
+        bool valid{false};
+
+        // Expand to encompass the supplied bounds
+        void expand(const Bounds &other);
+    };
+    SeriesData(const QString &name, QList<QPointF> points, const Bounds &bounds);
+
+    private:
+    // Series name
+    QString name_;
+    // Point data
+    QList<QPointF> points_;
+    // Bounds of the point data
+    Bounds bounds_;
+
+    public:
+    // Return series name
+    const QString &name() const;
+    // Return point data
+    const QList<QPointF> &points() const;
+    // Return bounds of the point data
+    const Bounds &bounds() const;
+    // Recalculate bounds from the current point data
+    void updateBounds();
+    // Replace the points in the target series with our data
+    void applyTo(QXYSeries *series) const;
+
+    /*
+     * Creation
+     */
+    public:
+    // Create series data from log times and values, against both absolute and relative time
+    static std::pair<SeriesData, SeriesData> fromLogValues(const QString &name, const QDateTime &startTime,
+                                                           const std::vector<double> &times,
+                                                           const std::vector<double> &values);
+    // Return the combined bounds of the supplied series
+    static Bounds combinedBounds(const std::vector<SeriesData> &series);
+};
+
+// Time-of-flight axis, shared between all spectra with the same bin edges
+struct TofAxis
+{
+    // Bin centres and widths
+    std::vector<double> centres, widths;
+
+    // Create from bin edges
+    static std::shared_ptr<const TofAxis> fromEdges(const std::vector<double> &edges);
+};
+
+// Normalisation of a spectrum, as a chain of divisors
+struct SpectrumNormalisation
+{
+    // Whether to divide by the width of each bin (µs)
+    bool perMicrosecond{false};
+    // Whether to divide by the proton charge of the run (µAh)
+    bool perProtonCharge{false};
+    // Monitor of the same run to divide by, if any
+    std::optional<int> monitor;
+    // Run whose same spectrum to divide by, if any
+    std::optional<int> referenceRun;
+
+    bool operator==(const SpectrumNormalisation &other) const;
+    bool operator!=(const SpectrumNormalisation &other) const;
+};
+
+// Raw spectrum counts against a (possibly shared) time-of-flight axis, along with the divisors retrieved for them, so that
+// normalised series can always be calculated from the original counts
+class SpectrumData
+{
+    private:
+    // Series name
+    QString name_;
+    // Time-of-flight axis (null if the spectrum could not be retrieved)
+    std::shared_ptr<const TofAxis> axis_;
+    // Raw counts in each bin
+    std::vector<double> counts_;
+    // Proton charge of the run (µAh), or zero if not recorded
+    double protonCharge_{0.0};
+    // Counts of monitors and reference runs, on the same bins as our counts
+    std::map<int, std::vector<double>> monitors_, references_;
+
+    public:
+    // Return series name
+    const QString &name() const;
+    // Return raw counts
+    const std::vector<double> &counts() const;
+    // Return whether the divisors required by the normalisation are available
+    bool canNormalise(const SpectrumNormalisation &normalisation) const;
+    // Return series data of the normalised counts against bin centres (empty if the normalisation can't be applied)
+    SeriesData seriesData(const SpectrumNormalisation &normalisation = {}) const;
+    // Add any divisors from the supplied data which we don't already have
+    void addDivisors(const SpectrumData &other);
+
+    /*
+     * Creation
+     */
+    public:
+    // Create from a spectrum response, in run order, decoding each distinct time-of-flight axis only once, and recording
+    // any divisors under the monitor and reference run of the normalisation they were requested for
+    static std::vector<SpectrumData> fromSpectrumResponse(const QJsonObject &response,
+                                                          const SpectrumNormalisation &requested = {});
+};
+
+// Series data for log values from a single run, plotted against both absolute and relative time
+struct RunLogSeriesData
+{
+    QDateTime startTime, endTime;
+    SeriesData absolute, relative;
+
+    // Return the sorted union of categories over all runs in a log value data response (empty for numeric logs)
+    static QStringList categories(const QJsonObject &logValueData);
+    // Create from the per-run data object in a log value data response, mapping string values onto the categories
+    static std::vector<RunLogSeriesData> fromLogValueData(const QJsonObject &logValueData,
+                                                          const QStringList &categories = {});
+};
+
+// Run the supplied builder on a worker thread, passing its result to the handler in the context object's thread
+template <typename Builder, typename Handler> void buildSeriesData(QObject *context, Builder builder, Handler handler)
+{
+    QtConcurrent::run(builder).then(context, handler);
+}
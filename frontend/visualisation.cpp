@@ -2,8 +2,10 @@
 // Copyright (c) 2024 Team JournalViewer and contributors
 
 #include "chartView.h"
+#include "liveLogMonitor.h"
 #include "mainWindow.h"
 #include "seLogChooserDialog.h"
+#include "seriesData.h"
 #include <QCategoryAxis>
 #include <QChart>
 #include <QDateTimeAxis>
@@ -11,16 +13,13 @@
 #include <QMessageBox>
 #include <QValueAxis>
 
-// Handle extracted SE log values for plotting
-void MainWindow::handlePlotSELogValue(HttpRequestWorker *worker)
+namespace
+{
+// Create a tree of the log values extracted from run data, grouped by section
+GenericTreeItem *createSELogTree(const QJsonArray &logs)
 {
-    // Check for errors
-    if (handleRequestError(worker, "retrieving log values from run") != NoError)
-        return;
-
-    // Iterate over logs extracted from the target run data and construct our mapped values
     auto *rootItem = new GenericTreeItem({"Log Value", "Full Path"});
-    foreach (const auto &log, worker->jsonResponse().array())
+    foreach (const auto &log, logs)
     {
         auto logArray = log.toArray();
         if (logArray.size() < 2)
@@ -40,27 +39,49 @@ void MainWindow::handlePlotSELogValue(HttpRequestWorker *worker)
             sectionItem->appendChild({block.toString().split("/").last(), block.toString()});
     }
 
+    return rootItem;
+}
+} // namespace
+
+// Handle extracted SE log values for plotting
+void MainWindow::handlePlotSELogValue(HttpRequestWorker *worker)
+{
+    // Check for errors
+    if (handleRequestError(worker, "retrieving log values from run") != NoError)
+        return;
+
     // Create the dialog
-    SELogChooserDialog chooserDialog(this, rootItem);
+    SELogChooserDialog chooserDialog(this, createSELogTree(worker->jsonResponse().array()));
 
+    auto logValues = chooserDialog.getValues();
+    if (logValues.isEmpty())
+        return;
+
+    // Request the data for all selected log values together
+    backend_.getNexusLogValueData(currentJournalSource(), selectedRunNumbers(), logValues,
+                                  [=](HttpRequestWorker *worker) { handleCreateSELogPlot(worker); });
+}
+
+// Handle extracted SE log values for display of per-run statistics
+void MainWindow::handleChooseLogStatistics(HttpRequestWorker *worker)
+{
+    // Check for errors
+    if (handleRequestError(worker, "retrieving log values from run") != NoError)
+        return;
+
+    SELogChooserDialog chooserDialog(this, createSELogTree(worker->jsonResponse().array()));
     auto logValue = chooserDialog.getValue();
     if (logValue.isEmpty())
         return;
 
-    // Request the log value data
-    backend_.getNexusLogValueData(currentJournalSource(), selectedRunNumbers(), logValue,
-                                  [=](HttpRequestWorker *worker) { handleCreateSELogPlot(worker); });
+    logStatisticsPath_ = logValue;
+    updateLazyColumns();
+    startLogStatistics();
 }
 
 // Handle plotting of SE log data
 void MainWindow::handleCreateSELogPlot(HttpRequestWorker *worker)
 {
-    auto *window = new QWidget;
-    auto *dateTimeChart = new QChart();
-    auto *dateTimeChartView = new ChartView(dateTimeChart, window);
-    auto *relTimeChart = new QChart();
-    auto *relTimeChartView = new ChartView(relTimeChart, window);
-
     // Check network reply
     if (handleRequestError(worker, "trying to graph a log value") != NoError)
         return;
@@ -68,218 +89,202 @@ void MainWindow::handleCreateSELogPlot(HttpRequestWorker *worker)
     // The expected result from the backend is as follows:
     //
     // result = {
-    //              logValue: "name_of_log_value",
+    //              logValues: [ "log_value_1", ..., "log_value_M" ],
     //              runNumbers: { run1, run2, run3 ... runN }
-    //              data: {
-    //                  run1: {
-    //                      timeRange: [ datetime, datetime ],
-    //                      data: [ (x,y), (x2,y2), ..., (xn,yn) ]
+    //              logs: {
+    //                  log_value_1: {
+    //                      run1: {
+    //                          timeRange: [ datetime, datetime ],
+    //                          time: "base64 little-endian float64 [ x1, x2, ..., xn ]",
+    //                          value: "base64 little-endian float64 [ y1, y2, ..., yn ]",
+    //                          categories: [ "string1", ... ]   (string-valued logs only, values are indices)
+    //                      },
+    //                      ...
+    //                      runN: {
+    //                          ...
+    //                      }
     //                  },
     //                  ...
-    //                  runN: {
-    //                      ...
-    //                  }
-    //              }
+    //              },
+    //              errors: { runM: "error", ... }   (runs which could not be read, omitted from logs)
 
     const auto receivedData = worker->jsonResponse().object();
-    auto logValueName = receivedData["logValue"].toString().section('/', -1);
-    qDebug() << logValueName;
-
-    const auto logValueData = receivedData["data"].toObject();
-
-    auto *timeAxis = new QDateTimeAxis();
-    timeAxis->setFormat("yyyy-MM-dd<br>H:mm:ss");
-    dateTimeChart->addAxis(timeAxis, Qt::AlignBottom);
-
-    auto *dateTimeYAxis = new QValueAxis();
-    dateTimeYAxis->setRange(0, 0);
-
-    auto *dateTimeStringAxis = new QCategoryAxis();
-    QStringList categoryValues;
-
-    auto *relTimeXAxis = new QValueAxis();
-    relTimeXAxis->setTitleText("Relative Time (s)");
-    relTimeChart->addAxis(relTimeXAxis, Qt::AlignBottom);
-
-    auto *relTimeYAxis = new QValueAxis();
-
-    auto *relTimeStringAxis = new QCategoryAxis();
-
-    QList<QString> chartFields;
-    bool firstRun = true;
-    foreach (const auto &run, logValueData)
+    const auto logs = receivedData["logs"].toObject();
+    QStringList logValuePaths, logValueNames;
+    std::vector<QStringList> categoryValues;
+    for (const auto &logValue : receivedData["logValues"].toArray())
     {
-        // Get the data name (run number)
-        const auto dataName = run[QString("runNumber")].toString();
-        qDebug() << run[QString("runNumber")].toString();
-
-        // Extract the time range data
-        const auto timeRange = run[QString("timeRange")].toArray();
-
-        auto startTime = QDateTime::fromString(timeRange.first()[0].toString(), "yyyy-MM-dd'T'HH:mm:ss");
-        auto endTime = QDateTime::fromString(timeRange.first()[1].toString(), "yyyy-MM-dd'T'HH:mm:ss");
+        logValuePaths.append(logValue.toString());
+        logValueNames.append(logValue.toString().section('/', -1));
+        categoryValues.push_back(RunLogSeriesData::categories(logs[logValue.toString()].toObject()));
+    }
+    if (logValuePaths.isEmpty())
+        return;
+    const auto tabName = logValueNames.join(",");
+    reportRunErrors(receivedData["errors"].toObject(), "graphing " + tabName);
 
-        if (firstRun)
+    // Convert the run data into series data on a worker thread, then assemble the charts once complete
+    buildSeriesData(
+        this,
+        [logs, logValuePaths, categoryValues]()
         {
-            timeAxis->setRange(startTime, endTime);
-            relTimeXAxis->setRange(0, 0);
-        }
-
-        const auto fieldDataArray = run[QString("data")].toArray();
-
-        // foreach (const auto &fieldData, runFieldsArray)
-        // {
-        //     auto fieldDataArray = fieldData.toArray();
-        //     fieldDataArray.removeFirst();
-        //     if (!fieldDataArray.first()[1].isString())
-        //         break;
-        //     foreach (const auto &dataPair, fieldDataArray)
-        //     {
-        //         auto dataPairArray = dataPair.toArray();
-        //         categoryValues.append(dataPairArray[1].toString());
-        //     }
-        // }
-
-        if (!categoryValues.isEmpty())
+            std::vector<std::vector<RunLogSeriesData>> logSeries;
+            for (auto i = 0; i < logValuePaths.count(); ++i)
+                logSeries.push_back(RunLogSeriesData::fromLogValueData(logs[logValuePaths[i]].toObject(), categoryValues[i]));
+            return logSeries;
+        },
+        [=](std::vector<std::vector<RunLogSeriesData>> logSeries)
         {
-            categoryValues.removeDuplicates();
-            categoryValues.sort();
-        }
-        if (firstRun)
-        {
-            if (!categoryValues.isEmpty())
-            {
-                dateTimeChart->addAxis(dateTimeStringAxis, Qt::AlignLeft);
-                relTimeChart->addAxis(relTimeStringAxis, Qt::AlignLeft);
-            }
-            else
-            {
-                dateTimeChart->addAxis(dateTimeYAxis, Qt::AlignLeft);
-                relTimeChart->addAxis(relTimeYAxis, Qt::AlignLeft);
-            }
-            firstRun = false;
-        }
-
-        // For each plot point
-        auto *dateSeries = new QLineSeries();
-        auto *relSeries = new QLineSeries();
-
-        connect(dateSeries, &QLineSeries::hovered,
-                [=](const QPointF point, bool hovered) { dateTimeChartView->setHovered(point, hovered, dateSeries->name()); });
-        connect(dateTimeChartView, SIGNAL(showCoordinates(qreal, qreal, QString)), this,
-                SLOT(showStatus(qreal, qreal, QString)));
-        connect(dateTimeChartView, SIGNAL(clearCoordinates()), statusBar(), SLOT(clearMessage()));
-        connect(relSeries, &QLineSeries::hovered,
-                [=](const QPointF point, bool hovered) { relTimeChartView->setHovered(point, hovered, relSeries->name()); });
-        connect(relTimeChartView, SIGNAL(showCoordinates(qreal, qreal, QString)), this,
-                SLOT(showStatus(qreal, qreal, QString)));
-        connect(relTimeChartView, SIGNAL(clearCoordinates()), statusBar(), SLOT(clearMessage()));
-
-        // Set dateSeries ID
-        if (!chartFields.contains(logValueName))
-            chartFields.append(logValueName);
-        dateSeries->setName(dataName);
-        relSeries->setName(dataName);
-
-        if (fieldDataArray.first()[1].isString())
-        {
-            foreach (const auto &dataPair, fieldDataArray)
+            auto *window = new QWidget;
+            auto *dateTimeChart = new QChart();
+            auto *dateTimeChartView = new ChartView(dateTimeChart, window);
+            auto *relTimeChart = new QChart();
+            auto *relTimeChartView = new ChartView(relTimeChart, window);
+            for (auto *chartView : {dateTimeChartView, relTimeChartView})
             {
-                auto dataPairArray = dataPair.toArray();
-                dateSeries->append(startTime.addSecs(dataPairArray[0].toDouble()).toMSecsSinceEpoch(),
-                                   categoryValues.indexOf(dataPairArray[1].toString()));
-                relSeries->append(dataPairArray[0].toDouble(), categoryValues.indexOf(dataPairArray[1].toString()));
+                connect(chartView, SIGNAL(showCoordinates(qreal, qreal, QString)), this,
+                        SLOT(showStatus(qreal, qreal, QString)));
+                connect(chartView, SIGNAL(clearCoordinates()), statusBar(), SLOT(clearMessage()));
             }
-        }
-        else
-        {
-            foreach (const auto &dataPair, fieldDataArray)
-            {
-                auto dataPairArray = dataPair.toArray();
-                dateSeries->append(startTime.addSecs(dataPairArray[0].toDouble()).toMSecsSinceEpoch(),
-                                   dataPairArray[1].toDouble());
-                relSeries->append(dataPairArray[0].toDouble(), dataPairArray[1].toDouble());
-                if (dateTimeYAxis->min() == 0 && dateTimeYAxis->max() == 0)
-                    dateTimeYAxis->setRange(dataPairArray[1].toDouble(), dataPairArray[1].toDouble());
-                if (dataPairArray[1].toDouble() < dateTimeYAxis->min())
-                    dateTimeYAxis->setMin(dataPairArray[1].toDouble());
-                if (dataPairArray[1].toDouble() > dateTimeYAxis->max())
-                    dateTimeYAxis->setMax(dataPairArray[1].toDouble());
-            }
-        }
-        if (startTime.addSecs(startTime.secsTo(QDateTime::fromMSecsSinceEpoch(dateSeries->at(0).x()))) < timeAxis->min())
-            timeAxis->setMin(startTime.addSecs(startTime.secsTo(QDateTime::fromMSecsSinceEpoch(dateSeries->at(0).x()))));
-        if (endTime > timeAxis->max())
-            timeAxis->setMax(endTime);
-
-        if (relSeries->at(0).x() < relTimeXAxis->min())
-            relTimeXAxis->setMin(relSeries->at(0).x());
-        if (relSeries->at(relSeries->count() - 1).x() > relTimeXAxis->max())
-            relTimeXAxis->setMax(relSeries->at(relSeries->count() - 1).x());
-
-        dateTimeChart->addSeries(dateSeries);
-        dateSeries->attachAxis(timeAxis);
-        relTimeChart->addSeries(relSeries);
-        relSeries->attachAxis(relTimeXAxis);
-        if (categoryValues.isEmpty())
-        {
-            dateSeries->attachAxis(dateTimeYAxis);
-            relSeries->attachAxis(relTimeYAxis);
-        }
-        else
-        {
-            dateSeries->attachAxis(dateTimeStringAxis);
-            relSeries->attachAxis(relTimeStringAxis);
-        }
-    }
 
-    if (!categoryValues.isEmpty())
-    {
-        dateTimeStringAxis->setRange(0, categoryValues.count() - 1);
-        relTimeStringAxis->setRange(0, categoryValues.count() - 1);
-        for (auto i = 0; i < categoryValues.count(); i++)
-        {
-            dateTimeStringAxis->append(categoryValues[i], i);
-            relTimeStringAxis->append(categoryValues[i], i);
-        }
-        dateTimeStringAxis->setLabelsPosition(QCategoryAxis::AxisLabelsPositionOnValue);
-        relTimeStringAxis->setLabelsPosition(QCategoryAxis::AxisLabelsPositionOnValue);
-    }
+            auto *timeAxis = new QDateTimeAxis();
+            timeAxis->setFormat("yyyy-MM-dd<br>H:mm:ss");
+            dateTimeChart->addAxis(timeAxis, Qt::AlignBottom);
 
-    relTimeYAxis->setRange(dateTimeYAxis->min(), dateTimeYAxis->max());
+            auto *relTimeXAxis = new QValueAxis();
+            relTimeXAxis->setTitleText("Relative Time (s)");
+            relTimeChart->addAxis(relTimeXAxis, Qt::AlignBottom);
 
-    auto *gridLayout = new QGridLayout(window);
-    auto *axisToggleCheck = new QCheckBox("Plot relative to run start times", window);
-    connect(axisToggleCheck, SIGNAL(stateChanged(int)), this, SLOT(toggleAxis(int)));
+            // Runs may still be being written, so new samples can be appended to the series as they are recorded
+            const auto *source = currentJournalSource();
+            std::vector<LiveLogMonitor *> liveMonitors;
 
-    gridLayout->addWidget(dateTimeChartView, 1, 0, -1, -1);
-    gridLayout->addWidget(relTimeChartView, 1, 0, -1, -1);
-    relTimeChartView->hide();
-    gridLayout->addWidget(axisToggleCheck, 0, 0);
-    QString tabName;
-    for (auto i = 0; i < chartFields.size(); i++)
-    {
-        tabName += chartFields[i];
-        if (i < chartFields.size() - 1)
-            tabName += ",";
-    }
-    if (!categoryValues.isEmpty())
-    {
-        dateTimeStringAxis->setTitleText(tabName);
-        relTimeStringAxis->setTitleText(tabName);
-    }
-    else
-    {
-        dateTimeYAxis->setTitleText(tabName);
-        relTimeYAxis->setTitleText(tabName);
-    }
-    ui_.MainTabs->addTab(window, tabName);
-    QString runs;
-    for (auto series : dateTimeChart->series())
-        runs.append(series->name() + ", ");
-    runs.chop(2);
-    QString toolTip = tabName + "\n" + runs;
-    ui_.MainTabs->setTabToolTip(ui_.MainTabs->count() - 1, toolTip);
-    ui_.MainTabs->setCurrentIndex(ui_.MainTabs->count() - 1);
-    dateTimeChartView->setFocus();
+            bool firstRun = true;
+            for (size_t i = 0; i < logSeries.size(); ++i)
+            {
+                const auto &logValuePath = logValuePaths[i];
+                const auto &logValueName = logValueNames[i];
+                const auto &categories = categoryValues[i];
+
+                // Each log has its own vertical axis, alternating between the sides of the charts
+                const auto alignment = i % 2 == 0 ? Qt::AlignLeft : Qt::AlignRight;
+                QAbstractAxis *dateTimeYAxis, *relTimeYAxis;
+                if (!categories.isEmpty())
+                {
+                    auto *dateTimeStringAxis = new QCategoryAxis();
+                    auto *relTimeStringAxis = new QCategoryAxis();
+                    for (auto *stringAxis : {dateTimeStringAxis, relTimeStringAxis})
+                    {
+                        stringAxis->setRange(0, categories.count() - 1);
+                        for (auto n = 0; n < categories.count(); n++)
+                            stringAxis->append(categories[n], n);
+                        stringAxis->setLabelsPosition(QCategoryAxis::AxisLabelsPositionOnValue);
+                    }
+                    dateTimeYAxis = dateTimeStringAxis;
+                    relTimeYAxis = relTimeStringAxis;
+                }
+                else
+                {
+                    dateTimeYAxis = new QValueAxis();
+                    dateTimeYAxis->setRange(0, 0);
+                    relTimeYAxis = new QValueAxis();
+                    relTimeYAxis->setRange(0, 0);
+                }
+                dateTimeYAxis->setTitleText(logValueName);
+                relTimeYAxis->setTitleText(logValueName);
+                dateTimeChart->addAxis(dateTimeYAxis, alignment);
+                relTimeChart->addAxis(relTimeYAxis, alignment);
+
+                LiveLogMonitor *liveMonitor = nullptr;
+                if (categories.isEmpty())
+                {
+                    liveMonitor = new LiveLogMonitor(
+                        [=](int runNumber, int first, const HttpRequestWorker::HttpRequestHandler &handler)
+                        { backend_.getNexusLiveLogValueData(source, runNumber, logValuePath, first, handler); },
+                        dateTimeChartView, relTimeChartView, window);
+                    liveMonitors.push_back(liveMonitor);
+                }
+
+                SeriesData::Bounds yBounds;
+                for (const auto &run : logSeries[i])
+                {
+                    if (firstRun)
+                    {
+                        timeAxis->setRange(run.startTime, run.endTime);
+                        relTimeXAxis->setRange(0, 0);
+                        firstRun = false;
+                    }
+
+                    // Create the series and set their data in one operation
+                    auto *dateSeries = new QLineSeries();
+                    auto *relSeries = new QLineSeries();
+                    run.absolute.applyTo(dateSeries);
+                    run.relative.applyTo(relSeries);
+                    if (logSeries.size() > 1)
+                    {
+                        dateSeries->setName(run.absolute.name() + ": " + logValueName);
+                        relSeries->setName(run.relative.name() + ": " + logValueName);
+                    }
+                    if (liveMonitor)
+                        liveMonitor->addRun(run.relative.name().toInt(), run.startTime, run.relative.points().size(),
+                                            dateSeries, relSeries);
+
+                    // Update axis limits from the precalculated bounds
+                    const auto &relBounds = run.relative.bounds();
+                    if (relBounds.valid)
+                    {
+                        const auto &dateBounds = run.absolute.bounds();
+                        if (QDateTime::fromMSecsSinceEpoch(dateBounds.xMin) < timeAxis->min())
+                            timeAxis->setMin(QDateTime::fromMSecsSinceEpoch(dateBounds.xMin));
+                        if (run.endTime > timeAxis->max())
+                            timeAxis->setMax(run.endTime);
+
+                        if (relBounds.xMin < relTimeXAxis->min())
+                            relTimeXAxis->setMin(relBounds.xMin);
+                        if (relBounds.xMax > relTimeXAxis->max())
+                            relTimeXAxis->setMax(relBounds.xMax);
+
+                        if (categories.isEmpty())
+                            yBounds.expand(relBounds);
+                    }
+
+                    dateTimeChart->addSeries(dateSeries);
+                    dateSeries->attachAxis(timeAxis);
+                    dateSeries->attachAxis(dateTimeYAxis);
+                    relTimeChart->addSeries(relSeries);
+                    relSeries->attachAxis(relTimeXAxis);
+                    relSeries->attachAxis(relTimeYAxis);
+                }
+
+                if (yBounds.valid)
+                {
+                    dateTimeYAxis->setRange(yBounds.yMin, yBounds.yMax);
+                    relTimeYAxis->setRange(yBounds.yMin, yBounds.yMax);
+                }
+            }
+
+            auto *gridLayout = new QGridLayout(window);
+            auto *axisToggleCheck = new QCheckBox("Plot relative to run start times", window);
+            connect(axisToggleCheck, SIGNAL(stateChanged(int)), this, SLOT(toggleAxis(int)));
+            auto *liveCheck = new QCheckBox("Live updates", window);
+            liveCheck->setToolTip("Append samples recorded in runs which are still being written");
+            liveCheck->setEnabled(!liveMonitors.empty());
+            for (auto *liveMonitor : liveMonitors)
+                connect(liveCheck, &QCheckBox::toggled, liveMonitor, &LiveLogMonitor::setActive);
+
+            gridLayout->addWidget(dateTimeChartView, 1, 0, -1, -1);
+            gridLayout->addWidget(relTimeChartView, 1, 0, -1, -1);
+            relTimeChartView->hide();
+            gridLayout->addWidget(axisToggleCheck, 0, 0);
+            gridLayout->addWidget(liveCheck, 0, 1);
+            ui_.MainTabs->addTab(window, tabName);
+            QString runs;
+            for (auto series : dateTimeChart->series())
+                runs.append(series->name() + ", ");
+            runs.chop(2);
+            QString toolTip = tabName + "\n" + runs;
+            ui_.MainTabs->setTabToolTip(ui_.MainTabs->count() - 1, toolTip);
+            ui_.MainTabs->setCurrentIndex(ui_.MainTabs->count() - 1);
+            dateTimeChartView->setFocus();
+        });
 }